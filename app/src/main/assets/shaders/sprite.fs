@@ -1,11 +1,11 @@
 precision mediump float;
 // fragment shader for sprite rendering
 varying vec2 TexCoords;
+varying vec4 Tint;
 
 uniform sampler2D sprite;
-uniform vec3 spriteColor;
 
 void main()
 {
-    gl_FragColor = vec4(spriteColor, 1.0) * texture2D(sprite, TexCoords);
+    gl_FragColor = Tint * texture2D(sprite, TexCoords);
 }
\ No newline at end of file
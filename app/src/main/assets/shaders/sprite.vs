@@ -1,14 +1,16 @@
 
-// simple vertex shader for sprite rendering
-// var vec4 - <vec2 position, vec2 texCoords>
-attribute vec4 vertex;
+// sprite rendering from quads expanded on the CPU (ExpandSpriteQuads)
+attribute vec2 position;
+attribute vec2 texCoords;
+attribute vec4 tint;
 varying vec2 TexCoords;
+varying vec4 Tint;
 
-uniform mat4 model;
 uniform mat4 projection;
 
 void main()
 {
-    TexCoords = vertex.zw;
-    gl_Position = projection * model * vec4(vertex.xy, 0.0, 1.0);
+    TexCoords = texCoords;
+    Tint = tint;
+    gl_Position = projection * vec4(position, 0.0, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,14 @@
+#version 300 es
+precision mediump float;
+// fragment shader for instanced sprite rendering
+in vec2 TexCoords;
+in vec4 Tint;
+
+out vec4 color;
+
+uniform sampler2D sprite;
+
+void main()
+{
+    color = Tint * texture(sprite, TexCoords);
+}
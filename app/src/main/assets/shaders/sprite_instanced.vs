@@ -0,0 +1,26 @@
+#version 300 es
+// instanced sprite rendering: one unit quad, expanded per instance
+// corner - unit quad vertex, the rest is per instance data
+layout(location = 0) in vec2 corner;
+layout(location = 1) in vec4 positionSize;
+layout(location = 2) in vec4 uvRect;
+layout(location = 3) in float rotation;
+layout(location = 4) in vec4 tint;
+
+out vec2 TexCoords;
+out vec4 Tint;
+
+uniform mat4 projection;
+
+void main()
+{
+    // scale, rotate around the quad center, then move to the top left corner given by position
+    vec2 local = (corner - 0.5) * positionSize.zw;
+    float s = sin(rotation);
+    float c = cos(rotation);
+    vec2 world = vec2(local.x * c - local.y * s, local.x * s + local.y * c) + positionSize.xy + 0.5 * positionSize.zw;
+
+    TexCoords = mix(uvRect.xy, uvRect.zw, corner);
+    Tint = tint;
+    gl_Position = projection * vec4(world, 0.0, 1.0);
+}
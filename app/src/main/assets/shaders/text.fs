@@ -1,11 +1,13 @@
 precision mediump float;
-
+// signed distance field text, 0.5 is the glyph edge
 varying vec2 TexCoords;
+varying vec3 TextColor;
 
 uniform sampler2D text;
-uniform vec3 textColor;
+uniform float smoothing;
 
 void main()
 {
-    gl_FragColor = vec4(textColor, 1.0) * vec4(1.0, 1.0, 1.0, texture2D(text, TexCoords).r);
+    float distance = texture2D(text, TexCoords).r;
+    gl_FragColor = vec4(TextColor, smoothstep(0.5 - smoothing, 0.5 + smoothing, distance));
 }
\ No newline at end of file
@@ -1,11 +1,14 @@
 
 attribute vec4 vertex; // <vec2 pos, vec2 tex>
+attribute vec4 color;
 varying vec2 TexCoords;
+varying vec3 TextColor;
 
 uniform mat4 projection;
 
 void main()
 {
     TexCoords = vertex.zw;
+    TextColor = color.rgb;
     gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
 }
\ No newline at end of file
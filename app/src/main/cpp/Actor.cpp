@@ -10,7 +10,7 @@ namespace Actors {
     }
 
     Actor::~Actor() {
-        Log::debug("Destroying actor %d", mId);
+        Log_debug("Destroying actor %d", mId);
 
         assert(mComponents.empty());
     }
@@ -18,7 +18,7 @@ namespace Actors {
     bool Actor::Init(XmlElement* pData) {
 //        GCC_LOG("Actor", std::string("Initializing Actor ") + ToStr(mId));
         mType = pData->Attribute("Type");
-        Log::debug("Actor Type %s", mType.c_str());
+        Log_debug("Actor Type %s", mType.c_str());
 
         return true;
     }
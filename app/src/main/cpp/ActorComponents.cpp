@@ -1,5 +1,4 @@
 #include <glm/gtx/projection.hpp>
-#include <list>
 
 #include "ActorComponents.h"
 #include "GLState.h"
@@ -15,29 +14,27 @@ namespace Actors {
 
 
 namespace Actors {
-    Actors::RenderAnimationComponent::RenderAnimationComponent() : mAnimationTime{},
-                                                                   mTimeCollector{},
-                                                                   mFramesCount{}
+    Actors::RenderAnimationComponent::RenderAnimationComponent() : mCurrentFrame{},
+                                                                   mAnimationTime{},
+                                                                   mTimeCollector{}
     {}
 
     bool Actors::RenderAnimationComponent::VInit(Actors::XmlElement *pData)  {
         mAnimationTime = pData->FloatAttribute("AnimationTime");
-        Log::debug("Animation time %f", mAnimationTime);
+        Log_debug("Animation time %f", mAnimationTime);
         assert(mAnimationTime > 0.f);
 
-        std::list<std::string> texNames;
+        std::vector<std::string> texNames;
         std::string texNamesFromXml = pData->Attribute("Textures");
         ParseStringWithPunct(texNamesFromXml, texNames);
 
         assert(texNames.size() > 0);
+        mFrames.reserve(texNames.size());
         for(auto const & texName: texNames) {
-            Log::debug("Parsed name = %s", texName.c_str());
-            mTextures.push_back(ResourceManager::GetTexture(texName));
+            Log_debug("Parsed name = %s", texName.c_str());
+            mFrames.push_back(ResourceManager::FindTexture(texName));
         }
-
-        mItCurrentFrame = mTextures.begin();
-        assert(mTextures.size() == texNames.size());
-        mFramesCount = mTextures.size();
+        mCurrentFrame = 0;
 
         return true;
     }
@@ -45,9 +42,8 @@ namespace Actors {
     void RenderAnimationComponent::VUpdate(double deltaSec) {
         mTimeCollector += deltaSec;
         if(mTimeCollector > mAnimationTime) {
-            ++mItCurrentFrame;
             mTimeCollector = 0.f;
-            if(mItCurrentFrame == mTextures.end()) mItCurrentFrame = mTextures.begin();
+            if(++mCurrentFrame == mFrames.size()) mCurrentFrame = 0;
         }
     }
 
@@ -55,13 +51,13 @@ namespace Actors {
 
 
 
-    RenderComponent::RenderComponent() : mPtrTexture{nullptr}
+    RenderComponent::RenderComponent() : mTexture{}
     {}
 
     bool RenderComponent::VInit(XmlElement *pData) {
         assert(pData);
         std::string texName = pData->Attribute("Texture");
-        mPtrTexture = ResourceManager::GetTexture(texName);
+        mTexture = ResourceManager::FindTexture(texName);
 
         return true;
     }
@@ -83,7 +79,7 @@ namespace Actors {
     {}
 
     bool PhysicsComponent::VInit(XmlElement *pData) {
-        Log::debug("Init Physics component");
+        Log_debug("Init Physics component");
         assert(pData);
 
         std::string type = pData->Attribute("Type");
@@ -100,7 +96,7 @@ namespace Actors {
         GLfloat posX = scaleX == 0 || scaleMaxX == 0 ? 0.f : static_cast<GLfloat>(GLState::GetInstance().GetScreenWidth()) / scaleMaxX * scaleX;
         GLfloat posY = scaleY == 0 || scaleMaxX == 0 ? 0.f : static_cast<GLfloat>(GLState::GetInstance().GetScreenHeight()) / scaleMaxY * scaleY;
         mPosition = mStartPosition = {posX, posY};
-        Log::debug("Position: x = %f, y = %f", posX, posY);
+        Log_debug("Position: x = %f, y = %f", posX, posY);
 
         int32_t scaleSizeX = pData->IntAttribute("ScaleSizeX");
         int32_t scaleSizeY = pData->IntAttribute("ScaleSizeY");
@@ -111,7 +107,7 @@ namespace Actors {
         GLfloat sizeY = scaleSizeY == 0 || scaleMaxSizeY == 0 ? 0.f : static_cast<GLfloat>(GLState::GetInstance().GetScreenHeight()) / scaleMaxSizeY * scaleSizeY;
         mSize = {sizeX, sizeY};
 
-        Log::debug("Size X = %f, Y = %f", sizeX, sizeY);
+        Log_debug("Size X = %f, Y = %f", sizeX, sizeY);
 
         mVelocity.x = pData->FloatAttribute("VelocityX");
         mVelocity.y = pData->FloatAttribute("VelocityY");
@@ -120,8 +116,8 @@ namespace Actors {
 
         mPositionCenter = pData->BoolAttribute("PositionCenter");
 
-        Log::debug("Velocity = %f %f", mVelocity.x, mVelocity.y);
-        Log::debug("Acceleration = %f %f", mAcceleration.x, mAcceleration.y);
+        Log_debug("Velocity = %f %f", mVelocity.x, mVelocity.y);
+        Log_debug("Acceleration = %f %f", mAcceleration.x, mAcceleration.y);
 
         return true;
     }
@@ -132,18 +128,19 @@ namespace Actors {
         auto pWeakRenderAnimationComponent = mPtrOwner->GetComponent<Actors::RenderAnimationComponent>("RenderAnimationComponent");
         auto pStrongRenderAnimationComponent = Actors::MakeStrongPtr(pWeakRenderAnimationComponent);
 
-        std::shared_ptr<Texture> ptrTexture {nullptr};
+        TextureHandle texture {};
         if(pStrongRenderAnimationComponent) {
-            ptrTexture = pStrongRenderAnimationComponent->GetCurrentFrameTexture();
+            texture = pStrongRenderAnimationComponent->GetCurrentFrameTexture();
         }
         else {
             auto pWeakRenderComponent = mPtrOwner->GetComponent<Actors::RenderComponent>("RenderComponent");
             auto pStrongRenderComponent = Actors::MakeStrongPtr(pWeakRenderComponent);
 
             assert(pStrongRenderComponent);
-            ptrTexture = pStrongRenderComponent->GetTexture();
+            texture = pStrongRenderComponent->GetTexture();
         }
 
+        Texture const * ptrTexture = ResourceManager::GetTexture(texture);
         assert(ptrTexture);
 
         if(mSize.x > 0.f || mSize.y > 0.f) {
@@ -161,14 +158,14 @@ namespace Actors {
             mSize.y = ptrTexture->GetHeight();
         }
 
-        Log::debug("Final size %f %f", mSize.x, mSize.y);
+        Log_debug("Final size %f %f", mSize.x, mSize.y);
 
         if(!mPositionCenter) return;
 
         mPosition.x -= mSize.x / 2.f;
         mPosition.y -= mSize.y / 2.f;
 
-        Log::debug("Position center %f %f", mPosition.x, mPosition.y);
+        Log_debug("Position center %f %f", mPosition.x, mPosition.y);
 
     }
 
@@ -228,7 +225,7 @@ namespace Actors {
         auto min01 = projCircleCenter1 - radii;
         auto max01 = projCircleCenter1 + radii;
 
-//        Log::debug("min01 %f, edge1max %f ||| max01 %f, edge1min %f", min01, edge1max, max01, edge1min);
+//        Log_debug("min01 %f, edge1max %f ||| max01 %f, edge1min %f", min01, edge1max, max01, edge1min);
         if(min01 > edge1max || max01 < edge1min)
             return false;
 
@@ -236,7 +233,7 @@ namespace Actors {
         auto min03 = projCircleCenter3 - radii;
         auto max03 = projCircleCenter3 + radii;
 
-//        Log::debug("min03 %f, edge3max %f ||| max03 %f, edge3min %f", min03, edge3max, max03, edge3min);
+//        Log_debug("min03 %f, edge3max %f ||| max03 %f, edge3min %f", min03, edge3max, max03, edge3min);
         if(min03 > edge3max || max03 < edge3min)
             return false;
 
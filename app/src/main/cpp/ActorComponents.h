@@ -13,16 +13,15 @@ namespace Actors {
         RenderAnimationComponent();
 
         virtual ComponentId VGetId() const { return COMPONENT_ID; }
-        std::shared_ptr<Texture> const GetCurrentFrameTexture() const { return *mItCurrentFrame; }
+        TextureHandle GetCurrentFrameTexture() const { return mFrames[mCurrentFrame]; }
 
         virtual bool VInit(Actors::XmlElement * pData);
         virtual void VUpdate(double deltaSec);
 
     private:
-        std::vector<std::shared_ptr<Texture>> mTextures;
-        std::vector<std::shared_ptr<Texture>>::const_iterator mItCurrentFrame;
+        std::vector<TextureHandle> mFrames;
+        size_t mCurrentFrame;
         float mAnimationTime;
-        int32_t mFramesCount;
         float mTimeCollector;
 
         static ComponentId const COMPONENT_ID;
@@ -38,10 +37,10 @@ namespace Actors {
 
         virtual bool VInit(XmlElement * pData);
 
-        std::shared_ptr<Texture> const GetTexture() const { return mPtrTexture; }
+        TextureHandle GetTexture() const { return mTexture; }
 
     private:
-        std::shared_ptr<Texture> mPtrTexture;
+        TextureHandle mTexture;
 
         static ComponentId const COMPONENT_ID;
     };
@@ -52,7 +52,7 @@ namespace Actors {
         ResourceManager::Read(actorResource, xmlBuffer);
         auto result = actorXml.Parse(std::string(xmlBuffer.begin(), xmlBuffer.end()).c_str());
 
-        Log::debug("LOAD ACTOR %s", actorResource.c_str());
+        Log_debug("LOAD ACTOR %s", actorResource.c_str());
         if (result != XMLError::XML_SUCCESS) {
             assert(result == XMLError::XML_SUCCESS);
             return StrongActorPtr {};
@@ -80,7 +80,7 @@ namespace Actors {
                 pComponent->SetOwner(ptrActor);
             }
             else {
-                Log::debug("Can't create component");
+                Log_debug("Can't create component");
                 assert(pComponent);
                 return StrongActorPtr();
             }
@@ -88,13 +88,13 @@ namespace Actors {
 
         // Now that the actor has been fully created, run the post init phase
         ptrActor->PostInit();
-        Log::debug("LOAD ACTOR %s SUCCESS", actorResource.c_str());
+        Log_debug("LOAD ACTOR %s SUCCESS", actorResource.c_str());
         return ptrActor;
     }
 
     StrongActorComponentPtr ActorFactory::CreateComponent(XmlElement *pData) {
         std::string name(pData->Value());
-        Log::debug("LOAD COMPONENT %s", name.c_str());
+        Log_debug("LOAD COMPONENT %s", name.c_str());
 
         StrongActorComponentPtr pComponent {nullptr};
         auto findIt = mActorComponentCreators.find(name);
@@ -122,7 +122,7 @@ namespace Actors {
         // pComponent will be NULL if the component wasn’t found. This isn’t
         // necessarily an error since you might have a custom CreateComponent()
         // function in a subclass.
-        Log::debug("LOAD COMPONENT %s SUCCESS", name.c_str());
+        Log_debug("LOAD COMPONENT %s SUCCESS", name.c_str());
         return pComponent;
     }
 
@@ -7,6 +7,8 @@
 #include "FlappyEngine.h"
 #include "Log.h"
 #include "Events.h"
+#include "Profiler.h"
+#include "RenderThread.h"
 
 Android::Android() : mPtrAndroidApp {nullptr},
                      mAssetManager {nullptr},
@@ -54,6 +56,7 @@ void Android::Run() {
             if (mPtrAndroidApp->destroyRequested != 0) {
                 Log::debug("Finishing activity from main loop");
                 FlappyEngine::GetInstance().onDestroyWindow();
+                GLContextScope glContext;
                 GLState::GetInstance().Invalidate();
                 mFinishActivity = true;
                 ANativeActivity_finish(mPtrAndroidApp->activity);
@@ -62,7 +65,9 @@ void Android::Run() {
         }
 
         if (mHasFocus && !mFinishActivity) {
+            Profiler::GetInstance().BeginFrame();
             FlappyEngine::GetInstance().onStep();
+            Profiler::GetInstance().EndFrame();
         }
     }
 }
@@ -115,24 +120,30 @@ void Android::HandleState(int32_t cmd) {
         case APP_CMD_INIT_WINDOW:
             mRequestToUnloadResources = false;
             Log::debug("APP_CMD_INIT_WINDOW");
-        case APP_CMD_WINDOW_RESIZED:
+        case APP_CMD_WINDOW_RESIZED: {
             Log::debug("APP_CMD_WINDOW_RESIZED");
+            GLContextScope glContext;
             GLState::GetInstance().Resume();
             FlappyEngine::GetInstance().LoadResources();
             break;
+        }
 
-        case APP_CMD_TERM_WINDOW:
+        case APP_CMD_TERM_WINDOW: {
             Log::debug("APP_CMD_TERM_WINDOW");
             FlappyEngine::GetInstance().onDestroyWindow();
+            GLContextScope glContext;
             if(mRequestToUnloadResources) FlappyEngine::GetInstance().UnloadResources();
             GLState::GetInstance().Suspend();
             break;
+        }
 
-        case APP_CMD_DESTROY:
+        case APP_CMD_DESTROY: {
             Log::debug("APP_CMD_DESTROY");
             FlappyEngine::GetInstance().onDestroy();
+            GLContextScope glContext;
             GLState::GetInstance().Invalidate();
             break;
+        }
 
         case APP_CMD_GAINED_FOCUS:
             Log::debug("APP_CMD_GAINED_FOCUS");
@@ -191,6 +202,12 @@ int32_t Android::HandleInput(AInputEvent *inputEvent) {
     }
 
     if (AInputEvent_getType(inputEvent) == AINPUT_EVENT_TYPE_MOTION) {
+        int32_t action = AMotionEvent_getAction(inputEvent) & AMOTION_EVENT_ACTION_MASK;
+        if (action == AMOTION_EVENT_ACTION_POINTER_DOWN &&
+            AMotionEvent_getPointerCount(inputEvent) == PERF_HUD_TOGGLE_POINTERS) {
+            Events::EventManager::Get().QueueEvent(std::shared_ptr<Events::EventTogglePerfHud>(new Events::EventTogglePerfHud));
+        }
+
         TouchState tapState = mPtrTapDetector->Detect(inputEvent);
 
         if(tapState == GESTURE_STATE_ACTION) {
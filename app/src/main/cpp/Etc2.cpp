@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <cstring>
+
+#include "Etc2.h"
+#include "Ktx.h"
+
+namespace {
+
+// Intensity modifiers of the individual and differential modes, by table; a pixel's index picks +a, +b, -a or -b.
+int32_t const ETC_MODIFIERS[8][4] = {{2, 8, -2, -8},
+                                     {5, 17, -5, -17},
+                                     {9, 29, -9, -29},
+                                     {13, 42, -13, -42},
+                                     {18, 60, -18, -60},
+                                     {24, 80, -24, -80},
+                                     {33, 106, -33, -106},
+                                     {47, 183, -47, -183}};
+
+// Paint color distances of the T and H modes.
+int32_t const ETC_DISTANCES[8] = {3, 6, 11, 16, 23, 32, 41, 64};
+
+int32_t const EAC_MODIFIERS[16][8] = {{-3, -6, -9, -15, 2, 5, 8, 14},
+                                      {-3, -7, -10, -13, 2, 6, 9, 12},
+                                      {-2, -5, -8, -13, 1, 4, 7, 12},
+                                      {-2, -4, -6, -13, 1, 3, 5, 12},
+                                      {-3, -6, -8, -12, 2, 5, 7, 11},
+                                      {-3, -7, -9, -11, 2, 6, 8, 10},
+                                      {-4, -7, -8, -11, 3, 6, 7, 10},
+                                      {-3, -5, -8, -11, 2, 4, 7, 10},
+                                      {-2, -6, -8, -10, 1, 5, 7, 9},
+                                      {-2, -5, -8, -10, 1, 4, 7, 9},
+                                      {-2, -4, -8, -10, 1, 3, 7, 9},
+                                      {-2, -5, -7, -10, 1, 4, 6, 9},
+                                      {-3, -4, -7, -10, 2, 3, 6, 9},
+                                      {-1, -2, -3, -10, 0, 1, 2, 9},
+                                      {-4, -6, -8, -9, 3, 5, 7, 8},
+                                      {-3, -5, -7, -9, 2, 4, 6, 8}};
+
+// Blocks are big-endian 64-bit words.
+uint64_t ReadBlock(uint8_t const * ptrBlock) {
+    uint64_t bits {};
+    for (int32_t i = 0; i < 8; ++i)
+        bits = bits << 8 | ptrBlock[i];
+    return bits;
+}
+
+// Bits hi down to lo.
+int32_t Bits(uint64_t bits, int32_t hi, int32_t lo) {
+    return static_cast<int32_t>(bits >> lo & ((1ull << (hi - lo + 1)) - 1));
+}
+
+uint8_t Clamp(int32_t value) {
+    return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+}
+
+int32_t Extend4(int32_t value) { return value << 4 | value; }
+int32_t Extend5(int32_t value) { return value << 3 | value >> 2; }
+int32_t Extend6(int32_t value) { return value << 2 | value >> 4; }
+int32_t Extend7(int32_t value) { return value << 1 | value >> 6; }
+
+void SetRgb(uint8_t * ptrPixels, int32_t x, int32_t y, int32_t r, int32_t g, int32_t b) {
+    uint8_t * ptrPixel = ptrPixels + (y * 4 + x) * 4;
+    ptrPixel[0] = Clamp(r);
+    ptrPixel[1] = Clamp(g);
+    ptrPixel[2] = Clamp(b);
+}
+
+// Pixels are indexed down the columns: x * 4 + y, two bits each split over the low 32 bits of the block.
+int32_t PixelIndex(uint64_t bits, int32_t x, int32_t y) {
+    int32_t i = x * 4 + y;
+    return Bits(bits, 16 + i, 16 + i) << 1 | Bits(bits, i, i);
+}
+
+// The T and H modes paint each pixel with one of four colors.
+void DecodePaint(uint64_t bits, int32_t const (&paint)[4][3], uint8_t * ptrPixels) {
+    for (int32_t x = 0; x < 4; ++x) {
+        for (int32_t y = 0; y < 4; ++y) {
+            int32_t const * ptrColor = paint[PixelIndex(bits, x, y)];
+            SetRgb(ptrPixels, x, y, ptrColor[0], ptrColor[1], ptrColor[2]);
+        }
+    }
+}
+
+void DecodeT(uint64_t bits, uint8_t * ptrPixels) {
+    int32_t r1 = Extend4(Bits(bits, 60, 59) << 2 | Bits(bits, 57, 56));
+    int32_t g1 = Extend4(Bits(bits, 55, 52));
+    int32_t b1 = Extend4(Bits(bits, 51, 48));
+    int32_t r2 = Extend4(Bits(bits, 47, 44));
+    int32_t g2 = Extend4(Bits(bits, 43, 40));
+    int32_t b2 = Extend4(Bits(bits, 39, 36));
+    int32_t d = ETC_DISTANCES[Bits(bits, 35, 34) << 1 | Bits(bits, 32, 32)];
+
+    int32_t const paint[4][3] = {{r1, g1, b1},
+                                 {r2 + d, g2 + d, b2 + d},
+                                 {r2, g2, b2},
+                                 {r2 - d, g2 - d, b2 - d}};
+    DecodePaint(bits, paint, ptrPixels);
+}
+
+void DecodeH(uint64_t bits, uint8_t * ptrPixels) {
+    int32_t r1 = Bits(bits, 62, 59);
+    int32_t g1 = Bits(bits, 58, 56) << 1 | Bits(bits, 52, 52);
+    int32_t b1 = Bits(bits, 51, 51) << 3 | Bits(bits, 49, 47);
+    int32_t r2 = Bits(bits, 46, 43);
+    int32_t g2 = Bits(bits, 42, 39);
+    int32_t b2 = Bits(bits, 38, 35);
+
+    // The last bit of the distance index is the order of the two base colors.
+    int32_t order = (r1 << 8 | g1 << 4 | b1) >= (r2 << 8 | g2 << 4 | b2) ? 1 : 0;
+    int32_t d = ETC_DISTANCES[Bits(bits, 34, 34) << 2 | Bits(bits, 32, 32) << 1 | order];
+
+    r1 = Extend4(r1);
+    g1 = Extend4(g1);
+    b1 = Extend4(b1);
+    r2 = Extend4(r2);
+    g2 = Extend4(g2);
+    b2 = Extend4(b2);
+    int32_t const paint[4][3] = {{r1 + d, g1 + d, b1 + d},
+                                 {r1 - d, g1 - d, b1 - d},
+                                 {r2 + d, g2 + d, b2 + d},
+                                 {r2 - d, g2 - d, b2 - d}};
+    DecodePaint(bits, paint, ptrPixels);
+}
+
+// A gradient through the colors at the origin, at x = 4 and at y = 4.
+void DecodePlanar(uint64_t bits, uint8_t * ptrPixels) {
+    int32_t ro = Extend6(Bits(bits, 62, 57));
+    int32_t go = Extend7(Bits(bits, 56, 56) << 6 | Bits(bits, 54, 49));
+    int32_t bo = Extend6(Bits(bits, 48, 48) << 5 | Bits(bits, 44, 43) << 3 | Bits(bits, 41, 39));
+    int32_t rh = Extend6(Bits(bits, 38, 34) << 1 | Bits(bits, 32, 32));
+    int32_t gh = Extend7(Bits(bits, 31, 25));
+    int32_t bh = Extend6(Bits(bits, 24, 19));
+    int32_t rv = Extend6(Bits(bits, 18, 13));
+    int32_t gv = Extend7(Bits(bits, 12, 6));
+    int32_t bv = Extend6(Bits(bits, 5, 0));
+
+    for (int32_t y = 0; y < 4; ++y) {
+        for (int32_t x = 0; x < 4; ++x) {
+            SetRgb(ptrPixels,
+                   x,
+                   y,
+                   (x * (rh - ro) + y * (rv - ro) + 4 * ro + 2) >> 2,
+                   (x * (gh - go) + y * (gv - go) + 4 * go + 2) >> 2,
+                   (x * (bh - bo) + y * (bv - bo) + 4 * bo + 2) >> 2);
+        }
+    }
+}
+
+}
+
+void DecodeEtc2RgbBlock(uint8_t const * ptrBlock, uint8_t * ptrPixels) {
+    uint64_t bits = ReadBlock(ptrBlock);
+    int32_t base[2][3];
+
+    if (Bits(bits, 33, 33) == 0) {
+        // Individual: two 4-bit colors.
+        for (int32_t c = 0; c < 3; ++c) {
+            base[0][c] = Extend4(Bits(bits, 63 - c * 8, 60 - c * 8));
+            base[1][c] = Extend4(Bits(bits, 59 - c * 8, 56 - c * 8));
+        }
+    }
+    else {
+        // Differential: a 5-bit color and a signed 3-bit delta to the second. A delta that overflows a component marks
+        // one of the modes ETC2 added.
+        int32_t first[3];
+        int32_t second[3];
+        for (int32_t c = 0; c < 3; ++c) {
+            first[c] = Bits(bits, 63 - c * 8, 59 - c * 8);
+            int32_t delta = Bits(bits, 58 - c * 8, 56 - c * 8);
+            second[c] = first[c] + (delta >= 4 ? delta - 8 : delta);
+        }
+        if (second[0] < 0 || second[0] > 31)
+            return DecodeT(bits, ptrPixels);
+        if (second[1] < 0 || second[1] > 31)
+            return DecodeH(bits, ptrPixels);
+        if (second[2] < 0 || second[2] > 31)
+            return DecodePlanar(bits, ptrPixels);
+
+        for (int32_t c = 0; c < 3; ++c) {
+            base[0][c] = Extend5(first[c]);
+            base[1][c] = Extend5(second[c]);
+        }
+    }
+
+    // Two subblocks side by side, or one above the other when flipped, each with its own modifier table.
+    bool flip = Bits(bits, 32, 32) != 0;
+    int32_t const tables[2] = {Bits(bits, 39, 37), Bits(bits, 36, 34)};
+    for (int32_t x = 0; x < 4; ++x) {
+        for (int32_t y = 0; y < 4; ++y) {
+            int32_t subblock = flip ? y / 2 : x / 2;
+            int32_t modifier = ETC_MODIFIERS[tables[subblock]][PixelIndex(bits, x, y)];
+            int32_t const * ptrBase = base[subblock];
+            SetRgb(ptrPixels, x, y, ptrBase[0] + modifier, ptrBase[1] + modifier, ptrBase[2] + modifier);
+        }
+    }
+}
+
+void DecodeEacAlphaBlock(uint8_t const * ptrBlock, uint8_t * ptrPixels) {
+    uint64_t bits = ReadBlock(ptrBlock);
+    int32_t base = Bits(bits, 63, 56);
+    int32_t multiplier = Bits(bits, 55, 52);
+    int32_t const * ptrModifiers = EAC_MODIFIERS[Bits(bits, 51, 48)];
+
+    // Three bits per pixel down the columns, the first pixel highest.
+    for (int32_t x = 0; x < 4; ++x) {
+        for (int32_t y = 0; y < 4; ++y) {
+            int32_t i = x * 4 + y;
+            int32_t index = Bits(bits, 47 - i * 3, 45 - i * 3);
+            ptrPixels[(y * 4 + x) * 4 + 3] = Clamp(base + ptrModifiers[index] * multiplier);
+        }
+    }
+}
+
+bool DecodeEtc2(uint32_t internalFormat,
+                uint8_t const * ptrBlocks,
+                size_t size,
+                int32_t width,
+                int32_t height,
+                std::vector<uint8_t> & rgba)
+{
+    if (!IsEtc2(internalFormat) || size < CompressedLevelSize(internalFormat, width, height))
+        return false;
+
+    bool alpha = internalFormat == KTX_ETC2_RGBA8_EAC;
+    size_t blockSize = alpha ? 16 : 8;
+    rgba.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
+
+    uint8_t block[16 * 4];
+    for (int32_t blockY = 0; blockY < height; blockY += 4) {
+        for (int32_t blockX = 0; blockX < width; blockX += 4) {
+            std::memset(block, 255, sizeof(block));
+            if (alpha) {
+                DecodeEacAlphaBlock(ptrBlocks, block);
+                DecodeEtc2RgbBlock(ptrBlocks + 8, block);
+            }
+            else {
+                DecodeEtc2RgbBlock(ptrBlocks, block);
+            }
+            ptrBlocks += blockSize;
+
+            // Edge blocks cover pixels past the level's size, those are dropped.
+            int32_t rows = std::min(4, height - blockY);
+            int32_t columns = std::min(4, width - blockX);
+            for (int32_t y = 0; y < rows; ++y) {
+                std::memcpy(&rgba[(static_cast<size_t>(blockY + y) * width + blockX) * 4],
+                            block + y * 16,
+                            static_cast<size_t>(columns) * 4);
+            }
+        }
+    }
+    return true;
+}
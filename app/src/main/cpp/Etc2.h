@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Decodes one level of ETC2 RGB8 or RGBA8 EAC blocks (KTX_ETC2_RGB8, KTX_ETC2_RGBA8_EAC) to RGBA8 pixels, width *
+// height * 4 bytes. Every mode of the format is handled, so it stands in for the GPU where ETC2 isn't supported and
+// checks the converter's output on a host. False if the format isn't ETC2 or blocks is too short.
+bool DecodeEtc2(uint32_t internalFormat,
+                uint8_t const * ptrBlocks,
+                size_t size,
+                int32_t width,
+                int32_t height,
+                std::vector<uint8_t> & rgba);
+
+// One block each: 16 pixels in rows of 4, RGBA8.
+void DecodeEtc2RgbBlock(uint8_t const * ptrBlock, uint8_t * ptrPixels);
+void DecodeEacAlphaBlock(uint8_t const * ptrBlock, uint8_t * ptrPixels);
@@ -2,6 +2,7 @@
 #include "Log.h"
 #include "Utilities.h"
 #include "TimeManager.h"
+#include "Profiler.h"
 
 #include <cassert>
 
@@ -12,18 +13,18 @@ namespace Events {
 //---------------------------------------------------------------------------------------------------------------------
     bool EventManager::AddListener(const EventListenerDelegate &eventDelegate,
                                    const EventType &type) {
-        Log::debug("Events Attempting to add delegate function for event type: %s", to_string(type).c_str());
+        Log_debug("Events Attempting to add delegate function for event type: %s", to_string(type).c_str());
 
         EventListenerList& eventListenerList = mEventListeners[type];  // this will find or create the entry
         for (auto const & eventListener : eventListenerList) {
             if (eventDelegate.target_type() == eventListener.target_type()) {
-                Log::debug("Attempting to double-register a delegate");
+                Log_debug("Attempting to double-register a delegate");
                 return false;
             }
         }
 
         eventListenerList.push_back(eventDelegate);
-        Log::debug("Events Successfully added delegate for event type: %s ", to_string(type).c_str());
+        Log_debug("Events Successfully added delegate for event type: %s ", to_string(type).c_str());
 
         return true;
     }
@@ -34,7 +35,7 @@ namespace Events {
 //---------------------------------------------------------------------------------------------------------------------
     bool EventManager::RemoveListener(const EventListenerDelegate &eventDelegate,
                                       const EventType &type) {
-        Log::debug("Events Attempting to remove delegate function from event type: %s ", to_string(type).c_str());
+        Log_debug("Events Attempting to remove delegate function from event type: %s ", to_string(type).c_str());
         bool success = false;
 
         auto findIt = mEventListeners.find(type);
@@ -43,7 +44,7 @@ namespace Events {
             for (auto it = listeners.begin(); it != listeners.end(); ++it) {
                 if (eventDelegate.target_type() == (*it).target_type()) {
                     listeners.erase(it);
-                    Log::debug("Events Successfully removed delegate function from event type: %s ", to_string(type).c_str());
+                    Log_debug("Events Successfully removed delegate function from event type: %s ", to_string(type).c_str());
                     success = true;
                     break;  // we don't need to continue because it should be impossible for the same delegate function to be registered for the same event more than once
                 }
@@ -58,7 +59,7 @@ namespace Events {
 // EventManager::VTrigger
 //---------------------------------------------------------------------------------------------------------------------
     bool EventManager::TriggerEvent(const IEventDataPtr &pEvent) const {
-        Log::debug("Events Attempting to trigger event %s ", pEvent->GetName());
+        Log_debug("Events Attempting to trigger event %s ", pEvent->GetName());
         bool processed = false;
 
         auto findIt = mEventListeners.find(pEvent->VGetEventType());
@@ -66,7 +67,7 @@ namespace Events {
             const EventListenerList& eventListenerList = findIt->second;
             for (EventListenerList::const_iterator it = eventListenerList.begin(); it != eventListenerList.end(); ++it) {
                 EventListenerDelegate listener = (*it);
-                Log::debug("Events Sending Event %s ", pEvent->GetName(), "to delegate.");
+                Log_debug("Events Sending Event %s ", pEvent->GetName(), "to delegate.");
                 listener(pEvent);  // call the delegate
                 processed = true;
             }
@@ -90,12 +91,12 @@ namespace Events {
             return false;
         }
 
-        Log::debug("Events Attempting to queue event: %s ", pEvent->GetName());
+        Log_debug("Events Attempting to queue event: %s ", pEvent->GetName());
 
         auto findIt = mEventListeners.find(pEvent->VGetEventType());
         if (findIt != mEventListeners.end()) {
             mQueues[mActiveQueue].push_back(pEvent);
-            Log::debug("Events Successfully queued event: %s", pEvent->GetName());
+            Log_debug("Events Successfully queued event: %s", pEvent->GetName());
             return true;
         }
         else {
@@ -143,6 +144,7 @@ namespace Events {
 // EventManager::VTick
 //---------------------------------------------------------------------------------------------------------------------
     bool EventManager::Update(float maxSecs, bool processMaxEvents) {
+        PROFILE_SCOPE("EventManager::Update");
         float currSec = static_cast<float>(TimeManager::GetInstance().GetTimeNow());
         float maxSec =  currSec + maxSecs;
 
@@ -152,7 +154,7 @@ namespace Events {
         mQueues[mActiveQueue].clear();
 
         if(!mQueues[queueToProcess].empty()) {
-            Log::debug("EventLoop Processing Event Queue %s ; %s events to process",
+            Log_debug("EventLoop Processing Event Queue %s ; %s events to process",
                        to_string(queueToProcess).c_str(),
                        to_string(mQueues[queueToProcess].size()).c_str());
         }
@@ -162,7 +164,7 @@ namespace Events {
             // pop the front of the queue
             IEventDataPtr pEvent = mQueues[queueToProcess].front();
             mQueues[queueToProcess].pop_front();
-            Log::debug("EventLoop Processing Event %s ", pEvent->GetName());
+            Log_trace("EventLoop Processing Event %s", pEvent->GetName());
 
             const EventType & eventType = pEvent->VGetEventType();
 
@@ -170,12 +172,12 @@ namespace Events {
             auto findIt = mEventListeners.find(eventType);
             if (findIt != mEventListeners.end()) {
                 const EventListenerList& eventListeners = findIt->second;
-                Log::debug("EventLoopnFound %s ", to_string(eventListeners.size()).c_str(), " delegates");
+                Log_debug("EventLoopnFound %s ", to_string(eventListeners.size()).c_str(), " delegates");
 
                 // call each listener
                 for (auto it = eventListeners.begin(); it != eventListeners.end(); ++it) {
                     EventListenerDelegate listener = (*it);
-                    Log::debug("EventLoop Sending event %s ", pEvent->GetName(), " to delegate");
+                    Log_debug("EventLoop Sending event %s ", pEvent->GetName(), " to delegate");
                     listener(pEvent);
                 }
             }
@@ -183,7 +185,7 @@ namespace Events {
             // check to see if time ran out
             currSec = static_cast<float>(TimeManager::GetInstance().GetTimeNow());
             if (processMaxEvents && currSec >= maxSec) {
-                Log::debug("EventLoop Aborting event processing; time ran out");
+                Log_debug("EventLoop Aborting event processing; time ran out");
                 break;
             }
         }
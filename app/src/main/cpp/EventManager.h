@@ -109,6 +109,9 @@ namespace Events {
         // returns true if all messages ready for processing were completed, false otherwise (e.g. timeout )
         bool Update(float maxMillis, bool processMaxEvents);
 
+        // Number of events waiting for the next Update().
+        size_t GetQueuedEventCount() const { return mQueues[mActiveQueue].size(); }
+
         // Getter for the main global event manager.  This is the event manager that is used by the majority of the
         // engine, though you are free to define your own as long as you instantiate it with setAsGlobal set to false.
         // It is not valid to have more than one global event manager.
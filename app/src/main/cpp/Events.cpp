@@ -7,6 +7,7 @@ namespace Events {
     EventType const EventUnloadResources::sEventType(0x8d3dbd7a);
     EventType const EventChangeGameState::sEventType(0x9a45779a);
     EventType const EventInputXY::sEventType(0x8e2850f8);
+    EventType const EventTogglePerfHud::sEventType(0x5c0e93a1);
     EventType const EventUpdateScore::sEventType(0x00f44db5);
     EventType const EventFinalScore::sEventType(0xffeb15d9);
 
@@ -60,36 +60,48 @@ namespace Events {
         glm::vec2 mInputXY = {};
     };
 
+    class EventTogglePerfHud : public BaseEventData {
+    public:
+        static const EventType sEventType;
+
+        EventTogglePerfHud() = default;
+        virtual const EventType &VGetEventType(void) const { return sEventType; }
+        virtual IEventDataPtr VCopy(void) const { return IEventDataPtr(new EventTogglePerfHud()); }
+        virtual const char *GetName(void) const { return "EventTogglePerfHud"; }
+    };
+
     class EventUpdateScore : public BaseEventData {
     public:
         static const EventType sEventType;
 
-        EventUpdateScore(std::string const & newScore) : mScore{newScore}
+        EventUpdateScore(uint64_t newScore) : mScore{newScore}
         {}
-        std::string const & GetScore() const { return mScore; }
+        uint64_t GetScore() const { return mScore; }
+        void SetScore(uint64_t newScore) { mScore = newScore; }
 
         virtual const EventType &VGetEventType(void) const { return sEventType; }
         virtual IEventDataPtr VCopy(void) const { return IEventDataPtr(new EventUpdateScore(mScore)); }
         virtual const char *GetName(void) const { return "EventUpdateScore"; }
 
     private:
-        std::string mScore;
+        uint64_t mScore;
     };
 
     class EventFinalScore : public BaseEventData {
     public:
         static const EventType sEventType;
 
-        EventFinalScore(std::string const & newScore) : mScore{newScore}
+        EventFinalScore(uint64_t newScore) : mScore{newScore}
         {}
-        std::string const & GetScore() const { return mScore; }
+        uint64_t GetScore() const { return mScore; }
+        void SetScore(uint64_t newScore) { mScore = newScore; }
 
         virtual const EventType &VGetEventType(void) const { return sEventType; }
         virtual IEventDataPtr VCopy(void) const { return IEventDataPtr(new EventFinalScore(mScore)); }
         virtual const char *GetName(void) const { return "EventFinalScore"; }
 
     private:
-        std::string mScore;
+        uint64_t mScore;
     };
 //    class EventBackKeyPressed : public BaseEventData {
 //    public:
@@ -6,14 +6,20 @@
 #include "Events.h"
 #include "Utilities.h"
 #include "ResourceManager.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
+#include "IdleScheduler.h"
+#include "JobSystem.h"
+#include "RenderThread.h"
+#include "StreamBuffer.h"
 
 GameState FlappyEngine::sGameState = GameState::START;
 
 FlappyEngine::FlappyEngine() : mPtrGameScene {nullptr},
                                mPtrPauseScene {nullptr},
+                               mPtrPerfHud {new PerfHud},
                                mInitializedResource {false},
-                               mTimeAccumulator {0.f},
-                               mCurrentFPS {0.f}
+                               mLowMemoryPending {false}
 {
     Events::EventListenerDelegate delegate;
     delegate = std::bind(&FlappyEngine::LoadResourcesDelegate, this, std::placeholders::_1);;
@@ -27,6 +33,8 @@ FlappyEngine::FlappyEngine() : mPtrGameScene {nullptr},
 void FlappyEngine::LoadResources() {
 
     if(!mInitializedResource) {
+        GLContextScope glContext;
+        StreamBuffer::GetInstance().Init();
         ResourceManager::LoadTexture("textures/bird1.png", GL_TRUE, "bird1");
         ResourceManager::LoadTexture("textures/bird2.png", GL_TRUE, "bird2");
         ResourceManager::LoadTexture("textures/bird3.png", GL_TRUE, "bird3");
@@ -34,6 +42,8 @@ void FlappyEngine::LoadResources() {
         ResourceManager::LoadTexture("textures/column.png", GL_TRUE, "column");
         ResourceManager::LoadShader("shaders/text.vs", "shaders/text.fs", "text_shader");
         ResourceManager::LoadShader("shaders/sprite.vs", "shaders/sprite.fs", "sprite_shader");
+        if (GLState::GetInstance().GetGLESVersion() >= 3)
+            ResourceManager::LoadShader("shaders/sprite_instanced.vs", "shaders/sprite_instanced.fs", "sprite_instanced_shader");
 
         ResourceManager::LoadUiStrings("xmlSettings/ui.xml");
 
@@ -45,15 +55,26 @@ void FlappyEngine::LoadResources() {
         mPtrUi.reset(new Ui);
         mPtrUi->LoadResources("xmlSettings/ui.xml");
 
+        GpuProfiler::GetInstance().Init();
+
         mInitializedResource = true;
     }
+    else if(mLowMemoryPending) {
+        GLContextScope glContext;
+        if(glContext.HasContext())
+            ReleaseUnusedTextures();
+    }
 }
 
 
 void FlappyEngine::UnloadResources() {
 
     if(mInitializedResource) {
+        GLContextScope glContext;
+        GpuProfiler::GetInstance().Release();
+        mPtrPerfHud->UnloadResources();
         ResourceManager::Free();
+        StreamBuffer::GetInstance().Release();
 
         mPtrGameScene.reset(nullptr);
         mPtrPauseScene.reset(nullptr);
@@ -63,6 +84,7 @@ void FlappyEngine::UnloadResources() {
         mPtrUi.reset(nullptr);
 
         mInitializedResource = false;
+        mLowMemoryPending = false;
     }
 }
 
@@ -77,8 +99,19 @@ FlappyEngine::~FlappyEngine() {
 }
 
 void FlappyEngine::Run() {
+    Profiler::GetInstance().SetThreadName("Main");
+#ifdef FLAPPY_PROFILE_CAPTURE_FRAMES
+    Profiler::GetInstance().RequestCapture(FLAPPY_PROFILE_CAPTURE_FIRST,
+                                           FLAPPY_PROFILE_CAPTURE_FRAMES,
+                                           std::string(Android::GetInstance().GetAndroidApp()->activity->internalDataPath) +
+                                           "/profile.json");
+#endif
+    JobSystem::GetInstance().Init();
+    RenderThread::GetInstance().Start();
     TimeManager::GetInstance().UpdateMainLoop();
     Android::GetInstance().Run();
+    RenderThread::GetInstance().Stop();
+    JobSystem::GetInstance().Shutdown();
 }
 
 
@@ -91,10 +124,17 @@ void FlappyEngine::onDeactivate() {
 }
 
 bool FlappyEngine::onStep() {
+    PROFILE_SCOPE("FlappyEngine::onStep");
+
     TimeManager::GetInstance().UpdateMainLoop();
-    glClearColor(0.f, 0.4f, 0.f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
+    mPtrPerfHud->Update(TimeManager::GetInstance().RawFrameTime());
+
+    // Blocks only while the render thread is a full frame behind.
+    RenderPacket & packet = RenderThread::GetInstance().AcquirePacket();
+    packet.SetClearColor({0.f, 0.4f, 0.f, 1.0f});
+    ResourceManager::BeginFrame(sGameState);
 
+    uint64_t sceneDrawNs {};
     switch (sGameState) {
         case GameState::START : {
             if(Android::GetInstance().UpdateInput()) {
@@ -104,11 +144,17 @@ bool FlappyEngine::onStep() {
         }
 
         case GameState::ACTIVE: {
+            PROFILE_SCOPE("GameState::ACTIVE");
             mPtrGameScene->InputTap(Android::GetInstance().UpdateInput());
+            uint64_t updateStart = TimeManager::GetTimeNowNs();
             mPtrGameScene->Update(TimeManager::GetInstance().FrameTime());
-            mPtrGameScene->Draw();
+            uint64_t updateNs = TimeManager::GetTimeNowNs() - updateStart;
+            TimeManager::GetInstance().RecordPhase(FramePhase::UPDATE, updateNs);
+            mPtrPerfHud->SetSimulationTime(updateNs);
 
-//            DrawFPSWithTargetFrequency(static_cast<float>(TimeManager::GetInstance().FrameTime()), 0.2f);
+            uint64_t drawStart = TimeManager::GetTimeNowNs();
+            mPtrGameScene->Draw(packet);
+            sceneDrawNs = TimeManager::GetTimeNowNs() - drawStart;
             break;
         }
 
@@ -128,29 +174,16 @@ bool FlappyEngine::onStep() {
         }
     }
 
-    mPtrUi->Draw();
+    uint64_t uiDrawStart = TimeManager::GetTimeNowNs();
+    mPtrUi->Draw(packet);
+    TimeManager::GetInstance().RecordPhase(FramePhase::DRAW, sceneDrawNs + TimeManager::GetTimeNowNs() - uiDrawStart);
+    mPtrPerfHud->Draw(packet);
 
-    GLState::GetInstance().Swap();
+    TimeManager::GetInstance().MarkFrameSubmitted();
+    RenderThread::GetInstance().SubmitPacket();
     return true;
 }
 
-void FlappyEngine::DrawFPSWithTargetFrequency(float deltaSec, float secBetweenUpdate) {
-    mTimeAccumulator += deltaSec;
-    if(mTimeAccumulator >= secBetweenUpdate ) {
-        mCurrentFPS = static_cast<int32_t>(TimeManager::GetInstance().FramesPerSecond());
-        mTimeAccumulator = 0.f;
-    }
-
-    DrawFPS(to_string(mCurrentFPS));
-}
-
-void FlappyEngine::DrawFPS(std::string fps) {
-//    mPtrTextDefaultRenderer->RenderText(fps,
-//                                        {20.f,20.f},
-//                                        {40.f,40.f},
-//                                 glm::vec3(0.2f, 0.2f, 0.8f));
-}
-
 void FlappyEngine::onStart() {
 }
 void FlappyEngine::onResume() {
@@ -169,6 +202,35 @@ void FlappyEngine::onSaveInstanceState(void **pData, size_t *pSize) {
 void FlappyEngine::onConfigurationChanged() {
 }
 void FlappyEngine::onLowMemory() {
+    if(!mInitializedResource)
+        return;
+
+    // Usually comes in the background, after APP_CMD_TERM_WINDOW took the surface and with it any way to make the
+    // context current. Deleting textures then does nothing, so the release waits for the window to come back.
+    GLContextScope glContext;
+    if(!glContext.HasContext()) {
+        Log::info("onLowMemory : no GL context, releasing textures once the window is back");
+        mLowMemoryPending = true;
+        return;
+    }
+    ReleaseUnusedTextures();
+}
+
+void FlappyEngine::ReleaseUnusedTextures() {
+    // Only ACTIVE draws the scene, so elsewhere its sprites go; whatever is released loads again when next drawn.
+    mLowMemoryPending = false;
+    size_t releasedBytes = ResourceManager::ReleaseTextures(sGameState);
+    MemoryReport report = ResourceManager::GetMemoryReport();
+    Log::info("onLowMemory : released %zu KB of textures, %zu of %zu resident in %zu KB (budget %zu KB), "
+              "%zu fonts in %zu KB of atlas and %zu KB of font files",
+              releasedBytes / 1024,
+              report.residentTextureCount,
+              report.textureCount,
+              report.residentTextureBytes / 1024,
+              report.textureBudgetBytes / 1024,
+              report.fontCount,
+              report.fontAtlasBytes / 1024,
+              report.fontFileBytes / 1024);
 }
 void FlappyEngine::onCreateWindow() {
 }
@@ -178,6 +240,8 @@ void FlappyEngine::onDestroyWindow() {
 void FlappyEngine::onGainFocus() {
 }
 void FlappyEngine::onLostFocus() {
+    IdleScheduler::GetInstance().Flush();
+    TimeManager::GetInstance().DumpFrameStats();
 }
 
 
@@ -9,6 +9,12 @@
 #include "EventManager.h"
 #include "GameTypes.h"
 #include "Ui.h"
+#include "PerfHud.h"
+
+// Define FLAPPY_PROFILE_CAPTURE_FRAMES to write a Chrome trace of that many frames to the app data directory.
+#ifndef FLAPPY_PROFILE_CAPTURE_FIRST
+#define FLAPPY_PROFILE_CAPTURE_FIRST 120
+#endif
 
 class FlappyEngine
 {
@@ -54,14 +60,12 @@ public:
     void onGainFocus();
     void onLostFocus();
 
-    void DrawFPSWithTargetFrequency(float deltaSec, float secBetweenUpdate);
-    void DrawFPS(std::string fps);
-
     void ChangeGameStateDelegate(Events::IEventDataPtr ptrEvent);
     void LoadResourcesDelegate(Events::IEventDataPtr ptrEvent);
     void UnloadResourcesDelegate(Events::IEventDataPtr ptrEvent);
 
 private:
+    void ReleaseUnusedTextures();
 
     std::unique_ptr<SceneGame> mPtrGameScene;
     std::unique_ptr<ScenePause> mPtrPauseScene;
@@ -69,13 +73,10 @@ private:
     std::unique_ptr<ScenePause> mPtrFinishScene;
 
     std::unique_ptr<Ui> mPtrUi;
-//    std::unique_ptr<TextRenderer> mPtrTextPauseRenderer;
-//    std::unique_ptr<TextRenderer> mPtrTextDefaultRenderer;
-//    std::unique_ptr<TextRenderer> mPtrTextDigitRenderer;
+    std::unique_ptr<PerfHud> mPtrPerfHud;
 
     bool mInitializedResource;
-    float mTimeAccumulator;
-    float mCurrentFPS;
+    bool mLowMemoryPending;         // arrived without a window, released once there is one again
 
     static GameState sGameState;
 
@@ -0,0 +1,547 @@
+#include <algorithm>
+#include <cassert>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "FontAtlas.h"
+#include "Android.h"
+#include "GLState.h"
+#include "ResourceManager.h"
+#include "Profiler.h"
+#include "Log.h"
+
+namespace {
+
+// Offset from a pixel to the nearest seed pixel found so far.
+struct EdtPoint {
+    int32_t dx;
+    int32_t dy;
+
+    int32_t DistSq() const { return dx * dx + dy * dy; }
+};
+
+int32_t const EDT_FAR = 10000;
+
+static_assert(FONT_ATLAS_CHARS <= static_cast<size_t>(SDF_ATLAS_CELLS), "ASCII must fit in the atlas");
+
+uint32_t const GLYPH_CACHE_MAGIC = 0x31434746;     // "FGC1"
+uint32_t const GLYPH_CACHE_VERSION = 3;
+uint32_t const GLYPH_CACHE_MAX_KERNING_PAIRS = 1 << 20;
+
+// Glyph cache file: header, FONT_ATLAS_CHARS records, the kerning keys and values, then the atlas rows holding the
+// glyphs' cells. Native byte order, the
+// file never leaves the device.
+struct GlyphCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t fontHash;
+    int32_t pixelSize;
+    int32_t spread;
+    int32_t atlasSize;
+    int32_t atlasCell;
+    uint32_t glyphCount;
+    uint32_t kerningPairs;
+};
+
+struct GlyphCacheRecord {
+    uint32_t index;
+    int32_t cell;           // -1 for glyphs without ink
+    float size[2];
+    float bearing[2];
+};
+
+GlyphCacheHeader MakeHeader(uint64_t fontHash) {
+    GlyphCacheHeader header {};
+    header.magic = GLYPH_CACHE_MAGIC;
+    header.version = GLYPH_CACHE_VERSION;
+    header.fontHash = fontHash;
+    header.pixelSize = SDF_GLYPH_PIXEL_SIZE;
+    header.spread = SDF_SPREAD;
+    header.atlasSize = SDF_ATLAS_SIZE;
+    header.atlasCell = SDF_ATLAS_CELL;
+    header.glyphCount = static_cast<uint32_t>(FONT_ATLAS_CHARS);
+    return header;
+}
+
+uint64_t HashFont(std::vector<uint8_t> const & fontBuffer) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (uint8_t byte : fontBuffer) {
+        hash ^= byte;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+glm::vec4 CellRect(int32_t cell, glm::vec2 const & size) {
+    float const texel = 1.f / SDF_ATLAS_SIZE;
+    float x = static_cast<float>((cell % SDF_ATLAS_CELLS_PER_ROW) * SDF_ATLAS_CELL);
+    float y = static_cast<float>((cell / SDF_ATLAS_CELLS_PER_ROW) * SDF_ATLAS_CELL);
+    return {x * texel, y * texel, (x + size.x + 2 * SDF_SPREAD) * texel, (y + size.y + 2 * SDF_SPREAD) * texel};
+}
+
+bool FitsCell(glm::vec2 const & size) {
+    return size.x + 2 * SDF_SPREAD <= SDF_ATLAS_CELL && size.y + 2 * SDF_SPREAD <= SDF_ATLAS_CELL;
+}
+
+size_t CellRowsBytes(size_t cells) {
+    size_t rows = (cells + SDF_ATLAS_CELLS_PER_ROW - 1) / SDF_ATLAS_CELLS_PER_ROW;
+    return rows * SDF_ATLAS_CELL * SDF_ATLAS_SIZE;
+}
+
+void Compare(std::vector<EdtPoint> & grid, int32_t width, int32_t height, int32_t x, int32_t y, int32_t ox, int32_t oy) {
+    int32_t nx = x + ox;
+    int32_t ny = y + oy;
+    if (nx < 0 || ny < 0 || nx >= width || ny >= height)
+        return;
+
+    EdtPoint other = grid[ny * width + nx];
+    other.dx += ox;
+    other.dy += oy;
+    EdtPoint & point = grid[y * width + x];
+    if (other.DistSq() < point.DistSq())
+        point = other;
+}
+
+// 8SSEDT: one sweep down and one up, each followed by a pass against the row direction.
+void Propagate(std::vector<EdtPoint> & grid, int32_t width, int32_t height) {
+    for (int32_t y = 0; y < height; ++y) {
+        for (int32_t x = 0; x < width; ++x) {
+            Compare(grid, width, height, x, y, -1, 0);
+            Compare(grid, width, height, x, y, 0, -1);
+            Compare(grid, width, height, x, y, -1, -1);
+            Compare(grid, width, height, x, y, 1, -1);
+        }
+        for (int32_t x = width - 1; x >= 0; --x)
+            Compare(grid, width, height, x, y, 1, 0);
+    }
+
+    for (int32_t y = height - 1; y >= 0; --y) {
+        for (int32_t x = width - 1; x >= 0; --x) {
+            Compare(grid, width, height, x, y, 1, 0);
+            Compare(grid, width, height, x, y, 0, 1);
+            Compare(grid, width, height, x, y, -1, 1);
+            Compare(grid, width, height, x, y, 1, 1);
+        }
+        for (int32_t x = 0; x < width; ++x)
+            Compare(grid, width, height, x, y, -1, 0);
+    }
+}
+
+}
+
+void BuildDistanceField(uint8_t const * ptrCoverage,
+                        int32_t width,
+                        int32_t height,
+                        int32_t pitch,
+                        int32_t spread,
+                        uint8_t * ptrOut,
+                        int32_t outPitch)
+{
+    int32_t fieldWidth = width + 2 * spread;
+    int32_t fieldHeight = height + 2 * spread;
+    size_t pixels = static_cast<size_t>(fieldWidth * fieldHeight);
+
+    EdtPoint const seed {0, 0};
+    EdtPoint const far {EDT_FAR, EDT_FAR};
+    std::vector<bool> inside(pixels, false);
+    std::vector<EdtPoint> toInside(pixels, far);
+    std::vector<EdtPoint> toOutside(pixels, far);
+
+    for (int32_t y = 0; y < fieldHeight; ++y) {
+        for (int32_t x = 0; x < fieldWidth; ++x) {
+            int32_t cx = x - spread;
+            int32_t cy = y - spread;
+            size_t index = static_cast<size_t>(y * fieldWidth + x);
+            inside[index] = cx >= 0 && cy >= 0 && cx < width && cy < height && ptrCoverage[cy * pitch + cx] >= 128;
+            if (inside[index])
+                toInside[index] = seed;
+            else
+                toOutside[index] = seed;
+        }
+    }
+
+    Propagate(toInside, fieldWidth, fieldHeight);
+    Propagate(toOutside, fieldWidth, fieldHeight);
+
+    // Pixel centers sit half a pixel from the edge between an inside and an outside pixel.
+    float const scale = 1.f / (2.f * spread);
+    for (int32_t y = 0; y < fieldHeight; ++y) {
+        for (int32_t x = 0; x < fieldWidth; ++x) {
+            size_t index = static_cast<size_t>(y * fieldWidth + x);
+            float distance = inside[index] ? std::sqrt(static_cast<float>(toOutside[index].DistSq())) - 0.5f
+                                           : 0.5f - std::sqrt(static_cast<float>(toInside[index].DistSq()));
+            float value = std::min(std::max(0.5f + distance * scale, 0.f), 1.f);
+            ptrOut[y * outPitch + x] = static_cast<uint8_t>(value * 255.f + 0.5f);
+        }
+    }
+}
+
+FontAtlas::FontAtlas() : mFontPath {},
+                         mFontBuffer {},
+                         mPtrLibrary {},
+                         mPtrFace {},
+                         mFaceMutex {},
+                         mGlyphs {},
+                         mGlyphTable {},
+                         mCells {},
+                         mCellTable {},
+                         mCellPixels {},
+                         mUseStamp {},
+                         mEvictions {},
+                         mTexture {}
+{}
+
+FontAtlas::~FontAtlas() {
+    if (mPtrFace)
+        FT_Done_Face(mPtrFace);
+    if (mPtrLibrary)
+        FT_Done_FreeType(mPtrLibrary);
+    if (mTexture)
+        glDeleteTextures(1, &mTexture);
+}
+
+void FontAtlas::Load(std::string const & fontPath) {
+    PROFILE_SCOPE("FontAtlas::Load");
+    assert(!mTexture);
+
+    mFontPath = fontPath;
+    ResourceManager::Read(fontPath, mFontBuffer, 0);
+
+    // Keyed by the font contents and the raster size: a changed font or SDF setting simply misses.
+    uint64_t fontHash = HashFont(mFontBuffer);
+    char cacheName[64];
+    snprintf(cacheName, sizeof(cacheName), "/glyphs_%016" PRIx64 "_%d.bin", fontHash, SDF_GLYPH_PIXEL_SIZE);
+    std::string cachePath = std::string(Android::GetInstance().GetAndroidApp()->activity->internalDataPath) + cacheName;
+
+    std::vector<uint8_t> atlas(static_cast<size_t>(SDF_ATLAS_SIZE * SDF_ATLAS_SIZE));
+    if (ReadCache(cachePath, fontHash, atlas)) {
+        Log::info("FontAtlas %s: glyph cache hit %s", fontPath.c_str(), cachePath.c_str());
+    }
+    else {
+        if (!Rasterize(atlas))
+            return;
+        WriteCache(cachePath, fontHash, atlas);
+    }
+
+    Upload(atlas);
+}
+
+FTCharacter const * FontAtlas::GetGlyph(uint32_t code) {
+    int32_t index = mGlyphTable.Find(code);
+    if (index != GlyphTable::NONE)
+        return &mGlyphs[static_cast<size_t>(index)];
+
+    FTCharacter glyph {};
+    {
+        std::lock_guard<std::mutex> lock(mFaceMutex);
+        if (!RenderGlyph(code, glyph))
+            return nullptr;
+    }
+
+    mGlyphTable.Set(code, static_cast<int32_t>(mGlyphs.size()));
+    mGlyphs.push_back(glyph);
+    return &mGlyphs.back();
+}
+
+AtlasGlyph const * FontAtlas::AcquireGlyph(uint32_t code) {
+    int32_t cell = mCellTable.Find(code);
+    if (cell >= 0) {
+        AtlasGlyph & glyph = mCells[static_cast<size_t>(cell)];
+        glyph.lastUse = mUseStamp;
+        return &glyph;
+    }
+    if (cell == NO_INK || !mTexture)
+        return nullptr;
+
+    return LoadCell(code);
+}
+
+AtlasGlyph const * FontAtlas::LoadCell(uint32_t code) {
+    PROFILE_SCOPE("FontAtlas::LoadCell");
+
+    std::lock_guard<std::mutex> lock(mFaceMutex);
+    FTCharacter glyph {};
+    if (!RenderGlyph(code, glyph) || glyph.size.x == 0.f || glyph.size.y == 0.f || !FitsCell(glyph.size)) {
+        mCellTable.Set(code, NO_INK);
+        return nullptr;
+    }
+
+    int32_t cell = FindFreeCell();
+    if (cell == GlyphTable::NONE) {
+        Log_warn("FontAtlas %s: all %d cells are used by one string, U+%04X skipped",
+                 mFontPath.c_str(),
+                 SDF_ATLAS_CELLS,
+                 code);
+        return nullptr;
+    }
+
+    FT_Bitmap const & bitmap = mPtrFace->glyph->bitmap;
+    mCellPixels.assign(static_cast<size_t>(SDF_ATLAS_CELL * SDF_ATLAS_CELL), 0);
+    BuildDistanceField(bitmap.buffer,
+                       static_cast<int32_t>(bitmap.width),
+                       static_cast<int32_t>(bitmap.rows),
+                       bitmap.pitch,
+                       SDF_SPREAD,
+                       mCellPixels.data(),
+                       SDF_ATLAS_CELL);
+
+    // The whole cell goes up, so nothing of the glyph it held before is left around the new one.
+    bool redTexture = GLState::GetInstance().GetGLESVersion() >= 3;
+    GLState::GetInstance().BindTexture2D(mTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D,
+                    0,
+                    (cell % SDF_ATLAS_CELLS_PER_ROW) * SDF_ATLAS_CELL,
+                    (cell / SDF_ATLAS_CELLS_PER_ROW) * SDF_ATLAS_CELL,
+                    SDF_ATLAS_CELL,
+                    SDF_ATLAS_CELL,
+                    redTexture ? GL_RED : GL_LUMINANCE,
+                    GL_UNSIGNED_BYTE,
+                    mCellPixels.data());
+
+    AtlasGlyph & atlasGlyph = mCells[static_cast<size_t>(cell)];
+    atlasGlyph = {code, glyph.size, CellRect(cell, glyph.size), mUseStamp};
+    mCellTable.Set(code, cell);
+    return &atlasGlyph;
+}
+
+int32_t FontAtlas::FindFreeCell() {
+    if (mCells.size() < static_cast<size_t>(SDF_ATLAS_CELLS)) {
+        mCells.emplace_back();
+        return static_cast<int32_t>(mCells.size() - 1);
+    }
+
+    // Misses are rare once the text on screen is resident, a scan for the oldest stamp is cheaper than keeping a list.
+    int32_t victim = GlyphTable::NONE;
+    uint64_t oldest = mUseStamp;
+    for (size_t cell = 0; cell < mCells.size(); ++cell) {
+        if (mCells[cell].lastUse < oldest) {
+            oldest = mCells[cell].lastUse;
+            victim = static_cast<int32_t>(cell);
+        }
+    }
+
+    if (victim != GlyphTable::NONE) {
+        mCellTable.Erase(mCells[static_cast<size_t>(victim)].code);
+        ++mEvictions;
+    }
+    return victim;
+}
+
+void FontAtlas::AddCell(uint32_t code, glm::vec2 const & size) {
+    int32_t cell = static_cast<int32_t>(mCells.size());
+    mCells.push_back({code, size, CellRect(cell, size), 0});
+    mCellTable.Set(code, cell);
+}
+
+bool FontAtlas::OpenFace() {
+    if (mPtrFace)
+        return true;
+
+    if (FT_Init_FreeType(&mPtrLibrary)) {
+        Log::error("ERROR::FREETYPE: Could not init FreeType Library");
+        assert(false);
+        mPtrLibrary = nullptr;
+        return false;
+    }
+
+    if (FT_New_Memory_Face(mPtrLibrary, mFontBuffer.data(), static_cast<FT_Long>(mFontBuffer.size()), 0, &mPtrFace)) {
+        Log::error("ERROR::FREETYPE: Failed to load font %s", mFontPath.c_str());
+        assert(false);
+        mPtrFace = nullptr;
+        return false;
+    }
+
+    FT_Set_Pixel_Sizes(mPtrFace, 0, SDF_GLYPH_PIXEL_SIZE);
+    return true;
+}
+
+bool FontAtlas::RenderGlyph(uint32_t code, FTCharacter & glyph) {
+    if (!OpenFace())
+        return false;
+
+    glyph.index = FT_Get_Char_Index(mPtrFace, code);
+    if (FT_Load_Glyph(mPtrFace, glyph.index, FT_LOAD_RENDER)) {
+        Log::error("ERROR::FREETYPE: Failed to load glyph U+%04X", code);
+        return false;
+    }
+
+    FT_GlyphSlot ptrSlot = mPtrFace->glyph;
+    glyph.size = {ptrSlot->bitmap.width, ptrSlot->bitmap.rows};
+    glyph.bearing = {ptrSlot->bitmap_left, ptrSlot->bitmap_top};
+    return true;
+}
+
+bool FontAtlas::ReadCache(std::string const & cachePath, uint64_t fontHash, std::vector<uint8_t> & atlas) {
+    PROFILE_SCOPE("FontAtlas::ReadCache");
+    FILE * ptrFile = fopen(cachePath.c_str(), "rb");
+    if (!ptrFile)
+        return false;
+
+    GlyphCacheHeader expected = MakeHeader(fontHash);
+    GlyphCacheHeader header {};
+    std::array<GlyphCacheRecord, FONT_ATLAS_CHARS> records;
+
+    bool valid = fread(&header, sizeof(header), 1, ptrFile) == 1;
+    expected.kerningPairs = header.kerningPairs;
+    valid = valid && std::memcmp(&header, &expected, sizeof(header)) == 0 &&
+            header.kerningPairs <= GLYPH_CACHE_MAX_KERNING_PAIRS &&
+            fread(records.data(), sizeof(GlyphCacheRecord), records.size(), ptrFile) == records.size();
+
+    std::vector<uint32_t> kerningKeys(valid ? header.kerningPairs : 0);
+    std::vector<int16_t> kerningValues(kerningKeys.size());
+    valid = valid && fread(kerningKeys.data(), sizeof(uint32_t), kerningKeys.size(), ptrFile) == kerningKeys.size() &&
+            fread(kerningValues.data(), sizeof(int16_t), kerningValues.size(), ptrFile) == kerningValues.size() &&
+            mKerning.Assign(std::move(kerningKeys), std::move(kerningValues));
+
+    // Cells are handed out in order, so the records must number them 0, 1, 2...
+    int32_t cells {};
+    for (size_t c = 0; valid && c < FONT_ATLAS_CHARS; ++c) {
+        GlyphCacheRecord const & record = records[c];
+        if (record.cell == cells)
+            ++cells;
+        else
+            valid = record.cell == -1;
+    }
+
+    size_t atlasBytes = CellRowsBytes(static_cast<size_t>(cells));
+    valid = valid && cells <= SDF_ATLAS_CELLS && fread(atlas.data(), 1, atlasBytes, ptrFile) == atlasBytes;
+    fclose(ptrFile);
+
+    if (!valid) {
+        Log_warn("FontAtlas: stale or broken glyph cache %s", cachePath.c_str());
+        return false;
+    }
+
+    for (size_t c = 0; c < FONT_ATLAS_CHARS; ++c) {
+        GlyphCacheRecord const & record = records[c];
+        FTCharacter glyph {};
+        glyph.index = record.index;
+        glyph.size = {record.size[0], record.size[1]};
+        glyph.bearing = {record.bearing[0], record.bearing[1]};
+
+        mGlyphTable.Set(static_cast<uint32_t>(c), static_cast<int32_t>(mGlyphs.size()));
+        mGlyphs.push_back(glyph);
+        if (record.cell >= 0)
+            AddCell(static_cast<uint32_t>(c), glyph.size);
+        else
+            mCellTable.Set(static_cast<uint32_t>(c), NO_INK);
+    }
+    return true;
+}
+
+void FontAtlas::WriteCache(std::string const & cachePath, uint64_t fontHash, std::vector<uint8_t> const & atlas) const {
+    PROFILE_SCOPE("FontAtlas::WriteCache");
+    GlyphCacheHeader header = MakeHeader(fontHash);
+    header.kerningPairs = static_cast<uint32_t>(mKerning.GetSize());
+    std::array<GlyphCacheRecord, FONT_ATLAS_CHARS> records;
+    for (uint32_t c = 0; c < FONT_ATLAS_CHARS; ++c) {
+        FTCharacter const & glyph = mGlyphs[static_cast<size_t>(mGlyphTable.Find(c))];
+        GlyphCacheRecord & record = records[c];
+        record.index = glyph.index;
+        record.cell = std::max(mCellTable.Find(c), -1);
+        record.size[0] = glyph.size.x;
+        record.size[1] = glyph.size.y;
+        record.bearing[0] = glyph.bearing.x;
+        record.bearing[1] = glyph.bearing.y;
+    }
+
+    // Written under a temporary name and renamed, so a crash halfway never leaves a file that looks valid.
+    std::string tempPath = cachePath + ".tmp";
+    FILE * ptrFile = fopen(tempPath.c_str(), "wb");
+    if (!ptrFile) {
+        Log_warn("FontAtlas: can't write glyph cache %s", tempPath.c_str());
+        return;
+    }
+
+    size_t atlasBytes = CellRowsBytes(mCells.size());
+    bool written = fwrite(&header, sizeof(header), 1, ptrFile) == 1 &&
+                   fwrite(records.data(), sizeof(GlyphCacheRecord), records.size(), ptrFile) == records.size() &&
+                   fwrite(mKerning.GetKeys().data(), sizeof(uint32_t), mKerning.GetSize(), ptrFile) ==
+                   mKerning.GetSize() &&
+                   fwrite(mKerning.GetValues().data(), sizeof(int16_t), mKerning.GetSize(), ptrFile) ==
+                   mKerning.GetSize() &&
+                   fwrite(atlas.data(), 1, atlasBytes, ptrFile) == atlasBytes;
+    written = fclose(ptrFile) == 0 && written;
+
+    if (!written || rename(tempPath.c_str(), cachePath.c_str()) != 0) {
+        Log_warn("FontAtlas: can't write glyph cache %s", cachePath.c_str());
+        remove(tempPath.c_str());
+    }
+}
+
+bool FontAtlas::Rasterize(std::vector<uint8_t> & atlas) {
+    PROFILE_SCOPE("FontAtlas::Rasterize");
+
+    std::lock_guard<std::mutex> lock(mFaceMutex);
+    if (!OpenFace())
+        return false;
+
+    mKerning.Build(mPtrFace);
+
+    for (uint32_t c = 0; c < FONT_ATLAS_CHARS; ++c) {
+        FTCharacter glyph {};
+        bool rendered = RenderGlyph(c, glyph);
+        assert(rendered);
+
+        bool ink = rendered && glyph.size.x > 0.f && glyph.size.y > 0.f;
+        if (ink && !FitsCell(glyph.size)) {
+            Log_warn("FontAtlas: glyph %u of %s is larger than a cell", c, mFontPath.c_str());
+            glyph.size = {};
+            ink = false;
+        }
+
+        mGlyphTable.Set(c, static_cast<int32_t>(mGlyphs.size()));
+        mGlyphs.push_back(glyph);
+        if (!ink) {
+            mCellTable.Set(c, NO_INK);
+            continue;
+        }
+
+        int32_t cell = static_cast<int32_t>(mCells.size());
+        int32_t cellX = (cell % SDF_ATLAS_CELLS_PER_ROW) * SDF_ATLAS_CELL;
+        int32_t cellY = (cell / SDF_ATLAS_CELLS_PER_ROW) * SDF_ATLAS_CELL;
+        FT_Bitmap const & bitmap = mPtrFace->glyph->bitmap;
+        BuildDistanceField(bitmap.buffer,
+                           static_cast<int32_t>(bitmap.width),
+                           static_cast<int32_t>(bitmap.rows),
+                           bitmap.pitch,
+                           SDF_SPREAD,
+                           &atlas[static_cast<size_t>(cellY * SDF_ATLAS_SIZE + cellX)],
+                           SDF_ATLAS_SIZE);
+        AddCell(c, glyph.size);
+    }
+
+    Log::info("FontAtlas %s: rasterized %zu glyphs, %zu kerning pairs",
+              mFontPath.c_str(),
+              mCells.size(),
+              mKerning.GetSize());
+    return true;
+}
+
+void FontAtlas::Upload(std::vector<uint8_t> const & atlas) {
+    // Single channel: R8 on GLES3, luminance reads back through .r on GLES2.
+    bool redTexture = GLState::GetInstance().GetGLESVersion() >= 3;
+    glGenTextures(1, &mTexture);
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D,
+                 0,
+                 redTexture ? GL_R8 : GL_LUMINANCE,
+                 SDF_ATLAS_SIZE,
+                 SDF_ATLAS_SIZE,
+                 0,
+                 redTexture ? GL_RED : GL_LUMINANCE,
+                 GL_UNSIGNED_BYTE,
+                 atlas.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLState::GetInstance().CheckGLError("FontAtlas::Load");
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GLES3/gl3.h>
+
+#include "GameTypes.h"
+#include "Kerning.h"
+
+int32_t const SDF_GLYPH_PIXEL_SIZE = 32;    // glyphs are rasterized once at this size, text of any size scales from it
+int32_t const SDF_SPREAD = 4;               // pixels of distance kept on each side of a glyph edge
+int32_t const SDF_ATLAS_SIZE = 1024;        // fixed; once every cell is taken new glyphs evict the least recently drawn
+int32_t const SDF_ATLAS_CELL = 48;          // one glyph per cell, ink box plus spread must fit
+int32_t const SDF_ATLAS_CELLS_PER_ROW = SDF_ATLAS_SIZE / SDF_ATLAS_CELL;
+int32_t const SDF_ATLAS_CELLS = SDF_ATLAS_CELLS_PER_ROW * SDF_ATLAS_CELLS_PER_ROW;
+size_t const FONT_ATLAS_CHARS = 128;        // ASCII, rasterized up front and kept in the glyph cache
+uint32_t const FONT_ATLAS_FLAT_CHARS = 0x500;   // Latin, Greek and Cyrillic are looked up by index, the rest hashed
+
+// A glyph's cell in the atlas texture.
+struct AtlasGlyph {
+    uint32_t    code;
+    glm::vec2   size;       // ink box, as in FTCharacter
+    glm::vec4   uvRect;     // distance field in the atlas, ink box plus SDF_SPREAD on each side
+    uint64_t    lastUse;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// GlyphTable
+// Code point to index. Code points below FONT_ATLAS_FLAT_CHARS index an array directly, only the others go through a
+// hash map, so text in the common scripts never hashes.
+//---------------------------------------------------------------------------------------------------------------------
+class GlyphTable {
+public:
+    static int32_t const NONE = -1;
+
+    GlyphTable() { mFlat.fill(NONE); }
+
+    int32_t Find(uint32_t code) const {
+        if (code < FONT_ATLAS_FLAT_CHARS)
+            return mFlat[code];
+        auto it = mOther.find(code);
+        return it != mOther.end() ? it->second : NONE;
+    }
+
+    void Set(uint32_t code, int32_t index) {
+        if (code < FONT_ATLAS_FLAT_CHARS)
+            mFlat[code] = index;
+        else
+            mOther[code] = index;
+    }
+
+    void Erase(uint32_t code) {
+        if (code < FONT_ATLAS_FLAT_CHARS)
+            mFlat[code] = NONE;
+        else
+            mOther.erase(code);
+    }
+
+    void Clear() {
+        mFlat.fill(NONE);
+        mOther.clear();
+    }
+
+private:
+    std::array<int32_t, FONT_ATLAS_FLAT_CHARS> mFlat;
+    std::unordered_map<uint32_t, int32_t> mOther;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// FontAtlas
+// Signed distance fields of a font's glyphs in a single SDF_ATLAS_SIZE square texture of fixed size cells. FreeType
+// renders each glyph at SDF_GLYPH_PIXEL_SIZE and an 8-point sequential Euclidean distance transform turns the coverage
+// into a distance field, 0.5 on the edge and SDF_SPREAD pixels of falloff to either side. Every TextRenderer of the
+// font draws from the same texture whatever its size, see ResourceManager::GetFont.
+// ASCII and the kerning pairs are loaded up front and written to internal storage keyed by a hash of the font file and
+// the raster size, so FreeType only runs for them on the first launch after install or after the font changes. Any
+// other code point is rasterized the first time it is drawn; when the atlas is full it takes the cell of the glyph
+// drawn least recently.
+// Layout (GetGlyph) and drawing (AcquireGlyph) keep separate tables, so the two threads only share the FreeType face.
+//---------------------------------------------------------------------------------------------------------------------
+class FontAtlas {
+public:
+    FontAtlas();
+    ~FontAtlas();
+    FontAtlas(FontAtlas const &) = delete;
+    FontAtlas & operator=(FontAtlas const &) = delete;
+
+    // Needs a current GL context.
+    void Load(std::string const & fontPath);
+
+    // Layout thread. Metrics of a code point, read from the font the first time it is asked for; code points the font
+    // lacks get its missing glyph. nullptr only if FreeType fails.
+    FTCharacter const * GetGlyph(uint32_t code);
+    // Pixels at SDF_GLYPH_PIXEL_SIZE to add between two glyphs, by their FTCharacter::index.
+    float GetKerning(uint32_t leftIndex, uint32_t rightIndex) const {
+        return static_cast<float>(mKerning.Find(leftIndex, rightIndex)) / 64.f;
+    }
+
+    // Render thread. Starts a string: glyphs acquired from here on keep their cells until the next call.
+    void BeginString() { ++mUseStamp; }
+    // Render thread. The glyph's cell, rasterized and uploaded first if it isn't resident. nullptr for glyphs without
+    // ink, or when every cell holds a glyph of the current string.
+    AtlasGlyph const * AcquireGlyph(uint32_t code);
+
+    GLuint GetTexture() const { return mTexture; }
+    uint32_t GetEvictions() const { return mEvictions; }
+    size_t GetTextureBytes() const { return mTexture ? static_cast<size_t>(SDF_ATLAS_SIZE) * SDF_ATLAS_SIZE : 0; }
+    size_t GetFontFileBytes() const { return mFontBuffer.size(); }
+
+private:
+    static int32_t const NO_INK = -2;
+
+    bool ReadCache(std::string const & cachePath, uint64_t fontHash, std::vector<uint8_t> & atlas);
+    void WriteCache(std::string const & cachePath, uint64_t fontHash, std::vector<uint8_t> const & atlas) const;
+    bool Rasterize(std::vector<uint8_t> & atlas);
+    void Upload(std::vector<uint8_t> const & atlas);
+
+    // Both need mFaceMutex held. RenderGlyph leaves the coverage in the face's glyph slot.
+    bool OpenFace();
+    bool RenderGlyph(uint32_t code, FTCharacter & glyph);
+
+    AtlasGlyph const * LoadCell(uint32_t code);
+    int32_t FindFreeCell();
+    void AddCell(uint32_t code, glm::vec2 const & size);
+
+private:
+    std::string mFontPath;
+    std::vector<uint8_t> mFontBuffer;   // FreeType reads the face straight from it
+    FT_Library mPtrLibrary;
+    FT_Face mPtrFace;
+    std::mutex mFaceMutex;
+
+    // Layout thread
+    std::vector<FTCharacter> mGlyphs;
+    GlyphTable mGlyphTable;
+    KerningTable mKerning;
+
+    // Render thread
+    std::vector<AtlasGlyph> mCells;     // by cell, NO_INK in mCellTable marks glyphs that need none
+    GlyphTable mCellTable;
+    std::vector<uint8_t> mCellPixels;
+    uint64_t mUseStamp;
+    uint32_t mEvictions;
+
+    GLuint mTexture;
+};
+
+// Distance field of a coverage bitmap: out receives (width + 2 * spread) x (height + 2 * spread) bytes, rows of
+// outPitch.
+void BuildDistanceField(uint8_t const * ptrCoverage,
+                        int32_t width,
+                        int32_t height,
+                        int32_t pitch,
+                        int32_t spread,
+                        uint8_t * ptrOut,
+                        int32_t outPitch);
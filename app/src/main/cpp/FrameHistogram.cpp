@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <cmath>
+
+#include "FrameHistogram.h"
+
+FrameTimeHistogram::FrameTimeHistogram() : mSamples {},
+                                           mBuckets {},
+                                           mNext {},
+                                           mCount {},
+                                           mSum {}
+{}
+
+size_t FrameTimeHistogram::BucketIndex(float ms) {
+    if (ms <= 0.f)
+        return 0;
+    return std::min(static_cast<size_t>(ms / FRAME_HISTOGRAM_BUCKET_MS), FRAME_HISTOGRAM_BUCKETS);
+}
+
+void FrameTimeHistogram::Add(double ms) {
+    if (mCount == FRAME_HISTOGRAM_WINDOW) {
+        float evicted = mSamples[mNext];
+        --mBuckets[BucketIndex(evicted)];
+        mSum -= evicted;
+    }
+    else {
+        ++mCount;
+    }
+
+    float sample = static_cast<float>(ms);
+    mSamples[mNext] = sample;
+    ++mBuckets[BucketIndex(sample)];
+    mSum += sample;
+    mNext = (mNext + 1) % FRAME_HISTOGRAM_WINDOW;
+}
+
+void FrameTimeHistogram::Reset() {
+    mBuckets.fill(0);
+    mNext = 0;
+    mCount = 0;
+    mSum = 0.0;
+}
+
+double FrameTimeHistogram::Percentile(double fraction) const {
+    if (mCount == 0)
+        return 0.0;
+
+    size_t rank = static_cast<size_t>(std::ceil(fraction * mCount));
+    rank = std::min(std::max<size_t>(rank, 1), mCount);
+
+    size_t cumulative = 0;
+    for (size_t bucket = 0; bucket < FRAME_HISTOGRAM_BUCKETS; ++bucket) {
+        cumulative += mBuckets[bucket];
+        if (cumulative >= rank)
+            return std::min((bucket + 1) * FRAME_HISTOGRAM_BUCKET_MS, Max());
+    }
+    return Max();
+}
+
+double FrameTimeHistogram::Max() const {
+    if (mCount == 0)
+        return 0.0;
+    return *std::max_element(mSamples.begin(), mSamples.begin() + mCount);
+}
+
+double FrameTimeHistogram::Mean() const {
+    return mCount ? mSum / mCount : 0.0;
+}
+
+FrameTimeSummary FrameTimeHistogram::Summarize() const {
+    FrameTimeSummary summary {};
+    summary.p50Ms = Percentile(0.50);
+    summary.p95Ms = Percentile(0.95);
+    summary.p99Ms = Percentile(0.99);
+    summary.maxMs = Max();
+    summary.meanMs = Mean();
+    summary.samples = GetSampleCount();
+    return summary;
+}
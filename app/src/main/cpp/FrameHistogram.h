@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+size_t const FRAME_HISTOGRAM_WINDOW = 600;          // about ten seconds at 60 Hz
+size_t const FRAME_HISTOGRAM_BUCKETS = 400;
+double const FRAME_HISTOGRAM_BUCKET_MS = 0.25;      // buckets cover 0..100 ms, anything longer goes to overflow
+
+struct FrameTimeSummary {
+    double      p50Ms;
+    double      p95Ms;
+    double      p99Ms;
+    double      maxMs;
+    double      meanMs;
+    uint32_t    samples;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// FrameTimeHistogram
+// Rolling histogram over the last FRAME_HISTOGRAM_WINDOW samples. Adding a sample evicts the oldest one, so recording
+// is O(1) and never allocates; percentiles walk the buckets and are accurate to one bucket (upper edge is returned).
+//---------------------------------------------------------------------------------------------------------------------
+class FrameTimeHistogram {
+public:
+    FrameTimeHistogram();
+
+    void Add(double ms);
+    void Reset();
+
+    double Percentile(double fraction) const;
+    double Max() const;
+    double Mean() const;
+    uint32_t GetSampleCount() const { return static_cast<uint32_t>(mCount); }
+
+    FrameTimeSummary Summarize() const;
+
+private:
+    static size_t BucketIndex(float ms);
+
+private:
+    std::array<float, FRAME_HISTOGRAM_WINDOW> mSamples;
+    std::array<uint16_t, FRAME_HISTOGRAM_BUCKETS + 1> mBuckets;
+    size_t mNext;
+    size_t mCount;
+    double mSum;
+};
@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <cmath>
+
+#ifdef __ANDROID__
+#include <dlfcn.h>
+#endif
+
+#include "FramePacer.h"
+#include "Log.h"
+
+uint64_t const DEFAULT_REFRESH_PERIOD_NS = 16666667;
+uint64_t const MIN_REFRESH_PERIOD_NS = 4000000;      // 250 Hz
+uint64_t const MAX_REFRESH_PERIOD_NS = 50000000;     // 20 Hz
+double const QUANTIZE_TOLERANCE = 0.25;              // in refresh periods
+
+// AChoreographer is API 24, resolved at runtime.
+using ChoreographerFrameCallback = void (*)(long frameTimeNanos, void * data);
+using ChoreographerGetInstanceFn = void * (*)();
+using ChoreographerPostFrameCallbackFn = void (*)(void * choreographer, ChoreographerFrameCallback callback, void * data);
+
+static ChoreographerPostFrameCallbackFn sPostFrameCallback = nullptr;
+
+size_t const FramePacer::PERIOD_WINDOW;
+
+FramePacer::FramePacer() : mInitialized {false},
+                           mUseChoreographer {false},
+                           mCallbackPending {false},
+                           mPtrChoreographer {nullptr},
+                           mIntervals {},
+                           mNextInterval {},
+                           mIntervalCount {},
+                           mPeriodNs {DEFAULT_REFRESH_PERIOD_NS},
+                           mLastVsyncNs {},
+                           mLastFrameNs {},
+                           mJitterSumNs {},
+                           mMaxJitterNs {},
+                           mMissedVsyncs {},
+                           mFrames {}
+{}
+
+void FramePacer::Init() {
+    if (mInitialized)
+        return;
+    mInitialized = true;
+
+#ifdef __ANDROID__
+    // libandroid is always loaded in an app process, the handle is never closed.
+    void * ptrLibAndroid = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+    if (ptrLibAndroid) {
+        auto getInstance = reinterpret_cast<ChoreographerGetInstanceFn>(dlsym(ptrLibAndroid, "AChoreographer_getInstance"));
+        sPostFrameCallback = reinterpret_cast<ChoreographerPostFrameCallbackFn>(dlsym(ptrLibAndroid, "AChoreographer_postFrameCallback"));
+        if (getInstance && sPostFrameCallback)
+            mPtrChoreographer = getInstance();
+    }
+#endif
+
+    mUseChoreographer = mPtrChoreographer != nullptr;
+    Log::info("FramePacer: vsync from %s", mUseChoreographer ? "AChoreographer" : "swap intervals");
+}
+
+void FramePacer::OnFrameStart(uint64_t nowNs) {
+    if (!mInitialized)
+        Init();
+
+    if (mLastFrameNs != 0 && nowNs > mLastFrameNs) {
+        uint64_t intervalNs = nowNs - mLastFrameNs;
+
+        if (!mUseChoreographer) {
+            UpdatePeriod(intervalNs);
+            mLastVsyncNs = nowNs;
+        }
+
+        uint64_t periods = std::max<uint64_t>(1, static_cast<uint64_t>(std::llround(static_cast<double>(intervalNs) / mPeriodNs)));
+        double jitterNs = std::fabs(static_cast<double>(intervalNs) - static_cast<double>(periods * mPeriodNs));
+        mJitterSumNs += jitterNs;
+        mMaxJitterNs = std::max(mMaxJitterNs, jitterNs);
+        mMissedVsyncs += static_cast<uint32_t>(periods - 1);
+        ++mFrames;
+    }
+    mLastFrameNs = nowNs;
+
+    if (mUseChoreographer && !mCallbackPending)
+        PostFrameCallback();
+}
+
+void FramePacer::PostFrameCallback() {
+    sPostFrameCallback(mPtrChoreographer, &FramePacer::ChoreographerCallback, this);
+    mCallbackPending = true;
+}
+
+void FramePacer::ChoreographerCallback(long frameTimeNanos, void * data) {
+    static_cast<FramePacer*>(data)->OnVsync(static_cast<uint64_t>(frameTimeNanos));
+}
+
+void FramePacer::OnVsync(uint64_t vsyncNs) {
+    mCallbackPending = false;
+    if (mLastVsyncNs != 0 && vsyncNs > mLastVsyncNs)
+        UpdatePeriod(vsyncNs - mLastVsyncNs);
+    mLastVsyncNs = vsyncNs;
+}
+
+void FramePacer::UpdatePeriod(uint64_t intervalNs) {
+    if (intervalNs < MIN_REFRESH_PERIOD_NS)
+        return;
+
+    // A callback is only posted while frames are running, so vsync intervals can span several periods.
+    if (mUseChoreographer) {
+        uint64_t periods = std::max<uint64_t>(1, static_cast<uint64_t>(std::llround(static_cast<double>(intervalNs) / mPeriodNs)));
+        intervalNs /= periods;
+    }
+    if (intervalNs > MAX_REFRESH_PERIOD_NS)
+        return;
+
+    mIntervals[mNextInterval] = intervalNs;
+    mNextInterval = (mNextInterval + 1) % PERIOD_WINDOW;
+    mIntervalCount = std::min(mIntervalCount + 1, PERIOD_WINDOW);
+
+    // Choreographer intervals are exact multiples, the shortest one is the period. Swap intervals are noisy and
+    // occasionally long, the median is what the loop actually achieves.
+    std::array<uint64_t, PERIOD_WINDOW> sorted = mIntervals;
+    auto last = sorted.begin() + mIntervalCount;
+    if (mUseChoreographer) {
+        mPeriodNs = *std::min_element(sorted.begin(), last);
+    }
+    else {
+        auto median = sorted.begin() + mIntervalCount / 2;
+        std::nth_element(sorted.begin(), median, last);
+        mPeriodNs = *median;
+    }
+}
+
+uint64_t FramePacer::PredictNextVsyncNs(uint64_t nowNs) const {
+    if (mLastVsyncNs == 0 || nowNs < mLastVsyncNs)
+        return nowNs + mPeriodNs;
+
+    uint64_t periods = (nowNs - mLastVsyncNs) / mPeriodNs + 1;
+    return mLastVsyncNs + periods * mPeriodNs;
+}
+
+uint64_t FramePacer::QuantizeInterval(uint64_t intervalNs) const {
+    double periods = static_cast<double>(intervalNs) / mPeriodNs;
+    double whole = std::round(periods);
+    if (whole < 1.0 || std::fabs(periods - whole) > QUANTIZE_TOLERANCE)
+        return intervalNs;
+    return static_cast<uint64_t>(whole) * mPeriodNs;
+}
+
+FramePacingStats FramePacer::GetStats() const {
+    FramePacingStats stats {};
+    stats.refreshPeriodMs = static_cast<double>(mPeriodNs) * 1.0e-6;
+    stats.jitterMs = mFrames ? mJitterSumNs / mFrames * 1.0e-6 : 0.0;
+    stats.maxJitterMs = mMaxJitterNs * 1.0e-6;
+    stats.missedVsyncs = mMissedVsyncs;
+    stats.frames = mFrames;
+    stats.choreographer = mUseChoreographer;
+    return stats;
+}
+
+void FramePacer::ResetStats() {
+    mJitterSumNs = 0.0;
+    mMaxJitterNs = 0.0;
+    mMissedVsyncs = 0;
+    mFrames = 0;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+struct FramePacingStats {
+    double      refreshPeriodMs;    // current estimate of the display refresh period
+    double      jitterMs;           // mean distance of frame intervals from a whole number of refresh periods
+    double      maxJitterMs;
+    uint32_t    missedVsyncs;       // refresh periods skipped, summed over all frames
+    uint32_t    frames;
+    bool        choreographer;      // vsync timestamps come from AChoreographer instead of swap returns
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// FramePacer
+// Tracks the display refresh period and predicts the next vsync. On API 24+ vsync timestamps come from AChoreographer,
+// looked up at runtime so the library still loads on older devices. Otherwise the period is estimated from the
+// intervals between frames, which eglSwapBuffers (swap interval 1) already aligns to vsync.
+// Must be driven from the thread that owns the main ALooper.
+//---------------------------------------------------------------------------------------------------------------------
+class FramePacer {
+public:
+    FramePacer();
+    ~FramePacer() = default;
+    FramePacer(FramePacer const &) = delete;
+    FramePacer & operator=(FramePacer const &) = delete;
+
+    void Init();
+
+    // Call once per frame with the frame start time.
+    void OnFrameStart(uint64_t nowNs);
+
+    uint64_t GetRefreshPeriodNs() const { return mPeriodNs; }
+    uint64_t PredictNextVsyncNs(uint64_t nowNs) const;
+
+    // Rounds an interval to a whole number of refresh periods when it is within the jitter tolerance.
+    uint64_t QuantizeInterval(uint64_t intervalNs) const;
+
+    FramePacingStats GetStats() const;
+    void ResetStats();
+
+private:
+    static size_t const PERIOD_WINDOW = 16;
+
+    static void ChoreographerCallback(long frameTimeNanos, void * data);
+
+    void PostFrameCallback();
+    void OnVsync(uint64_t vsyncNs);
+    void UpdatePeriod(uint64_t intervalNs);
+
+private:
+    bool mInitialized;
+    bool mUseChoreographer;
+    bool mCallbackPending;
+    void * mPtrChoreographer;
+
+    std::array<uint64_t, PERIOD_WINDOW> mIntervals;
+    size_t mNextInterval;
+    size_t mIntervalCount;
+
+    uint64_t mPeriodNs;
+    uint64_t mLastVsyncNs;
+    uint64_t mLastFrameNs;
+
+    double mJitterSumNs;
+    double mMaxJitterNs;
+    uint32_t mMissedVsyncs;
+    uint32_t mFrames;
+};
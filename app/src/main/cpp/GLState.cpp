@@ -1,9 +1,16 @@
 #include <string>
 #include <cassert>
+#include <cstring>
+#include <initializer_list>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl3.h>
 
 #include "GLState.h"
 #include "Android.h"
 #include "Log.h"
+#include "Profiler.h"
 
 GLState::GLState()
         : mDisplay(EGL_NO_DISPLAY),
@@ -11,8 +18,14 @@ GLState::GLState()
           mContext(EGL_NO_CONTEXT),
           mScreenWidth(0),
           mScreenHeight(0),
-          mEGLContextInitialized(false)
-{}
+          mGLESVersion(0),
+          mEGLContextInitialized(false),
+          mConfigGLES3(false),
+          mRenderStats {},
+          mStateCache {}
+{
+    InvalidateStateCache();
+}
 
 GLState::~GLState() {
     DestroyContext();
@@ -34,44 +47,39 @@ bool GLState::InitEGLSurface() {
     mDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
     eglInitialize(mDisplay, 0, 0);
 
-    const EGLint attribs[] = {EGL_RENDERABLE_TYPE,
-                              EGL_OPENGL_ES2_BIT,
-                              EGL_SURFACE_TYPE,
-                              EGL_WINDOW_BIT,
-                              EGL_BLUE_SIZE,
-                              8,
-                              EGL_GREEN_SIZE,
-                              8,
-                              EGL_RED_SIZE,
-                              8,
-                              EGL_DEPTH_SIZE,
-                              24,
-                              EGL_NONE};
-    mColorSize = 8;
-    mDepthSize = 24;
-
-
-    EGLint num_configs;
-    eglChooseConfig(mDisplay, attribs, &mConfig, 1, &num_configs);
-
-    if (!num_configs) {
-        // 16bit depth buffer
-        const EGLint attribs[] = {EGL_RENDERABLE_TYPE,
-                                  EGL_OPENGL_ES2_BIT,
-                                  EGL_SURFACE_TYPE,
-                                  EGL_WINDOW_BIT,
-                                  EGL_BLUE_SIZE,
-                                  8,
-                                  EGL_GREEN_SIZE,
-                                  8,
-                                  EGL_RED_SIZE,
-                                  8,
-                                  EGL_DEPTH_SIZE,
-                                  16,
-                                  EGL_NONE};
-
-        eglChooseConfig(mDisplay, attribs, &mConfig, 1, &num_configs);
-        mDepthSize = 16;
+    // A GLES3 context needs a config that is ES3 renderable (EGL_KHR_create_context), strict drivers refuse it on an
+    // ES2 one. So ES3 configs come first; a plain ES2 config still gets a GLES2 context.
+    char const * pExtensions = eglQueryString(mDisplay, EGL_EXTENSIONS);
+    bool es3Configs = pExtensions && std::strstr(pExtensions, "EGL_KHR_create_context");
+    EGLint num_configs = 0;
+    for (EGLint renderableType : {EGL_OPENGL_ES3_BIT_KHR, EGL_OPENGL_ES2_BIT}) {
+        if (renderableType == EGL_OPENGL_ES3_BIT_KHR && !es3Configs)
+            continue;
+        // 24bit depth buffer, else 16bit
+        for (EGLint depthSize : {24, 16}) {
+            const EGLint attribs[] = {EGL_RENDERABLE_TYPE,
+                                      renderableType,
+                                      EGL_SURFACE_TYPE,
+                                      EGL_WINDOW_BIT,
+                                      EGL_BLUE_SIZE,
+                                      8,
+                                      EGL_GREEN_SIZE,
+                                      8,
+                                      EGL_RED_SIZE,
+                                      8,
+                                      EGL_DEPTH_SIZE,
+                                      depthSize,
+                                      EGL_NONE};
+            if (eglChooseConfig(mDisplay, attribs, &mConfig, 1, &num_configs) && num_configs) {
+                mColorSize = 8;
+                mDepthSize = depthSize;
+                mConfigGLES3 = renderableType == EGL_OPENGL_ES3_BIT_KHR;
+                break;
+            }
+            eglGetError();
+        }
+        if (num_configs)
+            break;
     }
 
     EGLint errorCode = eglGetError();
@@ -91,26 +99,43 @@ bool GLState::InitEGLSurface() {
 }
 
 bool GLState::InitEGLContext() {
-    const EGLint context_attribs[] = {EGL_CONTEXT_CLIENT_VERSION,
-                                      2,
-                                      EGL_NONE};
-    mContext = eglCreateContext(mDisplay, mConfig, NULL, context_attribs);
+    // Prefer GLES3 for instanced drawing, GLES2 devices still get a context.
+    for (EGLint version : {3, 2}) {
+        if (version == 3 && !mConfigGLES3)
+            continue;
+        const EGLint context_attribs[] = {EGL_CONTEXT_CLIENT_VERSION,
+                                          version,
+                                          EGL_NONE};
+        mContext = eglCreateContext(mDisplay, mConfig, NULL, context_attribs);
+        if (mContext != EGL_NO_CONTEXT) {
+            mGLESVersion = version;
+            break;
+        }
+        eglGetError();
+    }
 
     EGLint errorCode = eglGetError();
-    Log::info("GLCONTEXT INIT EGL CREATE CONTEXT %x", errorCode);
+    Log::info("GLCONTEXT INIT EGL CREATE CONTEXT %x, GLES %d", errorCode, mGLESVersion);
     assert(errorCode == EGL_SUCCESS);
 
     eglMakeCurrent(mDisplay, mSurface, mSurface, mContext);
+    InvalidateStateCache();
 
     errorCode = eglGetError();
     Log::info("GLCONTEXT INIT EGL MAKECURRENT %x", errorCode);
     assert(errorCode == EGL_SUCCESS);
 
+    // Frame pacing relies on eglSwapBuffers blocking on vsync.
+    eglSwapInterval(mDisplay, 1);
+
     mIsContextValid = true;
     return true;
 }
 
 EGLint GLState::Swap() {
+    PROFILE_SCOPE("GLState::Swap");
+    mRenderStats = {};
+
     EGLBoolean swapBuffersRes = eglSwapBuffers(mDisplay, mSurface);
 
     EGLint errorCode = eglGetError();
@@ -167,7 +192,7 @@ EGLint GLState::Resume() {
         eglQuerySurface(mDisplay, mSurface, EGL_HEIGHT, &mScreenHeight);
 
         eglMakeCurrent(mDisplay, mSurface, mSurface, mContext);
-
+        InvalidateStateCache();
     }
     else {
         Init();
@@ -193,6 +218,26 @@ void GLState::Suspend() {
     assert(errorCode == EGL_SUCCESS);
 }
 
+bool GLState::MakeCurrent() {
+    if (mDisplay == EGL_NO_DISPLAY || mContext == EGL_NO_CONTEXT || mSurface == EGL_NO_SURFACE)
+        return false;
+    if (eglMakeCurrent(mDisplay, mSurface, mSurface, mContext) != EGL_TRUE)
+        return false;
+
+    // Whoever had the context before may have changed anything behind the cache.
+    InvalidateStateCache();
+    return true;
+}
+
+void GLState::ReleaseCurrent() {
+    if (mDisplay != EGL_NO_DISPLAY)
+        eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+bool GLState::IsCurrent() const {
+    return mContext != EGL_NO_CONTEXT && eglGetCurrentContext() == mContext;
+}
+
 bool GLState::Invalidate() {
     DestroyContext();
 
@@ -214,3 +259,110 @@ bool GLState::CheckExtension(const char* extension) {
 
     return false;
 }
+
+void GLState::CheckGLError(const char* where) const {
+#ifndef NDEBUG
+    GLenum errorCode = glGetError();
+    if (errorCode == GL_NO_ERROR)
+        return;
+
+    while (errorCode != GL_NO_ERROR) {
+        Log::error("GL ERROR %x after %s", errorCode, where);
+        errorCode = glGetError();
+    }
+    assert(false);
+#else
+    (void)where;
+#endif
+}
+
+void GLState::InvalidateStateCache() {
+    GLuint const unknown = ~0u;
+
+    mStateCache.program = unknown;
+    mStateCache.activeTexture = unknown;
+    mStateCache.textures.fill(unknown);
+    mStateCache.vertexArray = unknown;
+    mStateCache.arrayBuffer = unknown;
+    mStateCache.blend = -1;
+    mStateCache.cullFace = -1;
+    mStateCache.depthTest = -1;
+    mStateCache.blendSource = unknown;
+    mStateCache.blendDestination = unknown;
+}
+
+template <typename T>
+bool GLState::ChangeState(T & cached, T value) {
+    if (cached == value) {
+        ++mRenderStats.redundantStateCalls;
+        return false;
+    }
+    cached = value;
+    ++mRenderStats.stateCalls;
+    return true;
+}
+
+void GLState::UseProgram(GLuint program) {
+    if (ChangeState(mStateCache.program, program))
+        glUseProgram(program);
+}
+
+void GLState::ActiveTexture(GLenum unit) {
+    assert(unit >= GL_TEXTURE0 && unit < GL_TEXTURE0 + GL_STATE_TEXTURE_UNITS);
+    if (ChangeState(mStateCache.activeTexture, unit))
+        glActiveTexture(unit);
+}
+
+void GLState::BindTexture2D(GLuint texture) {
+    // Unit unknown: bind through GL_TEXTURE0 so there is a slot to remember it in.
+    if (mStateCache.activeTexture - GL_TEXTURE0 >= GL_STATE_TEXTURE_UNITS)
+        ActiveTexture(GL_TEXTURE0);
+
+    if (ChangeState(mStateCache.textures[mStateCache.activeTexture - GL_TEXTURE0], texture)) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        CountTextureBind();
+    }
+}
+
+void GLState::BindVertexArray(GLuint vertexArray) {
+    if (ChangeState(mStateCache.vertexArray, vertexArray))
+        glBindVertexArray(vertexArray);
+}
+
+void GLState::BindArrayBuffer(GLuint buffer) {
+    if (ChangeState(mStateCache.arrayBuffer, buffer))
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+}
+
+void GLState::SetCapability(GLenum capability, int8_t & cached, bool enabled) {
+    if (!ChangeState(cached, static_cast<int8_t>(enabled)))
+        return;
+
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
+
+void GLState::SetBlend(bool enabled) {
+    SetCapability(GL_BLEND, mStateCache.blend, enabled);
+}
+
+void GLState::SetCullFace(bool enabled) {
+    SetCapability(GL_CULL_FACE, mStateCache.cullFace, enabled);
+}
+
+void GLState::SetDepthTest(bool enabled) {
+    SetCapability(GL_DEPTH_TEST, mStateCache.depthTest, enabled);
+}
+
+void GLState::BlendFunc(GLenum source, GLenum destination) {
+    if (mStateCache.blendSource == source && mStateCache.blendDestination == destination) {
+        ++mRenderStats.redundantStateCalls;
+        return;
+    }
+    mStateCache.blendSource = source;
+    mStateCache.blendDestination = destination;
+    ++mRenderStats.stateCalls;
+    glBlendFunc(source, destination);
+}
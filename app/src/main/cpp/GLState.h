@@ -1,8 +1,37 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
 
+size_t const GL_STATE_TEXTURE_UNITS = 8;
+
+struct RenderStats {
+    uint32_t drawCalls;
+    uint32_t textureBinds;
+    uint32_t streamedBytes;
+    uint32_t stateCalls;            // state changes the cache passed on to GL
+    uint32_t redundantStateCalls;   // state changes the cache dropped
+};
+
+// Shadow copy of the GL state the 2D renderers touch. InvalidateStateCache() marks every field unknown: -1 for the
+// enables, ~0 for names and enums no real call asks for.
+struct GLStateCache {
+    GLuint program;
+    GLenum activeTexture;
+    std::array<GLuint, GL_STATE_TEXTURE_UNITS> textures;
+    GLuint vertexArray;
+    GLuint arrayBuffer;
+    int8_t blend;
+    int8_t cullFace;
+    int8_t depthTest;
+    GLenum blendSource;
+    GLenum blendDestination;
+};
+
 class GLState {
 public:
     static GLState & GetInstance() {
@@ -25,6 +54,12 @@ public:
     void Suspend();
     EGLint Resume();
 
+    // Binds the context to the calling thread; false while there is no context or window surface.
+    bool MakeCurrent();
+    void ReleaseCurrent();
+    // Whether the context is current on the calling thread, i.e. whether GL calls made here take effect.
+    bool IsCurrent() const;
+
     bool IsInitialized() const { return mEGLContextInitialized; }
 
     int32_t GetScreenWidth() const { return mScreenWidth; }
@@ -33,8 +68,34 @@ public:
     int32_t GetBufferColorSize() const { return mColorSize; }
     int32_t GetBufferDepthSize() const { return mDepthSize; }
 
+    // Client version of the context actually created, 3 when available.
+    int32_t GetGLESVersion() const { return mGLESVersion; }
+
     bool CheckExtension(const char* extension);
 
+    // Debug builds only: drains glGetError and asserts, tagging the message with where it was called from.
+    void CheckGLError(const char* where) const;
+
+    // Counters of the frame being recorded; cleared by Swap().
+    void CountDrawCall() { ++mRenderStats.drawCalls; }
+    void CountTextureBind() { ++mRenderStats.textureBinds; }
+    void CountStreamedBytes(uint32_t bytes) { mRenderStats.streamedBytes += bytes; }
+    RenderStats const & GetRenderStats() const { return mRenderStats; }
+
+    // Cached state setters. Each one is a no-op, counted as redundant, when GL is known to be in that state already.
+    // Code that changes the same state with raw GL calls must call InvalidateStateCache() afterwards; moving the
+    // context to another thread or recreating it does that already.
+    void InvalidateStateCache();
+    void UseProgram(GLuint program);
+    void ActiveTexture(GLenum unit);
+    void BindTexture2D(GLuint texture);
+    void BindVertexArray(GLuint vertexArray);
+    void BindArrayBuffer(GLuint buffer);
+    void SetBlend(bool enabled);
+    void SetCullFace(bool enabled);
+    void SetDepthTest(bool enabled);
+    void BlendFunc(GLenum source, GLenum destination);
+
     EGLDisplay GetDisplay() const { return mDisplay; }
     EGLSurface GetSurface() const { return mSurface; }
 
@@ -51,11 +112,20 @@ private:
     int32_t mScreenHeight;
     int32_t mColorSize;
     int32_t mDepthSize;
+    int32_t mGLESVersion;
 
     // Flags
     bool mEGLContextInitialized;
+    bool mConfigGLES3;              // mConfig is ES3 renderable
     bool mIsContextValid;
 
+    RenderStats mRenderStats;
+    GLStateCache mStateCache;
+
+    template <typename T>
+    bool ChangeState(T & cached, T value);
+    void SetCapability(GLenum capability, int8_t & cached, bool enabled);
+
     void DestroyContext();
     bool InitEGLSurface();
     bool InitEGLContext();
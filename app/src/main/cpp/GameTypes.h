@@ -18,14 +18,11 @@ enum class GameState {
     FINISH
 };
 
+// Glyph metrics of a FontAtlas, in pixels at SDF_GLYPH_PIXEL_SIZE; renderers scale them to their font size.
 struct FTCharacter {
-    GLuint      mId;
     FT_UInt     index;
-    FT_Glyph    glyph;
-    FT_Vector   delta;
-    int32_t     belowBaseline;
-    int32_t     bearingY;
-    glm::vec2   size;
+    glm::vec2   size;       // ink box
+    glm::vec2   bearing;    // left and top of the ink box from the pen on the baseline, y up
 };
 
 
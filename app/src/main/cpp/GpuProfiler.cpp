@@ -0,0 +1,199 @@
+#include <cstring>
+
+#include "GpuProfiler.h"
+#include "GLState.h"
+#include "Log.h"
+
+char const * GpuPassToStr(GpuPass pass) {
+    switch (pass) {
+        case GpuPass::FRAME:   return "FRAME";
+        case GpuPass::SPRITES: return "SPRITES";
+        case GpuPass::TEXT:    return "TEXT";
+        default:               return "UNKNOWN";
+    }
+}
+
+GpuProfiler::GpuProfiler() : mGenQueries {nullptr},
+                             mDeleteQueries {nullptr},
+                             mBeginQuery {nullptr},
+                             mEndQuery {nullptr},
+                             mQueryCounter {nullptr},
+                             mGetQueryiv {nullptr},
+                             mGetQueryObjectuiv {nullptr},
+                             mGetQueryObjectui64v {nullptr},
+                             mFrames {},
+                             mCurrentFrame {},
+                             mAvailable {false},
+                             mUseTimestamps {false},
+                             mInsideElapsedQuery {false},
+                             mPassTimeMs {},
+                             mResolvedFrames {}
+{}
+
+bool GpuProfiler::Init() {
+    if (mAvailable)
+        return true;
+
+    if (!GLState::GetInstance().CheckExtension("GL_EXT_disjoint_timer_query")) {
+        Log::info("GpuProfiler: GL_EXT_disjoint_timer_query not supported, GPU timing disabled");
+        return false;
+    }
+
+    mGenQueries = reinterpret_cast<PFNGLGENQUERIESEXTPROC>(eglGetProcAddress("glGenQueriesEXT"));
+    mDeleteQueries = reinterpret_cast<PFNGLDELETEQUERIESEXTPROC>(eglGetProcAddress("glDeleteQueriesEXT"));
+    mBeginQuery = reinterpret_cast<PFNGLBEGINQUERYEXTPROC>(eglGetProcAddress("glBeginQueryEXT"));
+    mEndQuery = reinterpret_cast<PFNGLENDQUERYEXTPROC>(eglGetProcAddress("glEndQueryEXT"));
+    mQueryCounter = reinterpret_cast<PFNGLQUERYCOUNTEREXTPROC>(eglGetProcAddress("glQueryCounterEXT"));
+    mGetQueryiv = reinterpret_cast<PFNGLGETQUERYIVEXTPROC>(eglGetProcAddress("glGetQueryivEXT"));
+    mGetQueryObjectuiv = reinterpret_cast<PFNGLGETQUERYOBJECTUIVEXTPROC>(eglGetProcAddress("glGetQueryObjectuivEXT"));
+    mGetQueryObjectui64v = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VEXTPROC>(eglGetProcAddress("glGetQueryObjectui64vEXT"));
+
+    if (!mGenQueries || !mDeleteQueries || !mBeginQuery || !mEndQuery ||
+        !mGetQueryiv || !mGetQueryObjectuiv || !mGetQueryObjectui64v) {
+        Log::warn("GpuProfiler: timer query entry points missing, GPU timing disabled");
+        return false;
+    }
+
+    GLint timestampBits {};
+    if (mQueryCounter)
+        mGetQueryiv(GL_TIMESTAMP_EXT, GL_QUERY_COUNTER_BITS_EXT, &timestampBits);
+    mUseTimestamps = timestampBits > 0;
+
+    for (auto & frame : mFrames) {
+        mGenQueries(QUERY_COUNT, frame.queries);
+        memset(frame.issued, 0, sizeof(frame.issued));
+        frame.pending = false;
+    }
+
+    // Reading the flag clears it, so earlier disjoint events do not invalidate the first results.
+    GLint disjoint {};
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+    mCurrentFrame = 0;
+    mInsideElapsedQuery = false;
+    mAvailable = true;
+    Log::info("GpuProfiler: enabled, %s queries", mUseTimestamps ? "timestamp" : "elapsed time");
+    return true;
+}
+
+void GpuProfiler::Release() {
+    if (!mAvailable)
+        return;
+
+    for (auto & frame : mFrames)
+        mDeleteQueries(QUERY_COUNT, frame.queries);
+
+    mAvailable = false;
+}
+
+void GpuProfiler::BeginFrame() {
+    if (!mAvailable)
+        return;
+
+    mCurrentFrame = (mCurrentFrame + 1) % GPU_PROFILER_LATENCY;
+    FrameQueries & frame = mFrames[mCurrentFrame];
+    Resolve(frame);
+    memset(frame.issued, 0, sizeof(frame.issued));
+
+    BeginPass(GpuPass::FRAME);
+}
+
+void GpuProfiler::EndFrame() {
+    if (!mAvailable)
+        return;
+
+    EndPass(GpuPass::FRAME);
+    mFrames[mCurrentFrame].pending = true;
+}
+
+void GpuProfiler::BeginPass(GpuPass pass) {
+    if (!mAvailable)
+        return;
+
+    FrameQueries & frame = mFrames[mCurrentFrame];
+    size_t index = static_cast<size_t>(pass);
+
+    if (mUseTimestamps) {
+        mQueryCounter(frame.queries[index * 2], GL_TIMESTAMP_EXT);
+        return;
+    }
+
+    // Elapsed queries can't nest, so the frame itself is only timed through its passes.
+    if (pass == GpuPass::FRAME || mInsideElapsedQuery)
+        return;
+    mBeginQuery(GL_TIME_ELAPSED_EXT, frame.queries[index * 2]);
+    mInsideElapsedQuery = true;
+}
+
+void GpuProfiler::EndPass(GpuPass pass) {
+    if (!mAvailable)
+        return;
+
+    FrameQueries & frame = mFrames[mCurrentFrame];
+    size_t index = static_cast<size_t>(pass);
+
+    if (mUseTimestamps) {
+        mQueryCounter(frame.queries[index * 2 + 1], GL_TIMESTAMP_EXT);
+        frame.issued[index] = true;
+        return;
+    }
+
+    if (pass == GpuPass::FRAME || !mInsideElapsedQuery)
+        return;
+    mEndQuery(GL_TIME_ELAPSED_EXT);
+    mInsideElapsedQuery = false;
+    frame.issued[index] = true;
+}
+
+void GpuProfiler::Resolve(FrameQueries & frame) {
+    if (!frame.pending)
+        return;
+    frame.pending = false;
+
+    for (size_t pass = 0; pass < PASS_COUNT; ++pass) {
+        if (!frame.issued[pass])
+            continue;
+
+        GLuint available {};
+        GLuint lastQuery = mUseTimestamps ? frame.queries[pass * 2 + 1] : frame.queries[pass * 2];
+        mGetQueryObjectuiv(lastQuery, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+        if (!available)
+            return;
+    }
+
+    GLint disjoint {};
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    if (disjoint)
+        return;
+
+    double frameMs = 0.0;
+    for (size_t pass = 0; pass < PASS_COUNT; ++pass) {
+        if (!frame.issued[pass])
+            continue;
+
+        GLuint64 elapsedNs {};
+        if (mUseTimestamps) {
+            GLuint64 beginNs {};
+            GLuint64 endNs {};
+            mGetQueryObjectui64v(frame.queries[pass * 2], GL_QUERY_RESULT_EXT, &beginNs);
+            mGetQueryObjectui64v(frame.queries[pass * 2 + 1], GL_QUERY_RESULT_EXT, &endNs);
+            elapsedNs = endNs > beginNs ? endNs - beginNs : 0;
+        }
+        else {
+            mGetQueryObjectui64v(frame.queries[pass * 2], GL_QUERY_RESULT_EXT, &elapsedNs);
+        }
+
+        mPassTimeMs[pass] = static_cast<double>(elapsedNs) * 1.0e-6;
+        if (pass != static_cast<size_t>(GpuPass::FRAME))
+            frameMs += mPassTimeMs[pass];
+    }
+
+    if (!mUseTimestamps)
+        mPassTimeMs[static_cast<size_t>(GpuPass::FRAME)] = frameMs;
+
+    ++mResolvedFrames;
+    Log_trace("GPU frame %.3f ms, sprites %.3f ms, text %.3f ms",
+              mPassTimeMs[static_cast<size_t>(GpuPass::FRAME)],
+              mPassTimeMs[static_cast<size_t>(GpuPass::SPRITES)],
+              mPassTimeMs[static_cast<size_t>(GpuPass::TEXT)]);
+}
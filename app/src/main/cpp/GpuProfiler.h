@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+#include <GLES2/gl2ext.h>
+
+enum class GpuPass : uint8_t {
+    FRAME,
+    SPRITES,
+    TEXT,
+    COUNT
+};
+
+char const * GpuPassToStr(GpuPass pass);
+
+//---------------------------------------------------------------------------------------------------------------------
+// GpuProfiler
+// Optional GPU pass timing through EXT_disjoint_timer_query. Queries are kept in a small ring of frames and read back
+// GPU_PROFILER_LATENCY frames later; if a result is still not available it is dropped rather than waited for.
+// Timestamp queries are used when the driver exposes them, otherwise TIME_ELAPSED queries time the passes and the
+// frame is reported as their sum. Without the extension every call is a no-op.
+//---------------------------------------------------------------------------------------------------------------------
+class GpuProfiler {
+public:
+    static GpuProfiler & GetInstance() {
+        static GpuProfiler instance;
+        return instance;
+    }
+
+private:
+    GpuProfiler();
+    GpuProfiler(GpuProfiler const &) = delete;
+    GpuProfiler & operator=(GpuProfiler const &) = delete;
+
+public:
+    ~GpuProfiler() = default;
+
+    // Needs a current GL context.
+    bool Init();
+    void Release();
+
+    void BeginFrame();
+    void EndFrame();
+    void BeginPass(GpuPass pass);
+    void EndPass(GpuPass pass);
+
+    bool IsAvailable() const { return mAvailable; }
+    double GetPassTimeMs(GpuPass pass) const { return mPassTimeMs[static_cast<size_t>(pass)]; }
+    uint32_t GetResolvedFrames() const { return mResolvedFrames; }
+
+private:
+    static size_t const GPU_PROFILER_LATENCY = 4;
+    static size_t const PASS_COUNT = static_cast<size_t>(GpuPass::COUNT);
+    static size_t const QUERY_COUNT = PASS_COUNT * 2;
+
+    struct FrameQueries {
+        GLuint  queries[QUERY_COUNT];       // begin / end timestamp per pass, or one elapsed query per pass
+        bool    issued[PASS_COUNT];
+        bool    pending;
+    };
+
+    void Resolve(FrameQueries & frame);
+
+private:
+    PFNGLGENQUERIESEXTPROC              mGenQueries;
+    PFNGLDELETEQUERIESEXTPROC           mDeleteQueries;
+    PFNGLBEGINQUERYEXTPROC              mBeginQuery;
+    PFNGLENDQUERYEXTPROC                mEndQuery;
+    PFNGLQUERYCOUNTEREXTPROC            mQueryCounter;
+    PFNGLGETQUERYIVEXTPROC              mGetQueryiv;
+    PFNGLGETQUERYOBJECTUIVEXTPROC       mGetQueryObjectuiv;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC     mGetQueryObjectui64v;
+
+    FrameQueries mFrames[GPU_PROFILER_LATENCY];
+    size_t mCurrentFrame;
+    bool mAvailable;
+    bool mUseTimestamps;
+    bool mInsideElapsedQuery;
+    double mPassTimeMs[PASS_COUNT];
+    uint32_t mResolvedFrames;
+};
+
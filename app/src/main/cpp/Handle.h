@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+uint32_t const HANDLE_INDEX_BITS = 20;     // a million slots per pool, 4096 generations before a slot's handles repeat
+uint32_t const HANDLE_INDEX_MASK = (1u << HANDLE_INDEX_BITS) - 1;
+uint32_t const HANDLE_GENERATION_MASK = (1u << (32 - HANDLE_INDEX_BITS)) - 1;
+
+// A T in a HandlePool: the slot's index in the low HANDLE_INDEX_BITS, its generation above. Zero is the null handle.
+template <typename T>
+struct Handle {
+    uint32_t value;
+
+    uint32_t GetIndex() const { return value & HANDLE_INDEX_MASK; }
+    uint32_t GetGeneration() const { return value >> HANDLE_INDEX_BITS; }
+    bool IsNull() const { return value == 0; }
+
+    bool operator==(Handle other) const { return value == other.value; }
+    bool operator!=(Handle other) const { return value != other.value; }
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// HandlePool
+// Owns Ts in slots of a dense array and hands out Handles to them. Resolving a handle is an index and a generation
+// compare, nothing is counted. Removing a T bumps its slot's generation, so handles still held to it resolve to nullptr
+// rather than to whatever takes the slot next. Ts never move, pointers to them last until they are removed.
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T>
+class HandlePool {
+public:
+    HandlePool() : mItems {}, mGenerations {}, mFree {}, mCount {} {}
+    HandlePool(HandlePool const &) = delete;
+    HandlePool & operator=(HandlePool const &) = delete;
+
+    Handle<T> Add(std::unique_ptr<T> ptrItem) {
+        uint32_t index;
+        if (!mFree.empty()) {
+            index = mFree.back();
+            mFree.pop_back();
+        }
+        else {
+            index = static_cast<uint32_t>(mItems.size());
+            if (index > HANDLE_INDEX_MASK)
+                return {};
+            mItems.emplace_back();
+            mGenerations.push_back(1);
+        }
+        mItems[index] = std::move(ptrItem);
+        ++mCount;
+        return {mGenerations[index] << HANDLE_INDEX_BITS | index};
+    }
+
+    void Remove(Handle<T> handle) {
+        if (!Get(handle))
+            return;
+        uint32_t index = handle.GetIndex();
+        mItems[index].reset();
+        // Generation 0 is skipped, it would make the first slot's handle null.
+        mGenerations[index] = (mGenerations[index] + 1) & HANDLE_GENERATION_MASK;
+        if (mGenerations[index] == 0)
+            mGenerations[index] = 1;
+        mFree.push_back(index);
+        --mCount;
+    }
+
+    // nullptr for the null handle and for handles to removed Ts.
+    T * Get(Handle<T> handle) const {
+        uint32_t index = handle.GetIndex();
+        if (index >= mItems.size() || mGenerations[index] != handle.GetGeneration())
+            return nullptr;
+        return mItems[index].get();
+    }
+
+    // Removes every T; handles to them go stale like with Remove.
+    void Clear() {
+        for (uint32_t index = 0; index < mItems.size(); ++index) {
+            if (mItems[index])
+                Remove({mGenerations[index] << HANDLE_INDEX_BITS | index});
+        }
+    }
+
+    size_t GetSize() const { return mCount; }
+
+    // Calls function(Handle<T>, T &) for every T, in slot order.
+    template <typename Function>
+    void ForEach(Function function) const {
+        for (uint32_t index = 0; index < mItems.size(); ++index) {
+            if (mItems[index])
+                function(Handle<T> {mGenerations[index] << HANDLE_INDEX_BITS | index}, *mItems[index]);
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<T>> mItems;
+    std::vector<uint32_t> mGenerations;
+    std::vector<uint32_t> mFree;
+    size_t mCount;
+};
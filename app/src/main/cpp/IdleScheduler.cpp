@@ -0,0 +1,95 @@
+#include "IdleScheduler.h"
+#include "TimeManager.h"
+#include "Profiler.h"
+#include "Log.h"
+
+// Assumed cost of a slice that has never run.
+uint64_t const IDLE_FIRST_SLICE_ESTIMATE_NS = 500000;
+// A task passed over for not fitting has its estimate cut by 1/this: a quarter, so a 50 ms estimate is back under 2 ms
+// within a dozen frames.
+uint64_t const IDLE_SKIPPED_ESTIMATE_DECAY = 4;
+
+IdleScheduler::IdleScheduler() : mQueues {},
+                                 mNextId {1}
+{}
+
+uint32_t IdleScheduler::Post(IdlePriority priority, char const * name, IdleTask task) {
+    uint32_t id = mNextId++;
+    mQueues[static_cast<size_t>(priority)].push_back({id, name, std::move(task), IDLE_FIRST_SLICE_ESTIMATE_NS});
+    Log_debug("IdleScheduler: %s posted", name);
+    return id;
+}
+
+bool IdleScheduler::Cancel(uint32_t id) {
+    for (auto & queue : mQueues) {
+        for (auto it = queue.begin(); it != queue.end(); ++it) {
+            if (it->id == id) {
+                queue.erase(it);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void IdleScheduler::Clear() {
+    for (auto & queue : mQueues)
+        queue.clear();
+}
+
+uint32_t IdleScheduler::Run(uint64_t deadlineNs) {
+    PROFILE_SCOPE("IdleScheduler::Run");
+    uint32_t slices = 0;
+
+    for (auto & queue : mQueues) {
+        // Every task of this priority gets at most one slice per pass, so a long task can't starve the others.
+        size_t pending = queue.size();
+        while (pending-- > 0) {
+            uint64_t nowNs = TimeManager::GetTimeNowNs();
+            if (nowNs >= deadlineNs)
+                return slices;
+
+            Task task = std::move(queue.front());
+            queue.pop_front();
+            if (nowNs + task.averageSliceNs >= deadlineNs) {
+                // Doesn't fit, the next task or a lower priority one may. The estimate decays so that one slow slice
+                // (file I/O, a page fault) can't keep the task out for good once it exceeds any frame's idle time.
+                task.averageSliceNs -= task.averageSliceNs / IDLE_SKIPPED_ESTIMATE_DECAY;
+                queue.push_back(std::move(task));
+                continue;
+            }
+
+            bool finished = task.task(deadlineNs);
+            uint64_t sliceNs = TimeManager::GetTimeNowNs() - nowNs;
+            ++slices;
+
+            if (finished) {
+                Log_debug("IdleScheduler: %s finished", task.name);
+                continue;
+            }
+
+            task.averageSliceNs = (task.averageSliceNs * 3 + sliceNs) / 4;
+            queue.push_back(std::move(task));
+        }
+    }
+
+    return slices;
+}
+
+void IdleScheduler::Flush() {
+    PROFILE_SCOPE("IdleScheduler::Flush");
+    for (auto & queue : mQueues) {
+        while (!queue.empty()) {
+            Task task = std::move(queue.front());
+            queue.pop_front();
+            while (!task.task(UINT64_MAX)) {}
+        }
+    }
+}
+
+size_t IdleScheduler::GetPendingCount() const {
+    size_t count = 0;
+    for (auto const & queue : mQueues)
+        count += queue.size();
+    return count;
+}
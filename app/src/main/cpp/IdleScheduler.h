@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+enum class IdlePriority : uint8_t {
+    HIGH,
+    NORMAL,
+    LOW,
+    COUNT
+};
+
+// One slice of an idle task. It should return well before deadlineNs; returning false keeps the task queued and it is
+// called again in a later frame.
+using IdleTask = std::function<bool(uint64_t deadlineNs)>;
+
+//---------------------------------------------------------------------------------------------------------------------
+// IdleScheduler
+// Runs small, resumable background jobs in the time a frame leaves before its deadline. Higher priorities go first,
+// tasks of the same priority take turns. A slice is only started if its running average cost still fits before the
+// deadline, so background work never pushes a frame past vsync; a task that doesn't fit is passed over for the rest of
+// the frame, not the tasks behind it. Main thread only.
+//---------------------------------------------------------------------------------------------------------------------
+class IdleScheduler {
+public:
+    static IdleScheduler & GetInstance() {
+        static IdleScheduler instance;
+        return instance;
+    }
+
+private:
+    IdleScheduler();
+    IdleScheduler(IdleScheduler const &) = delete;
+    IdleScheduler & operator=(IdleScheduler const &) = delete;
+
+public:
+    ~IdleScheduler() = default;
+
+    // name must point to a string literal. Returns an id for Cancel().
+    uint32_t Post(IdlePriority priority, char const * name, IdleTask task);
+    bool Cancel(uint32_t id);
+    void Clear();
+
+    // Runs slices until deadlineNs is close. Returns the number of slices run.
+    uint32_t Run(uint64_t deadlineNs);
+    // Runs every task to completion regardless of time, for when no frame is waiting (e.g. focus lost).
+    void Flush();
+
+    size_t GetPendingCount() const;
+
+private:
+    static size_t const PRIORITY_COUNT = static_cast<size_t>(IdlePriority::COUNT);
+
+    struct Task {
+        uint32_t        id;
+        char const *    name;
+        IdleTask        task;
+        uint64_t        averageSliceNs;
+    };
+
+private:
+    std::array<std::deque<Task>, PRIORITY_COUNT> mQueues;
+    uint32_t mNextId;
+};
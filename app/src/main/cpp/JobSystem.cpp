@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <string>
+
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Log.h"
+
+size_t const JOB_MAX_WORKERS = 7;
+uint32_t const JOB_SPINS_BEFORE_SLEEP = 64;
+auto const JOB_SLEEP_TIMEOUT = std::chrono::milliseconds(4);
+
+size_t const NOT_A_JOB_THREAD = SIZE_MAX;
+static thread_local size_t tThreadIndex = NOT_A_JOB_THREAD;
+
+static_assert((JOB_DEQUE_CAPACITY & (JOB_DEQUE_CAPACITY - 1)) == 0, "JOB_DEQUE_CAPACITY must be a power of two");
+
+JobSystem::JobDeque::JobDeque() : mBottom {0},
+                                  mPadding {},
+                                  mTop {0},
+                                  mJobs {new std::atomic<Job*>[JOB_DEQUE_CAPACITY]}
+{}
+
+bool JobSystem::JobDeque::Push(Job * ptrJob) {
+    int64_t bottom = mBottom.load(std::memory_order_relaxed);
+    int64_t top = mTop.load(std::memory_order_acquire);
+    if (bottom - top >= static_cast<int64_t>(JOB_DEQUE_CAPACITY))
+        return false;
+
+    mJobs[bottom & (JOB_DEQUE_CAPACITY - 1)].store(ptrJob, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    mBottom.store(bottom + 1, std::memory_order_relaxed);
+    return true;
+}
+
+JobSystem::Job * JobSystem::JobDeque::Pop() {
+    int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+    mBottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = mTop.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+        mBottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job * ptrJob = mJobs[bottom & (JOB_DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (top == bottom) {
+        // Last job, a thief may be taking it right now; whoever moves top wins.
+        if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            ptrJob = nullptr;
+        mBottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return ptrJob;
+}
+
+JobSystem::Job * JobSystem::JobDeque::Steal() {
+    int64_t top = mTop.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = mBottom.load(std::memory_order_acquire);
+    if (top >= bottom)
+        return nullptr;
+
+    Job * ptrJob = mJobs[top & (JOB_DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr;
+    return ptrJob;
+}
+
+JobSystem::JobSystem() : mThreads {},
+                         mWorkers {},
+                         mRunning {false},
+                         mQueuedJobs {0},
+                         mSleepingWorkers {0},
+                         mWakeMutex {},
+                         mWakeCondition {}
+{}
+
+JobSystem::~JobSystem() {
+    Shutdown();
+}
+
+void JobSystem::Init(size_t workerCount) {
+    if (mRunning.load())
+        return;
+
+    if (workerCount == 0) {
+        size_t cores = std::thread::hardware_concurrency();
+        workerCount = std::min(std::max<size_t>(cores, 2) - 1, JOB_MAX_WORKERS);
+    }
+
+    mThreads.clear();
+    for (size_t index = 0; index <= workerCount; ++index) {
+        std::unique_ptr<ThreadData> ptrThread {new ThreadData};
+        ptrThread->jobs.reset(new Job[JOB_POOL_CAPACITY]);
+        ptrThread->nextJob = 0;
+        ptrThread->random = static_cast<uint32_t>(index * 2654435761u + 1);
+        mThreads.push_back(std::move(ptrThread));
+    }
+
+    tThreadIndex = 0;
+    mRunning.store(true);
+    for (size_t index = 1; index <= workerCount; ++index)
+        mWorkers.emplace_back(&JobSystem::WorkerLoop, this, index);
+
+    Log::info("JobSystem: %zu workers", workerCount);
+}
+
+void JobSystem::Shutdown() {
+    if (!mRunning.load())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mRunning.store(false);
+    }
+    mWakeCondition.notify_all();
+    for (auto & worker : mWorkers)
+        worker.join();
+
+    mWorkers.clear();
+    mThreads.clear();
+    mQueuedJobs.store(0);
+    tThreadIndex = NOT_A_JOB_THREAD;
+}
+
+bool JobSystem::IsJobThread() const {
+    return tThreadIndex != NOT_A_JOB_THREAD && mRunning.load(std::memory_order_relaxed);
+}
+
+JobSystem::Job * JobSystem::AllocateJob(ThreadData & thread) {
+    // Jobs are recycled in submission order; a slot is only reused after JOB_POOL_CAPACITY newer jobs, by which time
+    // the frame that queued it has long waited for it.
+    Job * ptrJob = &thread.jobs[thread.nextJob];
+    thread.nextJob = (thread.nextJob + 1) % JOB_POOL_CAPACITY;
+    return ptrJob;
+}
+
+void JobSystem::Submit(ThreadData & thread, Job * ptrJob) {
+    if (!thread.deque.Push(ptrJob)) {
+        Log_warn("JobSystem: deque full, running job inline");
+        Execute(ptrJob);
+        return;
+    }
+
+    mQueuedJobs.fetch_add(1);
+    if (mSleepingWorkers.load() > 0) {
+        // Taking the lock orders this against a worker that has checked for jobs but not started waiting yet.
+        { std::lock_guard<std::mutex> lock(mWakeMutex); }
+        mWakeCondition.notify_one();
+    }
+}
+
+void JobSystem::Run(JobCounter & counter, JobFunction function, JobCounter * ptrDependency) {
+    if (!IsJobThread()) {
+        if (ptrDependency)
+            Wait(*ptrDependency);
+        function();
+        return;
+    }
+
+    counter.mPending.fetch_add(1, std::memory_order_relaxed);
+
+    ThreadData & thread = *mThreads[tThreadIndex];
+    Job * ptrJob = AllocateJob(thread);
+    ptrJob->function = std::move(function);
+    ptrJob->ptrRangeFunction = nullptr;
+    ptrJob->ptrCounter = &counter;
+    ptrJob->ptrDependency = ptrDependency;
+    Submit(thread, ptrJob);
+}
+
+void JobSystem::ParallelFor(size_t count, size_t batchSize, JobRangeFunction const & function) {
+    batchSize = std::max<size_t>(batchSize, 1);
+    if (count <= batchSize || !IsJobThread() || mWorkers.empty()) {
+        if (count > 0)
+            function(0, count);
+        return;
+    }
+
+    JobCounter counter;
+    ThreadData & thread = *mThreads[tThreadIndex];
+    for (size_t begin = batchSize; begin < count; begin += batchSize) {
+        counter.mPending.fetch_add(1, std::memory_order_relaxed);
+        Job * ptrJob = AllocateJob(thread);
+        ptrJob->function = nullptr;
+        ptrJob->ptrRangeFunction = &function;
+        ptrJob->begin = begin;
+        ptrJob->end = std::min(begin + batchSize, count);
+        ptrJob->ptrCounter = &counter;
+        ptrJob->ptrDependency = nullptr;
+        Submit(thread, ptrJob);
+    }
+
+    function(0, batchSize);
+    Wait(counter);
+}
+
+void JobSystem::Wait(JobCounter & counter) {
+    if (!IsJobThread()) {
+        while (!counter.IsDone())
+            std::this_thread::yield();
+        return;
+    }
+
+    PROFILE_SCOPE("JobSystem::Wait");
+    while (!counter.IsDone()) {
+        if (!RunOneJob(tThreadIndex))
+            std::this_thread::yield();
+    }
+}
+
+bool JobSystem::RunOneJob(size_t threadIndex) {
+    ThreadData & thread = *mThreads[threadIndex];
+    Job * ptrJob = thread.deque.Pop();
+
+    if (!ptrJob) {
+        // Start at a random victim so thieves don't all hammer the same deque.
+        size_t threadCount = mThreads.size();
+        thread.random = thread.random * 1664525u + 1013904223u;
+        size_t first = (thread.random >> 8) % threadCount;
+        for (size_t offset = 0; offset < threadCount && !ptrJob; ++offset) {
+            size_t victim = (first + offset) % threadCount;
+            if (victim != threadIndex)
+                ptrJob = mThreads[victim]->deque.Steal();
+        }
+    }
+
+    if (!ptrJob)
+        return false;
+    mQueuedJobs.fetch_sub(1);
+
+    if (ptrJob->ptrDependency && !ptrJob->ptrDependency->IsDone()) {
+        // Not ready yet: park it on this thread's deque and report no progress so the caller backs off.
+        Submit(thread, ptrJob);
+        return false;
+    }
+
+    Execute(ptrJob);
+    return true;
+}
+
+void JobSystem::Execute(Job * ptrJob) {
+    if (ptrJob->ptrRangeFunction)
+        (*ptrJob->ptrRangeFunction)(ptrJob->begin, ptrJob->end);
+    else
+        ptrJob->function();
+
+    ptrJob->ptrCounter->mPending.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::WorkerLoop(size_t threadIndex) {
+    tThreadIndex = threadIndex;
+    std::string name = "Worker " + std::to_string(threadIndex);
+    Profiler::GetInstance().SetThreadName(name.c_str());
+
+    uint32_t idleSpins = 0;
+    while (mRunning.load(std::memory_order_relaxed)) {
+        if (RunOneJob(threadIndex)) {
+            idleSpins = 0;
+            continue;
+        }
+
+        if (++idleSpins < JOB_SPINS_BEFORE_SLEEP) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mWakeMutex);
+        mSleepingWorkers.fetch_add(1);
+        mWakeCondition.wait_for(lock, JOB_SLEEP_TIMEOUT, [this] {
+            return !mRunning.load() || mQueuedJobs.load() > 0;
+        });
+        mSleepingWorkers.fetch_sub(1);
+        idleSpins = 0;
+    }
+}
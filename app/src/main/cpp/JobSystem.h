@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+size_t const JOB_DEQUE_CAPACITY = 4096;        // per thread, power of two
+size_t const JOB_POOL_CAPACITY = 4096;         // jobs a thread can have in flight before its pool wraps
+
+using JobFunction = std::function<void()>;
+using JobRangeFunction = std::function<void(size_t begin, size_t end)>;
+
+//---------------------------------------------------------------------------------------------------------------------
+// JobCounter
+// Number of unfinished jobs in a group. Every Run() adds one, every finished job takes one away; Wait() and job
+// dependencies watch it reach zero. A counter must outlive the jobs it counts.
+//---------------------------------------------------------------------------------------------------------------------
+class JobCounter {
+public:
+    JobCounter() : mPending {0} {}
+    JobCounter(JobCounter const &) = delete;
+    JobCounter & operator=(JobCounter const &) = delete;
+
+    bool IsDone() const { return mPending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    std::atomic<uint32_t> mPending;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// JobSystem
+// Fixed pool of worker threads, one Chase-Lev deque per thread. A thread pushes and pops its own jobs at the bottom of
+// its deque, idle threads steal from the top of someone else's. Waiting on a counter runs other jobs instead of
+// blocking, so jobs may wait on jobs. Nothing here touches GL or Android and jobs are plain functions, so it can drive
+// a simulation without a window. Called from a thread the system doesn't know (or before Init) jobs run inline.
+//---------------------------------------------------------------------------------------------------------------------
+class JobSystem {
+public:
+    static JobSystem & GetInstance() {
+        static JobSystem instance;
+        return instance;
+    }
+
+private:
+    JobSystem();
+    JobSystem(JobSystem const &) = delete;
+    JobSystem & operator=(JobSystem const &) = delete;
+
+public:
+    ~JobSystem();
+
+    // The calling thread becomes thread 0 and may submit jobs; workerCount 0 picks one per spare core.
+    void Init(size_t workerCount = 0);
+    void Shutdown();
+
+    // ptrDependency, if given, holds the job back until that counter reaches zero.
+    void Run(JobCounter & counter, JobFunction function, JobCounter * ptrDependency = nullptr);
+    // Splits [0, count) into ranges of at most batchSize and waits until all of them are done. The caller runs the
+    // first range itself.
+    void ParallelFor(size_t count, size_t batchSize, JobRangeFunction const & function);
+    void Wait(JobCounter & counter);
+
+    size_t GetWorkerCount() const { return mWorkers.size(); }
+    bool IsJobThread() const;
+
+private:
+    struct Job {
+        JobFunction                 function;
+        JobRangeFunction const *    ptrRangeFunction;
+        size_t                      begin;
+        size_t                      end;
+        JobCounter *                ptrCounter;
+        JobCounter *                ptrDependency;
+    };
+
+    class JobDeque {
+    public:
+        JobDeque();
+
+        bool Push(Job * ptrJob);                // owner only
+        Job * Pop();                            // owner only
+        Job * Steal();                          // any thread
+
+    private:
+        std::atomic<int64_t> mBottom;
+        char mPadding[64];                      // keeps the owner's end and the thieves' end on separate cache lines
+        std::atomic<int64_t> mTop;
+        std::unique_ptr<std::atomic<Job*>[]> mJobs;
+    };
+
+    struct ThreadData {
+        JobDeque                    deque;
+        std::unique_ptr<Job[]>      jobs;
+        size_t                      nextJob;
+        uint32_t                    random;
+    };
+
+private:
+    Job * AllocateJob(ThreadData & thread);
+    void Submit(ThreadData & thread, Job * ptrJob);
+    bool RunOneJob(size_t threadIndex);
+    void Execute(Job * ptrJob);
+    void WorkerLoop(size_t threadIndex);
+
+private:
+    std::vector<std::unique_ptr<ThreadData>> mThreads;
+    std::vector<std::thread> mWorkers;
+    std::atomic<bool> mRunning;
+    std::atomic<uint32_t> mQueuedJobs;
+    std::atomic<uint32_t> mSleepingWorkers;
+    std::mutex mWakeMutex;
+    std::condition_variable mWakeCondition;
+};
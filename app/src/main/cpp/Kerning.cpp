@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "Kerning.h"
+
+#include FT_TRUETYPE_TABLES_H
+#include FT_TRUETYPE_TAGS_H
+
+namespace {
+
+uint32_t ReadU16(std::vector<uint8_t> const & table, size_t offset) {
+    return static_cast<uint32_t>(table[offset]) << 8 | table[offset + 1];
+}
+
+uint32_t MakeKey(uint32_t left, uint32_t right) {
+    return (left & 0xFFFFu) << 16 | (right & 0xFFFFu);
+}
+
+}
+
+void KerningTable::Build(FT_Face ptrFace) {
+    Clear();
+    if (!FT_HAS_KERNING(ptrFace))
+        return;
+
+    FT_ULong length {};
+    if (FT_Load_Sfnt_Table(ptrFace, TTAG_kern, 0, nullptr, &length) || length < 4)
+        return;
+    std::vector<uint8_t> table(length);
+    if (FT_Load_Sfnt_Table(ptrFace, TTAG_kern, 0, table.data(), &length))
+        return;
+
+    // Version 0 kern table, the one FreeType reads: format 0 subtables list (left, right, value) triples. Only the
+    // pairs are taken from it; FT_Get_Kerning scales the values to the face size and sums the subtables.
+    std::vector<uint32_t> candidates;
+    size_t subtables = ReadU16(table, 2);
+    size_t offset = 4;
+    for (size_t subtable = 0; subtable < subtables && offset + 6 <= length; ++subtable) {
+        size_t subtableLength = ReadU16(table, offset + 2);
+        uint32_t format = ReadU16(table, offset + 4) >> 8;
+        if (format != 0 || offset + 14 > length) {
+            if (subtableLength < 6)
+                break;
+            offset += subtableLength;
+            continue;
+        }
+
+        // Large format 0 subtables overflow their 16-bit length, so the pair count says where the next one starts.
+        size_t pairs = ReadU16(table, offset + 6);
+        size_t first = offset + 14;
+        for (size_t pair = 0; pair < pairs && first + pair * 6 + 6 <= length; ++pair) {
+            size_t entry = first + pair * 6;
+            candidates.push_back(MakeKey(ReadU16(table, entry), ReadU16(table, entry + 2)));
+        }
+        offset = first + pairs * 6;
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    // Unfitted: text is drawn scaled from this size, so the fraction of a pixel rounding would drop matters.
+    for (uint32_t key : candidates) {
+        FT_Vector delta {};
+        if (FT_Get_Kerning(ptrFace, key >> 16, key & 0xFFFFu, FT_KERNING_UNFITTED, &delta) || delta.x == 0)
+            continue;
+        mKeys.push_back(key);
+        mValues.push_back(static_cast<int16_t>(std::min<FT_Pos>(std::max<FT_Pos>(delta.x, INT16_MIN), INT16_MAX)));
+    }
+}
+
+bool KerningTable::Assign(std::vector<uint32_t> keys, std::vector<int16_t> values) {
+    Clear();
+    bool ascending = std::adjacent_find(keys.begin(), keys.end(), std::greater_equal<uint32_t>()) == keys.end();
+    if (keys.size() != values.size() || !ascending)
+        return false;
+
+    mKeys = std::move(keys);
+    mValues = std::move(values);
+    return true;
+}
+
+void KerningTable::Clear() {
+    mKeys.clear();
+    mValues.clear();
+}
+
+int32_t KerningTable::Find(uint32_t left, uint32_t right) const {
+    uint32_t key = MakeKey(left, right);
+    auto it = std::lower_bound(mKeys.begin(), mKeys.end(), key);
+    if (it == mKeys.end() || *it != key)
+        return 0;
+    return mValues[static_cast<size_t>(it - mKeys.begin())];
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+//---------------------------------------------------------------------------------------------------------------------
+// KerningTable
+// Pair kerning of one face at the pixel size it is set to. Build asks FT_Get_Kerning once for every pair the face's
+// kern table lists and keeps the non-zero ones as sorted keys, left << 16 | right glyph index, next to their
+// adjustments, so a lookup is a binary search over a few KB and never reaches FreeType.
+//---------------------------------------------------------------------------------------------------------------------
+class KerningTable {
+public:
+    void Build(FT_Face ptrFace);
+    // Takes a table saved with GetKeys and GetValues; false if they don't form one.
+    bool Assign(std::vector<uint32_t> keys, std::vector<int16_t> values);
+    void Clear();
+
+    // Horizontal adjustment in 26.6 pixels, 0 for pairs the face doesn't kern.
+    int32_t Find(uint32_t left, uint32_t right) const;
+
+    size_t GetSize() const { return mKeys.size(); }
+    std::vector<uint32_t> const & GetKeys() const { return mKeys; }
+    std::vector<int16_t> const & GetValues() const { return mValues; }
+
+private:
+    std::vector<uint32_t> mKeys;
+    std::vector<int16_t> mValues;
+};
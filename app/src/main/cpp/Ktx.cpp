@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "Ktx.h"
+
+namespace {
+
+uint8_t const KTX_IDENTIFIER[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+uint32_t const KTX_ENDIANNESS = 0x04030201;
+
+// The header after the identifier, in the file's byte order, which is ours when endianness reads 0x04030201.
+struct KtxHeader {
+    uint32_t endianness;
+    uint32_t glType;
+    uint32_t glTypeSize;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+
+// Block width and height of the ASTC formats, KTX_ASTC_4x4 on.
+uint8_t const ASTC_BLOCKS[][2] = {{4, 4}, {5, 4}, {5, 5}, {6, 5}, {6, 6}, {8, 5}, {8, 6},
+                                  {8, 8}, {10, 5}, {10, 6}, {10, 8}, {10, 10}, {12, 10}, {12, 12}};
+
+int32_t const MAX_LEVELS = 16;
+
+size_t Blocks(int32_t pixels, int32_t blockPixels) {
+    return static_cast<size_t>((pixels + blockPixels - 1) / blockPixels);
+}
+
+size_t Padding(size_t size) {
+    return (4 - size % 4) % 4;
+}
+
+}
+
+size_t CompressedLevelSize(uint32_t internalFormat, int32_t width, int32_t height) {
+    if (width <= 0 || height <= 0)
+        return 0;
+    if (internalFormat == KTX_ETC2_RGB8)
+        return Blocks(width, 4) * Blocks(height, 4) * 8;
+    if (internalFormat == KTX_ETC2_RGBA8_EAC)
+        return Blocks(width, 4) * Blocks(height, 4) * 16;
+    if (IsAstc(internalFormat)) {
+        uint8_t const * block = ASTC_BLOCKS[internalFormat - KTX_ASTC_4x4];
+        return Blocks(width, block[0]) * Blocks(height, block[1]) * 16;
+    }
+    return 0;
+}
+
+bool IsEtc2(uint32_t internalFormat) {
+    return internalFormat == KTX_ETC2_RGB8 || internalFormat == KTX_ETC2_RGBA8_EAC;
+}
+
+bool IsAstc(uint32_t internalFormat) {
+    return internalFormat >= KTX_ASTC_4x4 && internalFormat <= KTX_ASTC_12x12;
+}
+
+bool ParseKtx(std::vector<uint8_t> data, KtxImage & image) {
+    image = {};
+    KtxHeader header {};
+    if (data.size() < sizeof(KTX_IDENTIFIER) + sizeof(header) ||
+        std::memcmp(data.data(), KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0)
+        return false;
+    std::memcpy(&header, data.data() + sizeof(KTX_IDENTIFIER), sizeof(header));
+
+    // Compressed 2D only: no type, one face, no array, no depth. No levels means "make them", which we take as one.
+    uint32_t levels = std::max<uint32_t>(header.numberOfMipmapLevels, 1);
+    if (header.endianness != KTX_ENDIANNESS || header.glType != 0 || header.glFormat != 0 ||
+        header.pixelDepth > 1 || header.numberOfArrayElements != 0 || header.numberOfFaces != 1 ||
+        levels > MAX_LEVELS || header.pixelWidth == 0 || header.pixelHeight == 0 ||
+        header.pixelWidth > 1u << 15 || header.pixelHeight > 1u << 15 ||
+        CompressedLevelSize(header.glInternalFormat, 1, 1) == 0 ||
+        header.bytesOfKeyValueData > data.size() - sizeof(KTX_IDENTIFIER) - sizeof(header))
+        return false;
+
+    size_t offset = sizeof(KTX_IDENTIFIER) + sizeof(header) + header.bytesOfKeyValueData;
+    auto width = static_cast<int32_t>(header.pixelWidth);
+    auto height = static_cast<int32_t>(header.pixelHeight);
+    std::vector<KtxLevel> ktxLevels;
+    for (uint32_t level = 0; level < levels; ++level) {
+        uint32_t imageSize {};
+        if (data.size() - offset < sizeof(imageSize))
+            return false;
+        std::memcpy(&imageSize, data.data() + offset, sizeof(imageSize));
+        offset += sizeof(imageSize);
+
+        if (imageSize != CompressedLevelSize(header.glInternalFormat, width, height) ||
+            data.size() - offset < imageSize)
+            return false;
+        ktxLevels.push_back({width, height, offset, imageSize});
+
+        offset += std::min(imageSize + Padding(imageSize), data.size() - offset);
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+
+    image.internalFormat = header.glInternalFormat;
+    image.baseFormat = header.glBaseInternalFormat;
+    image.width = static_cast<int32_t>(header.pixelWidth);
+    image.height = static_cast<int32_t>(header.pixelHeight);
+    image.levels = std::move(ktxLevels);
+    image.data = std::move(data);
+    return true;
+}
+
+std::vector<uint8_t> BuildKtx(uint32_t internalFormat,
+                              uint32_t baseFormat,
+                              int32_t width,
+                              int32_t height,
+                              std::vector<std::vector<uint8_t>> const & levels)
+{
+    KtxHeader header {};
+    header.endianness = KTX_ENDIANNESS;
+    header.glTypeSize = 1;
+    header.glInternalFormat = internalFormat;
+    header.glBaseInternalFormat = baseFormat;
+    header.pixelWidth = static_cast<uint32_t>(width);
+    header.pixelHeight = static_cast<uint32_t>(height);
+    header.numberOfFaces = 1;
+    header.numberOfMipmapLevels = static_cast<uint32_t>(levels.size());
+
+    size_t size = sizeof(KTX_IDENTIFIER) + sizeof(header);
+    for (auto const & level : levels)
+        size += sizeof(uint32_t) + level.size() + Padding(level.size());
+
+    std::vector<uint8_t> file(size);
+    size_t offset {};
+    auto append = [&file, &offset](void const * ptrData, size_t bytes) {
+        std::memcpy(file.data() + offset, ptrData, bytes);
+        offset += bytes;
+    };
+    append(KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER));
+    append(&header, sizeof(header));
+    for (auto const & level : levels) {
+        auto imageSize = static_cast<uint32_t>(level.size());
+        append(&imageSize, sizeof(imageSize));
+        append(level.data(), level.size());
+        offset += Padding(level.size());
+    }
+    return file;
+}
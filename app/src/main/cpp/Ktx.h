@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compressed formats a KtxImage may hold, as glCompressedTexImage2D takes them. ETC2 is core in GLES3, ASTC needs
+// GL_KHR_texture_compression_astc_ldr.
+uint32_t const KTX_ETC2_RGB8 = 0x9274;          // GL_COMPRESSED_RGB8_ETC2
+uint32_t const KTX_ETC2_RGBA8_EAC = 0x9278;     // GL_COMPRESSED_RGBA8_ETC2_EAC
+uint32_t const KTX_ASTC_4x4 = 0x93B0;           // GL_COMPRESSED_RGBA_ASTC_4x4_KHR, up to 12x12 at 0x93BD
+uint32_t const KTX_ASTC_12x12 = 0x93BD;
+
+uint32_t const KTX_BASE_RGB = 0x1907;           // GL_RGB
+uint32_t const KTX_BASE_RGBA = 0x1908;          // GL_RGBA
+
+// One mip level, a range of KtxImage::data.
+struct KtxLevel {
+    int32_t     width;
+    int32_t     height;
+    size_t      offset;
+    size_t      size;
+};
+
+// A 2D texture read from a KTX 1.1 container with its mip chain as stored, level 0 first.
+struct KtxImage {
+    uint32_t                internalFormat;
+    uint32_t                baseFormat;
+    int32_t                 width;
+    int32_t                 height;
+    std::vector<KtxLevel>   levels;
+    std::vector<uint8_t>    data;       // the file, levels point into it
+};
+
+// Bytes of a level of a block compressed format, 0 for formats this doesn't know.
+size_t CompressedLevelSize(uint32_t internalFormat, int32_t width, int32_t height);
+bool IsEtc2(uint32_t internalFormat);
+bool IsAstc(uint32_t internalFormat);
+
+// Takes a KTX 1.1 file of a single compressed 2D texture. False if it is anything else or its levels don't match the
+// format's sizes, image is left empty then.
+bool ParseKtx(std::vector<uint8_t> data, KtxImage & image);
+// A KTX 1.1 file of the levels, level 0 first, each halving the one before down to 1x1 or to the last one given.
+std::vector<uint8_t> BuildKtx(uint32_t internalFormat,
+                              uint32_t baseFormat,
+                              int32_t width,
+                              int32_t height,
+                              std::vector<std::vector<uint8_t>> const & levels);
@@ -1,40 +1,380 @@
+#include <cstdio>
+#include <ctime>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "Log.h"
-#include <android/log.h>
+#include "RingBuffer.h"
 
 char const APP_NAME [] = "FlappyPelican";
 
+size_t const LOG_RECORD_TEXT_SIZE = 250;
+size_t const LOG_RING_CAPACITY = 512;
+int32_t const LOG_FLUSH_PERIOD_MS = 10;
+size_t const TRACE_RING_CAPACITY = 1024;
+
+struct LogRecord {
+    LogLevel    level;
+    uint8_t     pad;
+    uint16_t    length;
+    char        text[LOG_RECORD_TEXT_SIZE];
+};
+
+using LogRing = RingBuffer<LogRecord, LOG_RING_CAPACITY>;
+using TraceRing = RingBuffer<TraceRecord, TRACE_RING_CAPACITY>;
+
+struct LogState {
+    std::mutex                              sinkMutex;      // guards the sink, the trace file and the consumer side of every ring
+    std::unique_ptr<LogSink>                ptrSink;
+    std::mutex                              ringsMutex;
+    std::vector<std::unique_ptr<LogRing>>   rings;
+    std::vector<std::unique_ptr<TraceRing>> traceRings;
+    std::thread                             flushThread;
+    std::atomic<bool>                       running {false};
+    std::atomic<uint32_t>                   dropped {0};
+
+    std::mutex                              traceFormatsMutex;
+    std::vector<std::string>                traceFormats;
+    size_t                                  traceFormatsWritten {0};
+    FILE *                                  ptrTraceFile {nullptr};
+    size_t                                  traceBytesWritten {0};
+    size_t                                  traceMaxBytes {0};
+    std::atomic<uint32_t>                   traceDropped {0};
+};
+
+std::atomic<bool> Log::sTracing {false};
+
+static LogState & GetLogState() {
+    static LogState state;
+    return state;
+}
+
+static thread_local LogRing * tPtrRing = nullptr;
+static thread_local TraceRing * tPtrTraceRing = nullptr;
+static thread_local uint8_t tTraceThread = 0;
+
+static LogRing & GetThreadRing() {
+    if (!tPtrRing) {
+        LogState & state = GetLogState();
+        std::lock_guard<std::mutex> lock(state.ringsMutex);
+        state.rings.emplace_back(new LogRing);
+        tPtrRing = state.rings.back().get();
+    }
+    return *tPtrRing;
+}
+
+static TraceRing & GetThreadTraceRing() {
+    if (!tPtrTraceRing) {
+        LogState & state = GetLogState();
+        std::lock_guard<std::mutex> lock(state.ringsMutex);
+        state.traceRings.emplace_back(new TraceRing);
+        tPtrTraceRing = state.traceRings.back().get();
+        tTraceThread = static_cast<uint8_t>(state.traceRings.size() - 1);
+    }
+    return *tPtrTraceRing;
+}
+
+static uint64_t GetTimeNowNs() {
+    timespec timeVal;
+    clock_gettime(CLOCK_MONOTONIC, &timeVal);
+    return static_cast<uint64_t>(timeVal.tv_sec) * 1000000000ull + static_cast<uint64_t>(timeVal.tv_nsec);
+}
+
+static std::unique_ptr<LogSink> CreateDefaultSink() {
+#ifdef __ANDROID__
+    return std::unique_ptr<LogSink>(new LogcatSink(APP_NAME));
+#else
+    return std::unique_ptr<LogSink>(new StdoutSink);
+#endif
+}
+
+static uint16_t ClampLength(int length) {
+    if (length < 0)
+        return 0;
+    if (static_cast<size_t>(length) >= LOG_RECORD_TEXT_SIZE)
+        return static_cast<uint16_t>(LOG_RECORD_TEXT_SIZE - 1);
+    return static_cast<uint16_t>(length);
+}
+
+// Caller must hold sinkMutex.
+static void WriteToSink(LogState & state, LogLevel level, char const * pText, size_t length) {
+    if (!state.ptrSink)
+        state.ptrSink = CreateDefaultSink();
+    state.ptrSink->VWrite(level, pText, length);
+}
+
+// Caller must hold sinkMutex. Writes the tag and the chunk, or nothing when both don't fit the byte budget: a tag
+// without its chunk would make the decoder read whatever follows as the chunk.
+static bool WriteTraceChunk(LogState & state, uint8_t tag, void const * pData, size_t size) {
+    if (state.traceBytesWritten + sizeof(tag) + size > state.traceMaxBytes)
+        return false;
+    fwrite(&tag, sizeof(tag), 1, state.ptrTraceFile);
+    fwrite(pData, 1, size, state.ptrTraceFile);
+    state.traceBytesWritten += sizeof(tag) + size;
+    return true;
+}
+
+// Caller must hold sinkMutex. Formats registered since the last drain are written before the records; the decoder
+// reads all formats first, so a record may still precede its format in the file.
+static bool DrainTraceRings(LogState & state, std::vector<TraceRing*> const & traceRings) {
+    bool written = false;
+
+    if (state.ptrTraceFile) {
+        std::lock_guard<std::mutex> lock(state.traceFormatsMutex);
+        for (; state.traceFormatsWritten < state.traceFormats.size(); ++state.traceFormatsWritten) {
+            std::string const & format = state.traceFormats[state.traceFormatsWritten];
+            uint16_t formatId = static_cast<uint16_t>(state.traceFormatsWritten);
+            uint16_t length = static_cast<uint16_t>(format.size());
+            // Formats are tiny and must never be lost, so they are allowed past the byte budget.
+            fwrite(&TRACE_CHUNK_FORMAT, 1, 1, state.ptrTraceFile);
+            fwrite(&formatId, sizeof(formatId), 1, state.ptrTraceFile);
+            fwrite(&length, sizeof(length), 1, state.ptrTraceFile);
+            fwrite(format.data(), 1, length, state.ptrTraceFile);
+            written = true;
+        }
+    }
+
+    size_t const headerSize = offsetof(TraceRecord, payload);
+    for (auto ptrRing : traceRings) {
+        while (TraceRecord const * ptrRecord = ptrRing->Front()) {
+            if (state.ptrTraceFile) {
+                if (WriteTraceChunk(state, TRACE_CHUNK_RECORD, ptrRecord, headerSize + ptrRecord->size))
+                    written = true;
+                else
+                    state.traceDropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            ptrRing->PopFront();
+        }
+    }
+
+    if (written)
+        fflush(state.ptrTraceFile);
+
+    return written;
+}
+
+static bool DrainRings(LogState & state) {
+    std::vector<LogRing*> rings;
+    std::vector<TraceRing*> traceRings;
+    {
+        std::lock_guard<std::mutex> lock(state.ringsMutex);
+        rings.reserve(state.rings.size());
+        for (auto const & ptrRing : state.rings)
+            rings.push_back(ptrRing.get());
+        traceRings.reserve(state.traceRings.size());
+        for (auto const & ptrRing : state.traceRings)
+            traceRings.push_back(ptrRing.get());
+    }
+
+    std::lock_guard<std::mutex> lock(state.sinkMutex);
+    bool written = DrainTraceRings(state, traceRings);
+    for (auto ptrRing : rings) {
+        while (LogRecord const * ptrRecord = ptrRing->Front()) {
+            WriteToSink(state, ptrRecord->level, ptrRecord->text, ptrRecord->length);
+            ptrRing->PopFront();
+            written = true;
+        }
+    }
+
+    uint32_t dropped = state.dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped) {
+        char text[64];
+        int length = snprintf(text, sizeof(text), "Log: %u messages dropped, ring buffer full", dropped);
+        WriteToSink(state, LogLevel::WARN, text, ClampLength(length));
+        written = true;
+    }
+
+    if (written && state.ptrSink)
+        state.ptrSink->VFlush();
+
+    return written;
+}
+
+static void FlushLoop() {
+    LogState & state = GetLogState();
+    while (state.running.load(std::memory_order_acquire)) {
+        if (!DrainRings(state))
+            std::this_thread::sleep_for(std::chrono::milliseconds(LOG_FLUSH_PERIOD_MS));
+    }
+    DrainRings(state);
+}
+
+
+void Log::Init(std::unique_ptr<LogSink> ptrSink) {
+    LogState & state = GetLogState();
+    if (ptrSink)
+        SetSink(std::move(ptrSink));
+
+    if (state.running.exchange(true))
+        return;
+    state.flushThread = std::thread(FlushLoop);
+}
+
+void Log::Shutdown() {
+    LogState & state = GetLogState();
+    StopTrace();
+    if (!state.running.exchange(false))
+        return;
+    state.flushThread.join();
+}
+
+void Log::SetSink(std::unique_ptr<LogSink> ptrSink) {
+    LogState & state = GetLogState();
+    DrainRings(state);
+    std::lock_guard<std::mutex> lock(state.sinkMutex);
+    state.ptrSink = std::move(ptrSink);
+}
+
+void Log::Flush() {
+    DrainRings(GetLogState());
+}
+
+bool Log::StartTrace(std::string const & filePath, size_t maxBytes) {
+    LogState & state = GetLogState();
+    StopTrace();
+    Init();
+
+    {
+        std::lock_guard<std::mutex> lock(state.sinkMutex);
+        state.ptrTraceFile = fopen(filePath.c_str(), "wb");
+        if (!state.ptrTraceFile)
+            return false;
+
+        fwrite(TRACE_MAGIC, 1, sizeof(TRACE_MAGIC), state.ptrTraceFile);
+        fwrite(&TRACE_VERSION, sizeof(TRACE_VERSION), 1, state.ptrTraceFile);
+        state.traceBytesWritten = sizeof(TRACE_MAGIC) + sizeof(TRACE_VERSION);
+        state.traceMaxBytes = maxBytes;
+        state.traceDropped.store(0, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> formatsLock(state.traceFormatsMutex);
+        state.traceFormatsWritten = 0;
+    }
+
+    sTracing.store(true, std::memory_order_release);
+    Log::info("Trace started : %s", filePath.c_str());
+    return true;
+}
+
+void Log::StopTrace() {
+    LogState & state = GetLogState();
+    if (!sTracing.exchange(false))
+        return;
+
+    DrainRings(state);
+
+    uint32_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(state.sinkMutex);
+        fclose(state.ptrTraceFile);
+        state.ptrTraceFile = nullptr;
+        dropped = state.traceDropped.exchange(0, std::memory_order_relaxed);
+    }
+
+    Log::info("Trace stopped : %u bytes, %u records dropped",
+              static_cast<uint32_t>(state.traceBytesWritten), dropped);
+}
+
+uint16_t Log::RegisterTraceFormat(const char* pFormat) {
+    LogState & state = GetLogState();
+    std::lock_guard<std::mutex> lock(state.traceFormatsMutex);
+    state.traceFormats.emplace_back(pFormat);
+    return static_cast<uint16_t>(state.traceFormats.size() - 1);
+}
+
+TraceRecord * Log::BeginTraceRecord(uint16_t formatId) {
+    TraceRecord * ptrRecord = GetThreadTraceRing().BeginPush();
+    if (!ptrRecord) {
+        GetLogState().traceDropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    ptrRecord->timestampNs = GetTimeNowNs();
+    ptrRecord->formatId = formatId;
+    ptrRecord->thread = tTraceThread;
+    ptrRecord->size = 0;
+    return ptrRecord;
+}
+
+void Log::CommitTraceRecord() {
+    tPtrTraceRing->CommitPush();
+}
+
+void Log::Write(LogLevel level, const char* pMessage, va_list varArgs) {
+    LogState & state = GetLogState();
+
+    if (level == LogLevel::ERROR || !state.running.load(std::memory_order_acquire)) {
+        // Not bound by the ring's record size: a message that doesn't fit the stack buffer is formatted again into one
+        // of its length, so shader info logs and the like reach the sink whole.
+        va_list varArgsCopy;
+        va_copy(varArgsCopy, varArgs);
+        char text[LOG_RECORD_TEXT_SIZE];
+        char const * pText = text;
+        int length = vsnprintf(text, sizeof(text), pMessage, varArgs);
+        std::vector<char> longText;
+        if (length >= static_cast<int>(sizeof(text))) {
+            longText.resize(static_cast<size_t>(length) + 1);
+            vsnprintf(longText.data(), longText.size(), pMessage, varArgsCopy);
+            pText = longText.data();
+        }
+        va_end(varArgsCopy);
+
+        std::lock_guard<std::mutex> lock(state.sinkMutex);
+        WriteToSink(state, level, pText, length > 0 ? static_cast<size_t>(length) : 0);
+        state.ptrSink->VFlush();
+        return;
+    }
+
+    LogRing & ring = GetThreadRing();
+    LogRecord * ptrRecord = ring.BeginPush();
+    if (!ptrRecord) {
+        state.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ptrRecord->level = level;
+    ptrRecord->length = ClampLength(vsnprintf(ptrRecord->text, sizeof(ptrRecord->text), pMessage, varArgs));
+    ring.CommitPush();
+}
+
 void Log::info(const char* pMessage, ...)
 {
+#if FLAPPY_LOG_LEVEL <= FLAPPY_LOG_LEVEL_INFO
     va_list varArgs;
     va_start(varArgs, pMessage);
-    __android_log_vprint(ANDROID_LOG_INFO, APP_NAME, pMessage, varArgs);
-    __android_log_print(ANDROID_LOG_INFO, APP_NAME, "\n");
+    Write(LogLevel::INFO, pMessage, varArgs);
     va_end(varArgs);
+#endif
 }
 
 void Log::error(const char* pMessage, ...)
 {
+#if FLAPPY_LOG_LEVEL <= FLAPPY_LOG_LEVEL_ERROR
     va_list varArgs;
     va_start(varArgs, pMessage);
-    __android_log_vprint(ANDROID_LOG_ERROR, APP_NAME, pMessage, varArgs);
-    __android_log_print(ANDROID_LOG_ERROR, APP_NAME, "\n");
+    Write(LogLevel::ERROR, pMessage, varArgs);
     va_end(varArgs);
+#endif
 }
 
 void Log::warn(const char* pMessage, ...)
 {
+#if FLAPPY_LOG_LEVEL <= FLAPPY_LOG_LEVEL_WARN
     va_list varArgs;
     va_start(varArgs, pMessage);
-    __android_log_vprint(ANDROID_LOG_WARN, APP_NAME, pMessage, varArgs);
-    __android_log_print(ANDROID_LOG_WARN, APP_NAME, "\n");
+    Write(LogLevel::WARN, pMessage, varArgs);
     va_end(varArgs);
+#endif
 }
 
 void Log::debug(const char* pMessage, ...)
 {
+#if FLAPPY_LOG_LEVEL <= FLAPPY_LOG_LEVEL_DEBUG
     va_list varArgs;
     va_start(varArgs, pMessage);
-    __android_log_vprint(ANDROID_LOG_DEBUG, APP_NAME, pMessage, varArgs);
-    __android_log_print(ANDROID_LOG_DEBUG, APP_NAME, "\n");
+    Write(LogLevel::DEBUG, pMessage, varArgs);
     va_end(varArgs);
-}
\ No newline at end of file
+#endif
+}
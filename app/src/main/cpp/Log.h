@@ -1,18 +1,189 @@
 #pragma once
 
+#include <atomic>
+#include <cstdarg>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
 
+#include "LogSink.h"
+#include "TraceFormat.h"
+
+#define FLAPPY_LOG_LEVEL_DEBUG 0
+#define FLAPPY_LOG_LEVEL_INFO  1
+#define FLAPPY_LOG_LEVEL_WARN  2
+#define FLAPPY_LOG_LEVEL_ERROR 3
+#define FLAPPY_LOG_LEVEL_NONE  4
+
+// Messages below FLAPPY_LOG_LEVEL are compiled out. Override from the build with -DFLAPPY_LOG_LEVEL=<n>.
+#ifndef FLAPPY_LOG_LEVEL
+#ifndef NDEBUG
+#define FLAPPY_LOG_LEVEL FLAPPY_LOG_LEVEL_DEBUG
+#else
+#define FLAPPY_LOG_LEVEL FLAPPY_LOG_LEVEL_INFO
+#endif
+#endif
+
+// Binary tracing is cheap enough to stay compiled into release builds; it still has to be started at runtime.
+#ifndef FLAPPY_TRACE
+#define FLAPPY_TRACE 1
+#endif
+
+size_t const TRACE_DEFAULT_MAX_BYTES = 16 * 1024 * 1024;
+
+//---------------------------------------------------------------------------------------------------------------------
+// TraceArgWriter
+// Appends tagged raw argument bytes to a TraceRecord payload. Arguments that do not fit are dropped, strings are
+// truncated to the space left.
+//---------------------------------------------------------------------------------------------------------------------
+class TraceArgWriter {
+public:
+    explicit TraceArgWriter(TraceRecord & record) : mRecord(record)
+    {}
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type Put(T value) {
+        if (sizeof(T) <= sizeof(int32_t))
+            PutValue(TraceArgType::INT32, static_cast<int32_t>(value));
+        else
+            PutValue(TraceArgType::INT64, static_cast<int64_t>(value));
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type Put(T value) {
+        if (sizeof(T) <= sizeof(uint32_t))
+            PutValue(TraceArgType::UINT32, static_cast<uint32_t>(value));
+        else
+            PutValue(TraceArgType::UINT64, static_cast<uint64_t>(value));
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_floating_point<T>::value>::type Put(T value) {
+        PutValue(TraceArgType::DOUBLE, static_cast<double>(value));
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_enum<T>::value>::type Put(T value) {
+        Put(static_cast<typename std::underlying_type<T>::type>(value));
+    }
+
+    template <typename T>
+    void Put(T const * value) {
+        PutValue(TraceArgType::POINTER, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+    }
+
+    void Put(char const * value) {
+        if (!value)
+            value = "(null)";
+        size_t used = mRecord.size + 2;
+        if (used > TRACE_PAYLOAD_SIZE)
+            return;
+        size_t length = strnlen(value, TRACE_PAYLOAD_SIZE - used);
+        mRecord.payload[mRecord.size] = static_cast<uint8_t>(TraceArgType::STRING);
+        mRecord.payload[mRecord.size + 1] = static_cast<uint8_t>(length);
+        memcpy(mRecord.payload + used, value, length);
+        mRecord.size = static_cast<uint8_t>(used + length);
+    }
+
+    void Put(char * value) { Put(static_cast<char const *>(value)); }
+    void Put(std::string const & value) { Put(value.c_str()); }
+
+    void PutAll() {}
+
+    template <typename Arg, typename... Args>
+    void PutAll(Arg const & arg, Args const &... args) {
+        Put(arg);
+        PutAll(args...);
+    }
+
+private:
+    template <typename T>
+    void PutValue(TraceArgType type, T value) {
+        if (mRecord.size + 1 + sizeof(T) > TRACE_PAYLOAD_SIZE)
+            return;
+        mRecord.payload[mRecord.size] = static_cast<uint8_t>(type);
+        memcpy(mRecord.payload + mRecord.size + 1, &value, sizeof(T));
+        mRecord.size = static_cast<uint8_t>(mRecord.size + 1 + sizeof(T));
+    }
+
+private:
+    TraceRecord & mRecord;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Log
+// Until Init() is called messages are formatted and written to the sink synchronously. After Init() every thread
+// formats into its own lock-free ring buffer and a background thread drains the rings into the sink. Errors always
+// bypass the rings so they are not lost to a following assert.
+//---------------------------------------------------------------------------------------------------------------------
 class Log
 {
 public:
+    // Starts the flush thread. A null sink selects logcat on device and stdout on a host build.
+    static void Init(std::unique_ptr<LogSink> ptrSink = nullptr);
+    static void Shutdown();
+    static void SetSink(std::unique_ptr<LogSink> ptrSink);
+    static void Flush();
+
     static void error(const char* pMessage, ...);
     static void warn(const char* pMessage, ...);
     static void info(const char* pMessage, ...);
     static void debug(const char* pMessage, ...);
+
+    // Binary trace mode. Records hold a format id plus raw argument bytes and are written to filePath by the flush
+    // thread; tools/TraceDecoder turns the file back into text on the host. Writing stops once maxBytes is reached.
+    static bool StartTrace(std::string const & filePath, size_t maxBytes = TRACE_DEFAULT_MAX_BYTES);
+    static void StopTrace();
+    static bool IsTracing() { return sTracing.load(std::memory_order_relaxed); }
+    static uint16_t RegisterTraceFormat(const char* pFormat);
+
+    template <typename... Args>
+    static void trace(uint16_t formatId, Args const &... args) {
+        TraceRecord * ptrRecord = BeginTraceRecord(formatId);
+        if (!ptrRecord)
+            return;
+        TraceArgWriter(*ptrRecord).PutAll(args...);
+        CommitTraceRecord();
+    }
+
+private:
+    static void Write(LogLevel level, const char* pMessage, va_list varArgs);
+    static TraceRecord * BeginTraceRecord(uint16_t formatId);
+    static void CommitTraceRecord();
+
+private:
+    static std::atomic<bool> sTracing;
 };
 
-#ifndef NDEBUG
+// Use the macros on hot paths: below the configured level the arguments are not even evaluated.
+#if FLAPPY_LOG_LEVEL <= FLAPPY_LOG_LEVEL_DEBUG
 #define Log_debug(...) Log::debug(__VA_ARGS__)
 #else
 #define Log_debug(...)
 #endif
 
+#if FLAPPY_LOG_LEVEL <= FLAPPY_LOG_LEVEL_INFO
+#define Log_info(...) Log::info(__VA_ARGS__)
+#else
+#define Log_info(...)
+#endif
+
+#if FLAPPY_LOG_LEVEL <= FLAPPY_LOG_LEVEL_WARN
+#define Log_warn(...) Log::warn(__VA_ARGS__)
+#else
+#define Log_warn(...)
+#endif
+
+// The format string must be a literal: it is registered once per call site and only its id is recorded.
+#if FLAPPY_TRACE
+#define Log_trace(format, ...)                                                          \
+    do {                                                                                \
+        if (Log::IsTracing()) {                                                         \
+            static uint16_t const sTraceFormatId = Log::RegisterTraceFormat(format);    \
+            Log::trace(sTraceFormatId, ##__VA_ARGS__);                                  \
+        }                                                                               \
+    } while (false)
+#else
+#define Log_trace(format, ...)
+#endif
@@ -0,0 +1,61 @@
+#include "LogSink.h"
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#endif
+
+char const * LogLevelToStr(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "D";
+        case LogLevel::INFO:  return "I";
+        case LogLevel::WARN:  return "W";
+        case LogLevel::ERROR: return "E";
+    }
+    return "?";
+}
+
+
+#ifdef __ANDROID__
+LogcatSink::LogcatSink(char const * pTag) : mPtrTag {pTag}
+{}
+
+void LogcatSink::VWrite(LogLevel level, char const * pText, size_t length) {
+    int priority = ANDROID_LOG_DEBUG;
+    switch (level) {
+        case LogLevel::DEBUG: priority = ANDROID_LOG_DEBUG; break;
+        case LogLevel::INFO:  priority = ANDROID_LOG_INFO;  break;
+        case LogLevel::WARN:  priority = ANDROID_LOG_WARN;  break;
+        case LogLevel::ERROR: priority = ANDROID_LOG_ERROR; break;
+    }
+    __android_log_print(priority, mPtrTag, "%.*s", static_cast<int>(length), pText);
+}
+#endif
+
+
+void StdoutSink::VWrite(LogLevel level, char const * pText, size_t length) {
+    fprintf(stdout, "%s: %.*s\n", LogLevelToStr(level), static_cast<int>(length), pText);
+}
+
+void StdoutSink::VFlush() {
+    fflush(stdout);
+}
+
+
+FileSink::FileSink(std::string const & filePath) : mPtrFile {fopen(filePath.c_str(), "w")}
+{}
+
+FileSink::~FileSink() {
+    if (mPtrFile)
+        fclose(mPtrFile);
+}
+
+void FileSink::VWrite(LogLevel level, char const * pText, size_t length) {
+    if (!mPtrFile)
+        return;
+    fprintf(mPtrFile, "%s: %.*s\n", LogLevelToStr(level), static_cast<int>(length), pText);
+}
+
+void FileSink::VFlush() {
+    if (mPtrFile)
+        fflush(mPtrFile);
+}
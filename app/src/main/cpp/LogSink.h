@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+enum class LogLevel : uint8_t {
+    DEBUG,
+    INFO,
+    WARN,
+    ERROR
+};
+
+char const * LogLevelToStr(LogLevel level);
+
+//---------------------------------------------------------------------------------------------------------------------
+// LogSink
+// Destination for formatted log records. Sinks are only ever called from one thread at a time (the Log flush thread,
+// or the caller while the logger runs synchronously), so implementations need no locking of their own.
+//---------------------------------------------------------------------------------------------------------------------
+class LogSink {
+public:
+    virtual ~LogSink() = default;
+
+    virtual void VWrite(LogLevel level, char const * pText, size_t length) = 0;
+    virtual void VFlush() {}
+};
+
+
+#ifdef __ANDROID__
+class LogcatSink : public LogSink {
+public:
+    explicit LogcatSink(char const * pTag);
+    virtual void VWrite(LogLevel level, char const * pText, size_t length);
+
+private:
+    char const * mPtrTag;
+};
+#endif
+
+
+class StdoutSink : public LogSink {
+public:
+    virtual void VWrite(LogLevel level, char const * pText, size_t length);
+    virtual void VFlush();
+};
+
+
+class FileSink : public LogSink {
+public:
+    explicit FileSink(std::string const & filePath);
+    ~FileSink();
+    FileSink(FileSink const &) = delete;
+    FileSink & operator=(FileSink const &) = delete;
+
+    bool IsOpen() const { return mPtrFile != nullptr; }
+
+    virtual void VWrite(LogLevel level, char const * pText, size_t length);
+    virtual void VFlush();
+
+private:
+    FILE * mPtrFile;
+};
@@ -2,9 +2,15 @@
 
 #include "Android.h"
 #include "FlappyEngine.h"
+#include "Log.h"
 
 void android_main(struct android_app* androidApp) {
 
+    Log::Init();
+#if FLAPPY_TRACE
+    Log::StartTrace(std::string(androidApp->activity->internalDataPath) + "/trace.bin");
+#endif
     Android::GetInstance().Init(androidApp);
     FlappyEngine::GetInstance().Run();
-}
+    Log::Shutdown();
+}
\ No newline at end of file
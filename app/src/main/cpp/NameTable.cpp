@@ -0,0 +1,20 @@
+#include <cassert>
+
+#include "NameTable.h"
+
+NameId NameTable::Intern(std::string const & name) {
+    auto result = mIds.emplace(name, static_cast<NameId>(mNames.size()));
+    if (result.second)
+        mNames.push_back(name);
+    return result.first->second;
+}
+
+NameId NameTable::Find(std::string const & name) const {
+    auto it = mIds.find(name);
+    return it != mIds.end() ? it->second : NAME_NONE;
+}
+
+std::string const & NameTable::GetString(NameId id) const {
+    assert(id < mNames.size());
+    return mNames[id];
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using NameId = uint32_t;
+NameId const NAME_NONE = UINT32_MAX;
+
+//---------------------------------------------------------------------------------------------------------------------
+// NameTable
+// Interned names: every distinct string gets the next NameId the first time it is seen, so names are hashed once while
+// loading and afterwards compare, and index tables, as small integers.
+//---------------------------------------------------------------------------------------------------------------------
+class NameTable {
+public:
+    NameId Intern(std::string const & name);
+    // NAME_NONE for names never interned.
+    NameId Find(std::string const & name) const;
+    std::string const & GetString(NameId id) const;
+    size_t GetSize() const { return mNames.size(); }
+
+private:
+    std::unordered_map<std::string, NameId> mIds;
+    std::vector<std::string> mNames;
+};
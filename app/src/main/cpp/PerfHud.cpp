@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "PerfHud.h"
+#include "EventManager.h"
+#include "Profiler.h"
+#include "Log.h"
+#include "TimeManager.h"
+#include "RenderThread.h"
+
+char const * const PERF_HUD_FONT = "fonts/OpenSans-Regular.ttf";
+size_t const PERF_HUD_FONT_SIZE = 24;
+float const PERF_HUD_MARGIN = 10.f;
+float const PERF_HUD_LINE_HEIGHT = 30.f;
+size_t const PERF_HUD_LINES = 5;
+
+float const PERF_HUD_BUDGET_MS = 1000.f / 60.f;
+float const PERF_HUD_GRAPH_MAX_MS = 50.f;
+float const PERF_HUD_GRAPH_HEIGHT = 90.f;
+float const PERF_HUD_GRAPH_BAR_WIDTH = 4.f;
+
+glm::vec3 const PERF_HUD_TEXT_COLOR {1.f, 1.f, 0.2f};
+glm::vec3 const PERF_HUD_OK_COLOR {0.2f, 0.9f, 0.2f};
+glm::vec3 const PERF_HUD_SLOW_COLOR {0.9f, 0.8f, 0.1f};
+glm::vec3 const PERF_HUD_JANK_COLOR {0.9f, 0.1f, 0.1f};
+glm::vec3 const PERF_HUD_BUDGET_COLOR {1.f, 1.f, 1.f};
+
+PerfHud::PerfHud() : mVisible {FLAPPY_PERF_HUD != 0},
+                     mInitialized {false},
+                     mRefreshText {true},
+                     mFrameTimesMs {},
+                     mNextSample {},
+                     mSampleCount {},
+                     mTimeAccumulator {},
+                     mSimulationNs {}
+{
+    Events::EventListenerDelegate delegate;
+    delegate = std::bind(&PerfHud::ToggleDelegate, this, std::placeholders::_1);
+    Events::EventManager::Get().AddListener(delegate, Events::EventTogglePerfHud::sEventType);
+}
+
+PerfHud::~PerfHud() {
+    Events::EventListenerDelegate delegate;
+    delegate = std::bind(&PerfHud::ToggleDelegate, this, std::placeholders::_1);
+    Events::EventManager::Get().RemoveListener(delegate, Events::EventTogglePerfHud::sEventType);
+}
+
+void PerfHud::LoadResources() {
+    GLContextScope glContext;
+    mPtrTextRenderer.reset(new TextRenderer);
+    mPtrTextRenderer->Init(PERF_HUD_FONT, PERF_HUD_FONT_SIZE);
+    mPtrSpriteRenderer.reset(new SpriteRenderer);
+
+    uint8_t const white[] = {255, 255, 255, 255};
+    mPtrFillTexture.reset(new Texture);
+    mPtrFillTexture->Generate(1, 1, GL_RGBA, white);
+
+    mInitialized = true;
+    mRefreshText = true;
+}
+
+void PerfHud::UnloadResources() {
+    GLContextScope glContext;
+    mLines.clear();
+    mPtrFillTexture.reset();
+    mPtrSpriteRenderer.reset();
+    mPtrTextRenderer.reset();
+    mInitialized = false;
+}
+
+void PerfHud::Update(double frameTimeSec) {
+    mFrameTimesMs[mNextSample] = static_cast<float>(frameTimeSec * 1000.0);
+    mNextSample = (mNextSample + 1) % PERF_HUD_SAMPLES;
+    mSampleCount = std::min(mSampleCount + 1, PERF_HUD_SAMPLES);
+
+    mTimeAccumulator += frameTimeSec;
+    if (mTimeAccumulator >= PERF_HUD_REFRESH_SEC) {
+        mTimeAccumulator = 0.0;
+        mRefreshText = true;
+    }
+}
+
+void PerfHud::Draw(RenderPacket & packet) {
+    if (!mVisible)
+        return;
+
+    PROFILE_SCOPE("PerfHud::Draw");
+    RenderFrameStats stats = RenderThread::GetInstance().GetLastFrameStats();
+
+    if (!mInitialized)
+        LoadResources();
+
+    if (mRefreshText && mSampleCount > 0) {
+        RebuildText(stats);
+        mRefreshText = false;
+    }
+
+    for (auto const & line : mLines)
+        line.Draw(packet, RenderLayer::HUD, mPtrTextRenderer);
+
+    DrawGraph(packet);
+}
+
+void PerfHud::RebuildText(RenderFrameStats const & stats) {
+    TimeManager const & timeManager = TimeManager::GetInstance();
+    FrameTimeSummary frame = timeManager.GetFrameStats(FramePhase::FRAME);
+    FramePacingStats pacing = timeManager.GetPacingStats();
+
+    char buffer[64];
+    mLines.clear();
+
+    snprintf(buffer, sizeof(buffer), "FPS %.0f  avg %.2f ms  jitter %.2f ms",
+             frame.meanMs > 0.0 ? 1000.0 / frame.meanMs : 0.0,
+             frame.meanMs,
+             pacing.jitterMs);
+    AddLine(buffer, 0);
+
+    snprintf(buffer, sizeof(buffer), "p50 %.1f  p95 %.1f  p99 %.1f  max %.1f ms  jank %u",
+             frame.p50Ms, frame.p95Ms, frame.p99Ms, frame.maxMs, timeManager.GetJankCount());
+    AddLine(buffer, 1);
+
+    snprintf(buffer, sizeof(buffer), "draws %u  binds %u  stream %.1f KB  events %u",
+             stats.counters.drawCalls,
+             stats.counters.textureBinds,
+             stats.counters.streamedBytes / 1024.0,
+             static_cast<uint32_t>(Events::EventManager::Get().GetQueuedEventCount()));
+    AddLine(buffer, 2);
+
+    if (stats.gpuAvailable) {
+        snprintf(buffer, sizeof(buffer), "sim %.2f ms  gpu %.2f ms",
+                 static_cast<double>(mSimulationNs) * 1.0e-6,
+                 stats.gpuFrameMs);
+    }
+    else {
+        snprintf(buffer, sizeof(buffer), "sim %.2f ms  gpu n/a", static_cast<double>(mSimulationNs) * 1.0e-6);
+    }
+    AddLine(buffer, 3);
+
+    snprintf(buffer, sizeof(buffer), "gl state %u  skipped %u",
+             stats.counters.stateCalls,
+             stats.counters.redundantStateCalls);
+    AddLine(buffer, 4);
+}
+
+void PerfHud::AddLine(char const * text, size_t line) {
+    float baseline = PERF_HUD_MARGIN + PERF_HUD_LINE_HEIGHT * (line + 1);
+
+    UiString uiString {};
+    // One name per line keeps each line's cached layout, so only the changed tail of its numbers is laid out again.
+    uiString.name = "PerfHud";
+    uiString.name += static_cast<char>('0' + line);
+    uiString.text = text;
+    uiString.layout = LayoutType::LEFT;
+    uiString.charToCharDistPixels = 1;
+    uiString.color = PERF_HUD_TEXT_COLOR;
+    uiString.topLeft = {PERF_HUD_MARGIN, baseline};
+    uiString.bottomRight = uiString.topLeft;
+
+    FTString ftString {};
+    ftString.state = GameState::ACTIVE;
+    mPtrTextRenderer->CalcUiString(uiString, ftString);
+    // Glyph positions already include topLeft, don't offset them twice.
+    ftString.topLeft = {0.f, 0.f};
+    mLines.push_back(std::move(ftString));
+}
+
+void PerfHud::DrawGraph(RenderPacket & packet) {
+    float graphBottom = PERF_HUD_MARGIN + PERF_HUD_LINE_HEIGHT * (PERF_HUD_LINES + 1) + PERF_HUD_GRAPH_HEIGHT;
+    float pixelsPerMs = PERF_HUD_GRAPH_HEIGHT / PERF_HUD_GRAPH_MAX_MS;
+
+    size_t bars = std::min(mSampleCount, PERF_HUD_GRAPH_BARS);
+    for (size_t i = 0; i < bars; ++i) {
+        // Oldest sample on the left.
+        size_t sample = (mNextSample + PERF_HUD_SAMPLES - bars + i) % PERF_HUD_SAMPLES;
+        float frameMs = std::min(mFrameTimesMs[sample], PERF_HUD_GRAPH_MAX_MS);
+        float height = std::max(frameMs * pixelsPerMs, 1.f);
+
+        glm::vec3 const & color = frameMs <= PERF_HUD_BUDGET_MS * 1.05f ? PERF_HUD_OK_COLOR :
+                                  frameMs <= PERF_HUD_BUDGET_MS * 2.f ? PERF_HUD_SLOW_COLOR : PERF_HUD_JANK_COLOR;
+
+        packet.PushSprite(RenderLayer::HUD,
+                          *mPtrSpriteRenderer,
+                          *mPtrFillTexture,
+                          {PERF_HUD_MARGIN + i * PERF_HUD_GRAPH_BAR_WIDTH, graphBottom - height},
+                          {PERF_HUD_GRAPH_BAR_WIDTH - 1.f, height},
+                          0.f,
+                          color);
+    }
+
+    packet.PushSprite(RenderLayer::HUD,
+                      *mPtrSpriteRenderer,
+                      *mPtrFillTexture,
+                      {PERF_HUD_MARGIN, graphBottom - PERF_HUD_BUDGET_MS * pixelsPerMs},
+                      {PERF_HUD_GRAPH_BARS * PERF_HUD_GRAPH_BAR_WIDTH, 1.f},
+                      0.f,
+                      PERF_HUD_BUDGET_COLOR);
+}
+
+void PerfHud::ToggleDelegate(Events::IEventDataPtr ptrEvent) {
+    mVisible = !mVisible;
+    mRefreshText = true;
+    Log::info("PerfHud %s", mVisible ? "shown" : "hidden");
+}
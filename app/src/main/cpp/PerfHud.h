@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "TextRenderer.h"
+#include "SpriteRenderer.h"
+#include "Texture.h"
+#include "Events.h"
+#include "RenderPacket.h"
+#include "RenderThread.h"
+
+// Set to 1 to show the HUD from the first frame; a three finger tap toggles it at runtime either way.
+#ifndef FLAPPY_PERF_HUD
+#define FLAPPY_PERF_HUD 0
+#endif
+
+size_t const PERF_HUD_SAMPLES = 120;
+size_t const PERF_HUD_GRAPH_BARS = 60;
+double const PERF_HUD_REFRESH_SEC = 0.5;
+
+//---------------------------------------------------------------------------------------------------------------------
+// PerfHud
+// On-screen overlay with FPS, TimeManager's frame time percentiles, a frame time graph, draw calls, texture binds,
+// streamed vertex bytes, event queue depth, simulation tick cost, GPU frame time and GL state calls issued and skipped.
+// Text is rebuilt only every PERF_HUD_REFRESH_SEC; while hidden the HUD only records the frame time and its font is
+// not loaded at all.
+//---------------------------------------------------------------------------------------------------------------------
+class PerfHud {
+public:
+    PerfHud();
+    ~PerfHud();
+    PerfHud(PerfHud const &) = delete;
+    PerfHud & operator=(PerfHud const &) = delete;
+
+    void SetVisible(bool visible) { mVisible = visible; }
+    bool IsVisible() const { return mVisible; }
+
+    // Call once per frame, before anything is drawn.
+    void Update(double frameTimeSec);
+    void SetSimulationTime(uint64_t simulationNs) { mSimulationNs = simulationNs; }
+
+    // Record last. Draw calls, binds and GPU time are those of the last frame the render thread finished.
+    void Draw(RenderPacket & packet);
+
+    // Drops the GL resources; they are loaded again the next time the HUD is drawn.
+    void UnloadResources();
+
+    void ToggleDelegate(Events::IEventDataPtr ptrEvent);
+
+private:
+    void LoadResources();
+    void RebuildText(RenderFrameStats const & stats);
+    void AddLine(char const * text, size_t line);
+    void DrawGraph(RenderPacket & packet);
+
+private:
+    bool mVisible;
+    bool mInitialized;
+    bool mRefreshText;
+
+    std::shared_ptr<TextRenderer> mPtrTextRenderer;
+    std::unique_ptr<SpriteRenderer> mPtrSpriteRenderer;
+    std::shared_ptr<Texture> mPtrFillTexture;
+    std::vector<FTString> mLines;
+
+    std::array<float, PERF_HUD_SAMPLES> mFrameTimesMs;
+    size_t mNextSample;
+    size_t mSampleCount;
+
+    double mTimeAccumulator;
+    uint64_t mSimulationNs;
+};
@@ -0,0 +1,272 @@
+#include <cstdio>
+#include <algorithm>
+
+#include "Profiler.h"
+#include "TimeManager.h"
+#include "IdleScheduler.h"
+#include "Log.h"
+
+size_t const CHROME_TRACE_EVENTS_PER_CHECK = 256;
+
+std::atomic<bool> Profiler::sCapturing {false};
+
+//---------------------------------------------------------------------------------------------------------------------
+// ChromeTraceWriter
+// Owns a finished capture and writes it from idle time, a batch of events at a time, so finishing a capture doesn't
+// cost a frame.
+//---------------------------------------------------------------------------------------------------------------------
+class ChromeTraceWriter {
+public:
+    using ThreadName = std::pair<uint16_t, std::string>;
+
+    ChromeTraceWriter(std::string path,
+                      std::vector<ProfileEvent> events,
+                      std::vector<uint64_t> frameStartNs,
+                      std::vector<ThreadName> threadNames,
+                      uint32_t firstFrame,
+                      uint32_t dropped) : mPath(std::move(path)),
+                                          mEvents(std::move(events)),
+                                          mFrameStartNs(std::move(frameStartNs)),
+                                          mThreadNames(std::move(threadNames)),
+                                          mFirstFrame {firstFrame},
+                                          mDropped {dropped},
+                                          mPtrFile {nullptr},
+                                          mNextEvent {},
+                                          mOriginNs {},
+                                          mFirst {true}
+    {}
+
+    ~ChromeTraceWriter() {
+        if (mPtrFile)
+            fclose(mPtrFile);
+    }
+
+    ChromeTraceWriter(ChromeTraceWriter const &) = delete;
+    ChromeTraceWriter & operator=(ChromeTraceWriter const &) = delete;
+
+    // Returns true once the file is complete.
+    bool Step(uint64_t deadlineNs) {
+        if (!mPtrFile && !Begin())
+            return true;
+
+        while (mNextEvent < mEvents.size()) {
+            size_t end = std::min(mNextEvent + CHROME_TRACE_EVENTS_PER_CHECK, mEvents.size());
+            for (; mNextEvent < end; ++mNextEvent)
+                WriteEvent(mEvents[mNextEvent]);
+
+            if (TimeManager::GetTimeNowNs() >= deadlineNs)
+                return false;
+        }
+
+        fprintf(mPtrFile, "\n]}\n");
+        fclose(mPtrFile);
+        mPtrFile = nullptr;
+        Log::info("Profiler: %u events written to %s, %u dropped",
+                  static_cast<uint32_t>(mEvents.size()),
+                  mPath.c_str(),
+                  mDropped);
+        return true;
+    }
+
+private:
+    bool Begin() {
+        mPtrFile = fopen(mPath.c_str(), "w");
+        if (!mPtrFile) {
+            Log::error("Profiler: can't write %s", mPath.c_str());
+            return false;
+        }
+
+        mOriginNs = mFrameStartNs.empty() ? 0 : mFrameStartNs.front();
+        for (auto const & event : mEvents)
+            mOriginNs = std::min(mOriginNs, event.startNs);
+
+        fprintf(mPtrFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+        for (auto const & threadName : mThreadNames) {
+            Separator();
+            fprintf(mPtrFile, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                    static_cast<uint32_t>(threadName.first), threadName.second.c_str());
+        }
+
+        for (size_t i = 0; i < mFrameStartNs.size(); ++i) {
+            Separator();
+            fprintf(mPtrFile, "{\"name\":\"Frame %u\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,\"tid\":0}",
+                    static_cast<uint32_t>(mFirstFrame + i), ToMicros(mFrameStartNs[i]));
+        }
+        return true;
+    }
+
+    void WriteEvent(ProfileEvent const & event) {
+        Separator();
+        fprintf(mPtrFile,
+                "{\"name\":\"%s\",\"cat\":\"cpu\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,"
+                "\"args\":{\"frame\":%u,\"depth\":%u}}",
+                event.name,
+                ToMicros(event.startNs),
+                static_cast<double>(event.endNs - event.startNs) * 1.0e-3,
+                static_cast<uint32_t>(event.thread),
+                event.frame,
+                static_cast<uint32_t>(event.depth));
+    }
+
+    void Separator() {
+        if (!mFirst)
+            fprintf(mPtrFile, ",\n");
+        mFirst = false;
+    }
+
+    double ToMicros(uint64_t ns) const {
+        return static_cast<double>(ns - mOriginNs) * 1.0e-3;
+    }
+
+private:
+    std::string mPath;
+    std::vector<ProfileEvent> mEvents;
+    std::vector<uint64_t> mFrameStartNs;
+    std::vector<ThreadName> mThreadNames;
+    uint32_t mFirstFrame;
+    uint32_t mDropped;
+
+    FILE * mPtrFile;
+    size_t mNextEvent;
+    uint64_t mOriginNs;
+    bool mFirst;
+};
+
+static thread_local void * tPtrThreadData = nullptr;
+
+uint64_t ProfileScope::Now() {
+    return TimeManager::GetTimeNowNs();
+}
+
+Profiler::Profiler() : mDropped {0},
+                       mCaptureFirst {},
+                       mCaptureCount {},
+                       mFrame {},
+                       mFrameStart {}
+{}
+
+Profiler::ThreadData & Profiler::GetThreadData() {
+    if (!tPtrThreadData) {
+        std::lock_guard<std::mutex> lock(mThreadsMutex);
+        mThreads.emplace_back(new ThreadData);
+        ThreadData & data = *mThreads.back();
+        data.index = static_cast<uint16_t>(mThreads.size() - 1);
+        data.depth = 0;
+        data.name = "Thread " + std::to_string(data.index);
+        tPtrThreadData = &data;
+    }
+    return *static_cast<ThreadData*>(tPtrThreadData);
+}
+
+void Profiler::SetThreadName(char const * name) {
+    ThreadData & data = GetThreadData();
+    std::lock_guard<std::mutex> lock(mThreadsMutex);
+    data.name = name;
+}
+
+uint16_t Profiler::EnterScope() {
+    return GetThreadData().depth++;
+}
+
+void Profiler::LeaveScope() {
+    --GetThreadData().depth;
+}
+
+void Profiler::Record(ProfileEvent const & event) {
+    ThreadData & data = GetThreadData();
+    ProfileEvent * ptrEvent = data.events.BeginPush();
+    if (!ptrEvent) {
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    *ptrEvent = event;
+    ptrEvent->frame = mFrame.load(std::memory_order_relaxed);
+    ptrEvent->thread = data.index;
+    data.events.CommitPush();
+}
+
+void Profiler::RequestCapture(uint32_t firstFrame, uint32_t frameCount, std::string const & filePath) {
+    if (frameCount == 0)
+        return;
+
+    mCaptureFirst = firstFrame;
+    mCaptureCount = frameCount;
+    mCapturePath = filePath;
+    Log::info("Profiler: capture of frames %u..%u requested", firstFrame, firstFrame + frameCount - 1);
+}
+
+void Profiler::CaptureNextFrames(uint32_t frameCount, std::string const & filePath) {
+    RequestCapture(mFrame.load(std::memory_order_relaxed) + 1, frameCount, filePath);
+}
+
+void Profiler::BeginFrame() {
+    mFrameStart = TimeManager::GetTimeNowNs();
+
+    uint32_t frame = mFrame.load(std::memory_order_relaxed);
+    bool capture = !mCapturePath.empty() &&
+                   frame >= mCaptureFirst &&
+                   frame - mCaptureFirst < mCaptureCount;
+
+    if (capture && !IsCapturing()) {
+        // Throw away whatever was recorded by scopes that outlived the previous capture.
+        DrainThreads(false);
+        mCapturedEvents.clear();
+        mFrameStartNs.clear();
+        mDropped.store(0, std::memory_order_relaxed);
+    }
+
+    if (capture)
+        mFrameStartNs.push_back(mFrameStart);
+
+    sCapturing.store(capture, std::memory_order_relaxed);
+}
+
+void Profiler::EndFrame() {
+    if (IsCapturing()) {
+        DrainThreads(true);
+
+        if (mFrame.load(std::memory_order_relaxed) - mCaptureFirst + 1 == mCaptureCount) {
+            sCapturing.store(false, std::memory_order_relaxed);
+            DrainThreads(true);
+            FinishCapture();
+        }
+    }
+
+    mFrame.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Profiler::DrainThreads(bool keep) {
+    std::lock_guard<std::mutex> lock(mThreadsMutex);
+    for (auto const & ptrData : mThreads) {
+        while (ProfileEvent const * ptrEvent = ptrData->events.Front()) {
+            if (keep)
+                mCapturedEvents.push_back(*ptrEvent);
+            ptrData->events.PopFront();
+        }
+    }
+}
+
+void Profiler::FinishCapture() {
+    std::vector<ChromeTraceWriter::ThreadName> threadNames;
+    {
+        std::lock_guard<std::mutex> lock(mThreadsMutex);
+        for (auto const & ptrData : mThreads)
+            threadNames.emplace_back(ptrData->index, ptrData->name);
+    }
+
+    std::shared_ptr<ChromeTraceWriter> ptrWriter(new ChromeTraceWriter(std::move(mCapturePath),
+                                                                       std::move(mCapturedEvents),
+                                                                       std::move(mFrameStartNs),
+                                                                       std::move(threadNames),
+                                                                       mCaptureFirst,
+                                                                       mDropped.load(std::memory_order_relaxed)));
+    IdleScheduler::GetInstance().Post(IdlePriority::LOW, "Profiler::WriteChromeTrace", [ptrWriter](uint64_t deadlineNs) {
+        return ptrWriter->Step(deadlineNs);
+    });
+
+    mCapturePath.clear();
+    mCapturedEvents.clear();
+    mFrameStartNs.clear();
+}
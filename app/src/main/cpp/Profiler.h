@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "RingBuffer.h"
+
+// Scoped CPU markers. Compiled in by default; when no capture is running a marker costs one relaxed atomic load.
+#ifndef FLAPPY_PROFILER
+#define FLAPPY_PROFILER 1
+#endif
+
+struct ProfileEvent {
+    char const *    name;       // must point to a string literal
+    uint64_t        startNs;
+    uint64_t        endNs;
+    uint32_t        frame;
+    uint16_t        depth;
+    uint16_t        thread;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// Profiler
+// Every thread records closed scopes into its own lock-free ring. The main thread drains the rings at EndFrame()
+// while a capture is running and, once the requested range of frames is complete, hands the events to the
+// IdleScheduler which writes them in Chrome trace event format (load it in chrome://tracing or ui.perfetto.dev).
+//---------------------------------------------------------------------------------------------------------------------
+class Profiler {
+public:
+    static Profiler & GetInstance() {
+        static Profiler instance;
+        return instance;
+    }
+
+    static bool IsCapturing() { return sCapturing.load(std::memory_order_relaxed); }
+
+private:
+    Profiler();
+    Profiler(Profiler const &) = delete;
+    Profiler & operator=(Profiler const &) = delete;
+
+public:
+    ~Profiler() = default;
+
+    // Main thread only.
+    void BeginFrame();
+    void EndFrame();
+    uint32_t GetFrameIndex() const { return mFrame.load(std::memory_order_relaxed); }
+
+    // Captures frames [firstFrame, firstFrame + frameCount) into filePath.
+    void RequestCapture(uint32_t firstFrame, uint32_t frameCount, std::string const & filePath);
+    void CaptureNextFrames(uint32_t frameCount, std::string const & filePath);
+
+    // Any thread.
+    void SetThreadName(char const * name);
+    void Record(ProfileEvent const & event);
+    uint16_t EnterScope();
+    void LeaveScope();
+
+private:
+    static size_t const THREAD_RING_CAPACITY = 4096;
+    using EventRing = RingBuffer<ProfileEvent, THREAD_RING_CAPACITY>;
+
+    struct ThreadData {
+        EventRing       events;
+        std::string     name;
+        uint16_t        index;
+        uint16_t        depth;
+    };
+
+    ThreadData & GetThreadData();
+    void DrainThreads(bool keep);
+    void FinishCapture();
+
+private:
+    static std::atomic<bool> sCapturing;
+
+    mutable std::mutex mThreadsMutex;
+    std::vector<std::unique_ptr<ThreadData>> mThreads;
+    std::atomic<uint32_t> mDropped;
+
+    std::vector<ProfileEvent> mCapturedEvents;
+    std::vector<uint64_t> mFrameStartNs;
+    std::string mCapturePath;
+    uint32_t mCaptureFirst;
+    uint32_t mCaptureCount;
+    std::atomic<uint32_t> mFrame;
+    uint64_t mFrameStart;
+};
+
+
+class ProfileScope {
+public:
+    explicit ProfileScope(char const * name) : mName {nullptr} {
+        if (!Profiler::IsCapturing())
+            return;
+        mName = name;
+        mDepth = Profiler::GetInstance().EnterScope();
+        mStartNs = Now();
+    }
+
+    ~ProfileScope() {
+        if (!mName)
+            return;
+        Profiler::GetInstance().Record({mName, mStartNs, Now(), 0, mDepth, 0});
+        Profiler::GetInstance().LeaveScope();
+    }
+
+    ProfileScope(ProfileScope const &) = delete;
+    ProfileScope & operator=(ProfileScope const &) = delete;
+
+private:
+    static uint64_t Now();
+
+private:
+    char const * mName;
+    uint64_t mStartNs;
+    uint16_t mDepth;
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#if FLAPPY_PROFILER
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name)
+#endif
@@ -0,0 +1,121 @@
+#include <cassert>
+
+#include "RenderPacket.h"
+#include "SpriteRenderer.h"
+#include "ResourceManager.h"
+
+size_t const RENDER_PACKET_RESERVE_COMMANDS = 256;
+
+namespace {
+
+uint64_t MakeSortKey(RenderLayer layer, RenderStage stage, GLuint program, GLuint texture, uint16_t depth) {
+    // GL names are small integers; should they ever overflow their fields, keys only group less well.
+    return static_cast<uint64_t>(layer) << RENDER_KEY_LAYER_SHIFT |
+           static_cast<uint64_t>(stage) << RENDER_KEY_STAGE_SHIFT |
+           static_cast<uint64_t>(program & 0xFFu) << RENDER_KEY_PROGRAM_SHIFT |
+           static_cast<uint64_t>(texture & 0xFFFFu) << RENDER_KEY_TEXTURE_SHIFT |
+           static_cast<uint64_t>(depth) << RENDER_KEY_DEPTH_SHIFT;
+}
+
+}
+
+char const * RenderLayerToStr(RenderLayer layer) {
+    switch (layer) {
+        case RenderLayer::ACTORS:    return "ACTORS";
+        case RenderLayer::OBSTACLES: return "OBSTACLES";
+        case RenderLayer::UI:        return "UI";
+        case RenderLayer::HUD:       return "HUD";
+        default:                     return "UNKNOWN";
+    }
+}
+
+RenderPacket::RenderPacket() : mFrameIndex {},
+                               mClearColor {},
+                               mCommands {},
+                               mSortKeys {},
+                               mTexts {},
+                               mTextCount {},
+                               mTextBatches {}
+{
+    mCommands.reserve(RENDER_PACKET_RESERVE_COMMANDS);
+    mSortKeys.reserve(RENDER_PACKET_RESERVE_COMMANDS);
+}
+
+void RenderPacket::Reset(uint64_t frameIndex) {
+    mFrameIndex = frameIndex;
+    mClearColor = {};
+    mCommands.clear();
+    mSortKeys.clear();
+    mTextCount = 0;
+    mTextBatches.clear();
+}
+
+void RenderPacket::Push(RenderCommand const & command, uint64_t key) {
+    assert(mCommands.size() < RENDER_PACKET_MAX_COMMANDS);
+    mSortKeys.push_back(key | mCommands.size());
+    mCommands.push_back(command);
+}
+
+void RenderPacket::PushSprite(RenderLayer layer,
+                              SpriteRenderer & spriteRenderer,
+                              Texture & texture,
+                              glm::vec2 const & position,
+                              glm::vec2 const & size,
+                              float rotateDegrees,
+                              glm::vec3 const & color,
+                              glm::vec4 const & uvRect,
+                              uint16_t depth)
+{
+    ResourceManager::UseTexture(texture);
+
+    RenderCommand command {};
+    command.type = RenderCommandType::SPRITE;
+    command.ptrSpriteRenderer = &spriteRenderer;
+    command.ptrTexture = &texture;
+    command.position = position;
+    command.size = size;
+    command.rotateDegrees = rotateDegrees;
+    command.color = color;
+    command.uvRect = uvRect;
+    Push(command, MakeSortKey(layer, RenderStage::DRAW, spriteRenderer.GetProgramId(), texture.GetId(), depth));
+}
+
+void RenderPacket::PushText(RenderLayer layer, TextRenderer & textRenderer, FTString const & ftString, uint16_t depth) {
+    if (mTextCount == mTexts.size())
+        mTexts.emplace_back();
+    mTexts[mTextCount] = ftString;
+
+    RenderCommand command {};
+    command.type = RenderCommandType::TEXT;
+    command.ptrTextRenderer = &textRenderer;
+    command.textIndex = mTextCount++;
+    // Glyphs bind their own textures, so text only groups by program.
+    Push(command, MakeSortKey(layer, RenderStage::DRAW, textRenderer.GetProgramId(), 0, depth));
+}
+
+void RenderPacket::PushTextBatch(RenderLayer layer,
+                                 TextRenderer & textRenderer,
+                                 TextBatchPtr const & ptrBatch,
+                                 uint16_t depth)
+{
+    RenderCommand command {};
+    command.type = RenderCommandType::TEXT_BATCH;
+    command.ptrTextRenderer = &textRenderer;
+    command.textIndex = mTextBatches.size();
+    mTextBatches.push_back(ptrBatch);
+    Push(command, MakeSortKey(layer, RenderStage::DRAW, textRenderer.GetProgramId(), 0, depth));
+}
+
+void RenderPacket::BeginGpuPass(GpuPass pass, RenderLayer firstLayer) {
+    RenderCommand command {};
+    command.type = RenderCommandType::BEGIN_GPU_PASS;
+    command.gpuPass = pass;
+    Push(command, MakeSortKey(firstLayer, RenderStage::BEGIN_PASS, 0, 0, 0));
+}
+
+void RenderPacket::EndGpuPass(GpuPass pass, RenderLayer lastLayer) {
+    RenderCommand command {};
+    command.type = RenderCommandType::END_GPU_PASS;
+    command.gpuPass = pass;
+    Push(command, MakeSortKey(lastLayer, RenderStage::END_PASS, 0, 0, 0));
+}
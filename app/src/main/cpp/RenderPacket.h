@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "GpuProfiler.h"
+#include "TextRenderer.h"
+
+class SpriteRenderer;
+class Texture;
+
+// Texture coordinates as (u0, v0, u1, v1); the whole texture by default.
+glm::vec4 const SPRITE_UV_FULL {0.f, 0.f, 1.f, 1.f};
+
+// Paint order of a frame, back to front. Inside a layer commands of equal depth are grouped by program and texture
+// rather than kept in recording order, so whatever has to cover something else goes into a later layer or gets a larger
+// depth.
+enum class RenderLayer : uint8_t {
+    ACTORS,
+    OBSTACLES,
+    UI,
+    HUD,
+    COUNT
+};
+
+char const * RenderLayerToStr(RenderLayer layer);
+
+// Where a command sits inside its layer: GPU pass markers enclose the draws of the layers they time.
+enum class RenderStage : uint8_t {
+    BEGIN_PASS,
+    DRAW,
+    END_PASS,
+    COUNT
+};
+
+// 64-bit sort key, most significant first: layer 4 | stage 2 | depth 16 | program 8 | texture 16 | command 18. Depth
+// paints over program and texture, which only group draws at the same depth. The command index makes every key unique
+// and keeps recording order between otherwise equal draws.
+uint32_t const RENDER_KEY_COMMAND_BITS = 18;
+uint32_t const RENDER_KEY_TEXTURE_SHIFT = RENDER_KEY_COMMAND_BITS;
+uint32_t const RENDER_KEY_PROGRAM_SHIFT = RENDER_KEY_TEXTURE_SHIFT + 16;
+uint32_t const RENDER_KEY_DEPTH_SHIFT = RENDER_KEY_PROGRAM_SHIFT + 8;
+uint32_t const RENDER_KEY_STAGE_SHIFT = RENDER_KEY_DEPTH_SHIFT + 16;
+uint32_t const RENDER_KEY_LAYER_SHIFT = RENDER_KEY_STAGE_SHIFT + 2;
+uint64_t const RENDER_KEY_COMMAND_MASK = (uint64_t {1} << RENDER_KEY_COMMAND_BITS) - 1;
+size_t const RENDER_PACKET_MAX_COMMANDS = size_t {1} << RENDER_KEY_COMMAND_BITS;
+
+static_assert(static_cast<uint32_t>(RenderLayer::COUNT) <= 16, "RenderLayer must fit in 4 key bits");
+
+enum class RenderCommandType : uint8_t {
+    SPRITE,
+    TEXT,
+    TEXT_BATCH,
+    BEGIN_GPU_PASS,
+    END_GPU_PASS,
+    COUNT
+};
+
+// One entry of a packet. Renderers and textures are referenced, not owned: they are only released while the render
+// thread is paused (see GLContextScope), and a pause drains every submitted packet first.
+struct RenderCommand {
+    RenderCommandType       type;
+    GpuPass                 gpuPass;
+    SpriteRenderer *        ptrSpriteRenderer;
+    Texture const *         ptrTexture;
+    glm::vec2               position;
+    glm::vec2               size;
+    float                   rotateDegrees;
+    glm::vec3               color;
+    glm::vec4               uvRect;
+    TextRenderer *          ptrTextRenderer;
+    size_t                  textIndex;      // into the packet's texts, or its text batches for TEXT_BATCH
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// RenderPacket
+// Everything the render thread needs to draw one frame, recorded by the simulation thread and read-only once
+// submitted. Every command gets a sort key next to it and the render thread draws in key order (see RenderQueue), so
+// recording order only matters between equal keys. Text is copied in because Ui rebuilds its strings from event
+// delegates while older frames are still being drawn; text slots are kept between frames so the copies reuse their
+// capacity. Text batches are immutable and only referenced.
+//---------------------------------------------------------------------------------------------------------------------
+class RenderPacket {
+public:
+    RenderPacket();
+
+    void Reset(uint64_t frameIndex);
+
+    void SetClearColor(glm::vec4 const & color) { mClearColor = color; }
+    void PushSprite(RenderLayer layer,
+                    SpriteRenderer & spriteRenderer,
+                    Texture & texture,
+                    glm::vec2 const & position,
+                    glm::vec2 const & size,
+                    float rotateDegrees,
+                    glm::vec3 const & color,
+                    glm::vec4 const & uvRect = SPRITE_UV_FULL,
+                    uint16_t depth = 0);
+    void PushText(RenderLayer layer, TextRenderer & textRenderer, FTString const & ftString, uint16_t depth = 0);
+    // Shares the batch instead of copying it; see TextRenderer::DrawBatch.
+    void PushTextBatch(RenderLayer layer,
+                       TextRenderer & textRenderer,
+                       TextBatchPtr const & ptrBatch,
+                       uint16_t depth = 0);
+
+    // The pass times everything from the start of firstLayer to the end of lastLayer.
+    void BeginGpuPass(GpuPass pass, RenderLayer firstLayer);
+    void EndGpuPass(GpuPass pass, RenderLayer lastLayer);
+
+    uint64_t GetFrameIndex() const { return mFrameIndex; }
+    glm::vec4 const & GetClearColor() const { return mClearColor; }
+    std::vector<RenderCommand> const & GetCommands() const { return mCommands; }
+    std::vector<uint64_t> const & GetSortKeys() const { return mSortKeys; }
+    FTString const & GetText(size_t index) const { return mTexts[index]; }
+    TextBatchPtr const & GetTextBatch(size_t index) const { return mTextBatches[index]; }
+
+private:
+    uint64_t mFrameIndex;
+    glm::vec4 mClearColor;
+    std::vector<RenderCommand> mCommands;
+    std::vector<uint64_t> mSortKeys;
+    std::vector<FTString> mTexts;
+    size_t mTextCount;
+    std::vector<TextBatchPtr> mTextBatches;
+
+private:
+    void Push(RenderCommand const & command, uint64_t key);
+};
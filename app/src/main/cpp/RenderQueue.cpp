@@ -0,0 +1,46 @@
+#include "RenderQueue.h"
+#include "Profiler.h"
+
+std::vector<RenderCommand> const & RenderQueue::Sort(RenderPacket const & packet) {
+    PROFILE_SCOPE("RenderQueue::Sort");
+    std::vector<RenderCommand> const & commands = packet.GetCommands();
+    std::vector<uint64_t> const & keys = packet.GetSortKeys();
+    size_t count = keys.size();
+
+    mSorted.clear();
+    if (count == 0)
+        return mSorted;
+
+    mKeys.assign(keys.begin(), keys.end());
+    mScratch.resize(count);
+
+    for (auto & histogram : mHistograms)
+        histogram.fill(0);
+    for (uint64_t key : mKeys) {
+        for (size_t pass = 0; pass < RENDER_QUEUE_RADIX_PASSES; ++pass)
+            ++mHistograms[pass][(key >> (pass * RENDER_QUEUE_RADIX_BITS)) & (RENDER_QUEUE_RADIX_BUCKETS - 1)];
+    }
+
+    for (size_t pass = 0; pass < RENDER_QUEUE_RADIX_PASSES; ++pass) {
+        uint32_t shift = static_cast<uint32_t>(pass * RENDER_QUEUE_RADIX_BITS);
+        auto & histogram = mHistograms[pass];
+        if (histogram[(mKeys[0] >> shift) & (RENDER_QUEUE_RADIX_BUCKETS - 1)] == count)
+            continue;
+
+        uint32_t offset {};
+        for (auto & bucket : histogram) {
+            uint32_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+
+        for (uint64_t key : mKeys)
+            mScratch[histogram[(key >> shift) & (RENDER_QUEUE_RADIX_BUCKETS - 1)]++] = key;
+        mKeys.swap(mScratch);
+    }
+
+    mSorted.reserve(count);
+    for (uint64_t key : mKeys)
+        mSorted.push_back(commands[key & RENDER_KEY_COMMAND_MASK]);
+    return mSorted;
+}
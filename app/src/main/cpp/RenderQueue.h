@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "RenderPacket.h"
+
+uint32_t const RENDER_QUEUE_RADIX_BITS = 8;
+size_t const RENDER_QUEUE_RADIX_BUCKETS = size_t {1} << RENDER_QUEUE_RADIX_BITS;
+size_t const RENDER_QUEUE_RADIX_PASSES = 64 / RENDER_QUEUE_RADIX_BITS;
+
+//---------------------------------------------------------------------------------------------------------------------
+// RenderQueue
+// Puts the commands of a packet in sort key order with an LSD radix sort over the 64-bit keys, one byte per pass.
+// Histograms for all passes are gathered in a single sweep and a pass is skipped when every key has the same byte
+// there, which for a frame of a few hundred keys leaves about half of them. Draws sharing program and texture end up
+// next to each other, which is what lets the render thread batch them. Render thread only; buffers are reused.
+//---------------------------------------------------------------------------------------------------------------------
+class RenderQueue {
+public:
+    RenderQueue() = default;
+    RenderQueue(RenderQueue const &) = delete;
+    RenderQueue & operator=(RenderQueue const &) = delete;
+
+    // The returned commands stay valid until the next Sort().
+    std::vector<RenderCommand> const & Sort(RenderPacket const & packet);
+
+private:
+    std::vector<uint64_t> mKeys;
+    std::vector<uint64_t> mScratch;
+    std::vector<RenderCommand> mSorted;
+    std::array<std::array<uint32_t, RENDER_QUEUE_RADIX_BUCKETS>, RENDER_QUEUE_RADIX_PASSES> mHistograms;
+};
@@ -0,0 +1,231 @@
+#include <cassert>
+
+#include "RenderThread.h"
+#include "SpriteRenderer.h"
+#include "StreamBuffer.h"
+#include "Profiler.h"
+#include "Log.h"
+
+RenderThread::RenderThread() : mPackets {},
+                               mWriteIndex {},
+                               mReadIndex {},
+                               mQueuedPackets {},
+                               mNextFrameIndex {},
+                               mPauseDepth {},
+                               mPauseRequested {false},
+                               mPaused {false},
+                               mRunning {false},
+                               mHasContext {false},
+                               mLastStats {},
+                               mThread {},
+                               mMutex {},
+                               mCondition {}
+{}
+
+RenderThread::~RenderThread() {
+    Stop();
+}
+
+void RenderThread::Start() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mRunning)
+        return;
+
+    // The context may be current here from before the thread existed; it can only be current on one thread.
+    if (mPauseDepth == 0)
+        GLState::GetInstance().ReleaseCurrent();
+
+    mRunning = true;
+    mThread = std::thread(&RenderThread::ThreadLoop, this);
+    Log::info("RenderThread started, %zu packets", RENDER_PACKET_COUNT);
+}
+
+void RenderThread::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mRunning)
+            return;
+        mRunning = false;
+    }
+    mCondition.notify_all();
+    mThread.join();
+    Log::info("RenderThread stopped");
+}
+
+RenderPacket & RenderThread::AcquirePacket() {
+    PROFILE_SCOPE("RenderThread::AcquirePacket");
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCondition.wait(lock, [this] { return mQueuedPackets < RENDER_PACKET_COUNT - 1; });
+
+    RenderPacket & packet = mPackets[mWriteIndex];
+    packet.Reset(mNextFrameIndex++);
+    return packet;
+}
+
+void RenderThread::SubmitPacket() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mWriteIndex = (mWriteIndex + 1) % RENDER_PACKET_COUNT;
+    ++mQueuedPackets;
+    lock.unlock();
+    mCondition.notify_all();
+
+    if (!mRunning) {
+        // No thread to hand it to (e.g. before Start), draw it here.
+        GLContextScope scope;
+    }
+}
+
+void RenderThread::Pause() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (mPauseDepth++ > 0)
+        return;
+
+    if (mRunning) {
+        mPauseRequested = true;
+        mCondition.notify_all();
+        mCondition.wait(lock, [this] { return mPaused; });
+    }
+    else {
+        // Nobody else draws them, so drain the queue on this thread.
+        while (mQueuedPackets > 0) {
+            if (!mHasContext)
+                mHasContext = GLState::GetInstance().MakeCurrent();
+            mLastStats = Execute(mPackets[mReadIndex]);
+            mReadIndex = (mReadIndex + 1) % RENDER_PACKET_COUNT;
+            --mQueuedPackets;
+        }
+        mHasContext = false;
+    }
+
+    GLState::GetInstance().MakeCurrent();
+}
+
+void RenderThread::Resume() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    assert(mPauseDepth > 0);
+    if (--mPauseDepth > 0)
+        return;
+
+    GLState::GetInstance().ReleaseCurrent();
+    mPauseRequested = false;
+    lock.unlock();
+    mCondition.notify_all();
+}
+
+RenderFrameStats RenderThread::GetLastFrameStats() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mLastStats;
+}
+
+void RenderThread::ThreadLoop() {
+    Profiler::GetInstance().SetThreadName("Render");
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        mCondition.wait(lock, [this] { return mQueuedPackets > 0 || mPauseRequested || !mRunning; });
+
+        // Submitted packets are drawn before a stop or pause is honoured.
+        if (mQueuedPackets > 0) {
+            RenderPacket const & packet = mPackets[mReadIndex];
+            lock.unlock();
+            if (!mHasContext)
+                mHasContext = GLState::GetInstance().MakeCurrent();
+            RenderFrameStats stats = Execute(packet);
+            lock.lock();
+
+            mLastStats = stats;
+            mReadIndex = (mReadIndex + 1) % RENDER_PACKET_COUNT;
+            --mQueuedPackets;
+            mCondition.notify_all();
+            continue;
+        }
+
+        if (!mRunning)
+            break;
+
+        if (mPauseRequested) {
+            if (mHasContext) {
+                GLState::GetInstance().ReleaseCurrent();
+                mHasContext = false;
+            }
+            mPaused = true;
+            mCondition.notify_all();
+            mCondition.wait(lock, [this] { return !mPauseRequested || !mRunning; });
+            mPaused = false;
+        }
+    }
+
+    if (mHasContext) {
+        GLState::GetInstance().ReleaseCurrent();
+        mHasContext = false;
+    }
+}
+
+RenderFrameStats RenderThread::Execute(RenderPacket const & packet) {
+    PROFILE_SCOPE("RenderThread::Execute");
+    RenderFrameStats stats {};
+    stats.frameIndex = packet.GetFrameIndex();
+
+    // Without a window there is nothing to draw to, the frame is dropped.
+    if (!mHasContext)
+        return stats;
+
+    GpuProfiler & gpuProfiler = GpuProfiler::GetInstance();
+    gpuProfiler.BeginFrame();
+    StreamBuffer::GetInstance().BeginFrame();
+
+    glm::vec4 const & clearColor = packet.GetClearColor();
+    glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    std::vector<RenderCommand> const & commands = mRenderQueue.Sort(packet);
+    for (size_t index = 0; index < commands.size(); ++index) {
+        RenderCommand const & command = commands[index];
+        switch (command.type) {
+            case RenderCommandType::SPRITE: {
+                // Consecutive sprites of one renderer and texture go out as a single batch.
+                size_t last = index + 1;
+                while (last < commands.size() &&
+                       commands[last].type == RenderCommandType::SPRITE &&
+                       commands[last].ptrSpriteRenderer == command.ptrSpriteRenderer &&
+                       commands[last].ptrTexture == command.ptrTexture) {
+                    ++last;
+                }
+                command.ptrSpriteRenderer->DrawSprites(*command.ptrTexture, &command, last - index);
+                index = last - 1;
+                break;
+            }
+
+            case RenderCommandType::TEXT:
+                command.ptrTextRenderer->Draw(packet.GetText(command.textIndex));
+                break;
+
+            case RenderCommandType::TEXT_BATCH:
+                command.ptrTextRenderer->DrawBatch(packet.GetTextBatch(command.textIndex));
+                break;
+
+            case RenderCommandType::BEGIN_GPU_PASS:
+                gpuProfiler.BeginPass(command.gpuPass);
+                break;
+
+            case RenderCommandType::END_GPU_PASS:
+                gpuProfiler.EndPass(command.gpuPass);
+                GLState::GetInstance().CheckGLError(GpuPassToStr(command.gpuPass));
+                break;
+
+            default:
+                assert(false);
+                break;
+        }
+    }
+
+    StreamBuffer::GetInstance().EndFrame();
+    gpuProfiler.EndFrame();
+
+    stats.counters = GLState::GetInstance().GetRenderStats();
+    stats.gpuAvailable = gpuProfiler.IsAvailable();
+    stats.gpuFrameMs = gpuProfiler.GetPassTimeMs(GpuPass::FRAME);
+
+    GLState::GetInstance().Swap();
+    return stats;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "RenderPacket.h"
+#include "RenderQueue.h"
+#include "GLState.h"
+
+// One packet being drawn, one queued behind it, one being recorded: the frame being simulated is up to two frames
+// ahead of the one being drawn. Two packets would hold it to one frame but lose the queued frame that absorbs a slow
+// one.
+size_t const RENDER_PACKET_COUNT = 3;
+
+// Published by the render thread after each swap, for the HUD.
+struct RenderFrameStats {
+    RenderStats counters;
+    double      gpuFrameMs;
+    bool        gpuAvailable;
+    uint64_t    frameIndex;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// RenderThread
+// Owns the GL context and turns submitted RenderPackets into GL calls and a swap, so the simulation of frame N+1
+// overlaps with the submission of frame N and a blocking eglSwapBuffers no longer stalls the game loop. The main
+// thread records into AcquirePacket() and hands it over with SubmitPacket(); acquiring blocks while the render thread
+// is RENDER_PACKET_COUNT - 1 frames behind, which keeps the game paced to vsync. Any other GL work (window changes,
+// resource loading) must happen inside a GLContextScope.
+//---------------------------------------------------------------------------------------------------------------------
+class RenderThread {
+public:
+    static RenderThread & GetInstance() {
+        static RenderThread instance;
+        return instance;
+    }
+
+private:
+    RenderThread();
+    RenderThread(RenderThread const &) = delete;
+    RenderThread & operator=(RenderThread const &) = delete;
+
+public:
+    ~RenderThread();
+
+    void Start();
+    void Stop();
+
+    // Main thread only.
+    RenderPacket & AcquirePacket();
+    void SubmitPacket();
+
+    // Draws every submitted packet, then moves the context to the calling thread until the matching Resume().
+    // Nests; use GLContextScope rather than calling these directly.
+    void Pause();
+    void Resume();
+
+    RenderFrameStats GetLastFrameStats() const;
+
+private:
+    void ThreadLoop();
+    RenderFrameStats Execute(RenderPacket const & packet);
+
+private:
+    std::array<RenderPacket, RENDER_PACKET_COUNT> mPackets;
+    size_t mWriteIndex;
+    size_t mReadIndex;
+    size_t mQueuedPackets;          // submitted and not yet drawn, including the one being drawn
+    uint64_t mNextFrameIndex;
+
+    uint32_t mPauseDepth;
+    bool mPauseRequested;
+    bool mPaused;
+    bool mRunning;
+    bool mHasContext;               // render thread only
+
+    RenderFrameStats mLastStats;
+    RenderQueue mRenderQueue;       // render thread only
+
+    std::thread mThread;
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// GLContextScope
+// Makes the GL context current on the calling thread for the lifetime of the scope, pausing the render thread. There is
+// no context to make current while the window is gone (between APP_CMD_TERM_WINDOW and APP_CMD_INIT_WINDOW): GL calls
+// in the scope are then silently dropped, so code that must know whether they ran checks HasContext().
+//---------------------------------------------------------------------------------------------------------------------
+class GLContextScope {
+public:
+    GLContextScope() { RenderThread::GetInstance().Pause(); }
+    ~GLContextScope() { RenderThread::GetInstance().Resume(); }
+    bool HasContext() const { return GLState::GetInstance().IsCurrent(); }
+    GLContextScope(GLContextScope const &) = delete;
+    GLContextScope & operator=(GLContextScope const &) = delete;
+};
@@ -13,24 +13,53 @@
 #include "GLState.h"
 #include "Android.h"
 #include "Utilities.h"
-
-TextureMap ResourceManager::mTextures;
-ShaderMap ResourceManager::mShaders;
+#include "Ktx.h"
+#include "RenderThread.h"
+
+NameTable ResourceManager::mNames;
+HandlePool<Shader> ResourceManager::mShaders;
+HandlePool<Texture> ResourceManager::mTextures;
+std::vector<ShaderHandle> ResourceManager::mShadersByName;
+std::vector<TextureHandle> ResourceManager::mTexturesByName;
+FontMap ResourceManager::mFonts;
+size_t ResourceManager::mTextureBudget = TEXTURE_BUDGET_BYTES;
+uint64_t ResourceManager::mFrame = 1;
+GameState ResourceManager::mFrameState = GameState::START;
 UiStringMap ResourceManager::mUiStrings;
-std::vector<std::string> ResourceManager::mTextureNames;
+
+namespace {
+
+// The handle interned under id, null if there is none.
+template <typename T>
+Handle<T> FindHandle(std::vector<Handle<T>> const & byName, NameId id) {
+    return id < byName.size() ? byName[id] : Handle<T> {};
+}
+
+template <typename T>
+void SetHandle(std::vector<Handle<T>> & byName, NameId id, Handle<T> handle) {
+    if (id >= byName.size())
+        byName.resize(id + 1);
+    byName[id] = handle;
+}
+
+}
 
 //Shader-specific functions
-Shader & ResourceManager::GetShader(std::string const &name) {
-    auto it = mShaders.find(name);
-    assert(it != mShaders.end());
-    return it->second;
+ShaderHandle ResourceManager::FindShader(std::string const &name) {
+    ShaderHandle handle = FindHandle(mShadersByName, mNames.Find(name));
+    if (!mShaders.Get(handle)) {
+        Log::error("RESOURCE MANAGER : no shader %s", name.c_str());
+        assert(false);
+    }
+    return handle;
 }
 
-void ResourceManager::LoadShader(std::string const &vsFilePath,
-                                 std::string const &fsFilePath,
-                                 std::string const &programName) {
-    auto result = mShaders.find(programName);
-    if(result == mShaders.end()) {
+ShaderHandle ResourceManager::LoadShader(std::string const &vsFilePath,
+                                         std::string const &fsFilePath,
+                                         std::string const &programName) {
+    NameId id = mNames.Intern(programName);
+    ShaderHandle handle = FindHandle(mShadersByName, id);
+    if(!mShaders.Get(handle)) {
 
         std::vector<uint8_t> vsSourceRaw{};
         Read(vsFilePath, vsSourceRaw);
@@ -38,72 +67,218 @@ void ResourceManager::LoadShader(std::string const &vsFilePath,
         std::vector<uint8_t> fsSourceRaw{};
         Read(fsFilePath, fsSourceRaw);
 
-        mShaders.insert(std::make_pair(programName, Shader{}));
-        mShaders[programName].CreateProgram(std::string{vsSourceRaw.begin(), vsSourceRaw.end()},
-                                             std::string{fsSourceRaw.begin(), fsSourceRaw.end()});
+        std::unique_ptr<Shader> ptrShader(new Shader);
+        ptrShader->CreateProgram(std::string{vsSourceRaw.begin(), vsSourceRaw.end()},
+                                 std::string{fsSourceRaw.begin(), fsSourceRaw.end()});
+        handle = mShaders.Add(std::move(ptrShader));
+        SetHandle(mShadersByName, id, handle);
 
         Log::debug("LOAD SHADER SUCCESS : %s", vsFilePath.c_str());
         Log::debug("LOAD SHADER SUCCESS : %s", fsFilePath.c_str());
     }
+    return handle;
 }
 
 
 
 //Texture-specific functions
-std::shared_ptr<Texture> ResourceManager::GetTexture(std::string const &name) {
-    auto it = mTextures.find(name);
-    assert(it != mTextures.end());
-    return it->second;
+TextureHandle ResourceManager::FindTexture(std::string const &name) {
+    TextureHandle handle = FindHandle(mTexturesByName, mNames.Find(name));
+    if (!mTextures.Get(handle)) {
+        Log::error("RESOURCE MANAGER : no texture %s", name.c_str());
+        assert(false);
+    }
+    return handle;
 }
 
-void ResourceManager::LoadTexture(std::string const &textureFilePath,
-                                  GLboolean alpha,
-                                  std::string const &name) {
-    mTextures[name] = std::make_shared<Texture>(Texture {});
-    mTextureNames.push_back(name);
+TextureHandle ResourceManager::LoadTexture(std::string const &textureFilePath,
+                                           GLboolean alpha,
+                                           std::string const &name) {
+    NameId id = mNames.Intern(name);
+    mTextures.Remove(FindHandle(mTexturesByName, id));
+
+    std::unique_ptr<Texture> ptrTexture(new Texture);
+    ptrTexture->SetSource(textureFilePath, alpha);
+    Texture & texture = *ptrTexture;
+    TextureHandle handle = mTextures.Add(std::move(ptrTexture));
+    SetHandle(mTexturesByName, id, handle);
+
+    LoadTextureData(texture);
+    return handle;
+}
 
+void ResourceManager::LoadTextureData(Texture & texture) {
+    std::string const & textureFilePath = texture.GetSourcePath();
+    GLboolean alpha = texture.GetSourceAlpha();
     if (alpha) {
-        mTextures[name]->SetImageFormat(GL_RGBA);
-        mTextures[name]->SetInternalFormat(GL_RGBA);
+        texture.SetImageFormat(GL_RGBA);
+        texture.SetInternalFormat(GL_RGBA);
     }
 
-    int32_t width{};
-    int32_t height{};
-
     Log::info("LOADING TEXTURE %s", textureFilePath.c_str());
+    if (!LoadCompressedTexture(textureFilePath, texture)) {
+        int32_t width{};
+        int32_t height{};
+
+        std::vector<uint8_t> textureRaw {};
+        Read(textureFilePath, textureRaw);
+
+        // Only the size is wanted here, Generate decodes again.
+        unsigned char * ptrPixels = SOIL_load_image_from_memory(textureRaw.data(),
+                                                                textureRaw.size(),
+                                                                &width,
+                                                                &height,
+                                                                nullptr,
+                                                                alpha ? SOIL_LOAD_RGBA : SOIL_LOAD_RGB);
+        SOIL_free_image_data(ptrPixels);
+
+        texture.Generate(width, height, textureRaw);
+
+        Log::info("LOADED TEXTURE %s SUCCESS", textureFilePath.c_str());
+    }
+
+    ReleaseOverBudget(texture);
+}
+
+// Least recently drawn first, never one drawn this frame: the packet being recorded may point at it.
+void ResourceManager::ReleaseOverBudget(Texture const & loaded) {
+    size_t residentBytes = GetMemoryReport().residentTextureBytes;
+    while (residentBytes > mTextureBudget) {
+        Texture * ptrOldest = nullptr;
+        mTextures.ForEach([&](TextureHandle, Texture & texture) {
+            if (!texture.IsResident() || &texture == &loaded || texture.GetLastUse() == mFrame)
+                return;
+            if (!ptrOldest || texture.GetLastUse() < ptrOldest->GetLastUse())
+                ptrOldest = &texture;
+        });
+        if (!ptrOldest) {
+            Log_warn("RESOURCE MANAGER : %zu KB of textures in use, over the %zu KB budget",
+                     residentBytes / 1024,
+                     mTextureBudget / 1024);
+            return;
+        }
+
+        if (!ptrOldest->Release())
+            return;
+        Log::info("RESOURCE MANAGER : over budget, released %s", ptrOldest->GetSourcePath().c_str());
+        residentBytes -= ptrOldest->GetSizeBytes();
+    }
+}
 
-    std::vector<uint8_t> textureRaw {};
-    Read(textureFilePath, textureRaw);
+void ResourceManager::SetTextureBudget(size_t bytes) {
+    mTextureBudget = bytes;
+}
+
+void ResourceManager::BeginFrame(GameState gameState) {
+    ++mFrame;
+    mFrameState = gameState;
+}
+
+void ResourceManager::UseTexture(Texture & texture) {
+    texture.MarkUsed(mFrame, 1u << static_cast<uint32_t>(mFrameState));
+    if (texture.IsResident() || texture.GetSourcePath().empty())
+        return;
+
+    // Released earlier, back before it is drawn. Loading pauses the render thread for the GL context.
+    GLContextScope glContext;
+    LoadTextureData(texture);
+}
+
+size_t ResourceManager::ReleaseTextures(GameState gameState) {
+    size_t releasedBytes {};
+    uint32_t stateBit = 1u << static_cast<uint32_t>(gameState);
+    mTextures.ForEach([&](TextureHandle, Texture & texture) {
+        if (!texture.IsResident() || (texture.GetUseStates() & stateBit) != 0)
+            return;
+        if (texture.Release())
+            releasedBytes += texture.GetSizeBytes();
+    });
+    return releasedBytes;
+}
+
+MemoryReport ResourceManager::GetMemoryReport() {
+    MemoryReport report {};
+    report.textureBudgetBytes = mTextureBudget;
+    report.textureCount = mTextures.GetSize();
+    mTextures.ForEach([&report](TextureHandle, Texture const & texture) {
+        if (texture.IsResident()) {
+            ++report.residentTextureCount;
+            report.residentTextureBytes += texture.GetSizeBytes();
+        }
+        else {
+            report.releasedTextureBytes += texture.GetSizeBytes();
+        }
+    });
+
+    report.fontCount = mFonts.size();
+    for (auto const & entry : mFonts) {
+        report.fontAtlasBytes += entry.second->GetTextureBytes();
+        report.fontFileBytes += entry.second->GetFontFileBytes();
+    }
+    return report;
+}
 
-    SOIL_load_image_from_memory(textureRaw.data(),
-                                textureRaw.size(),
-                                &width,
-                                &height,
-                                nullptr,
-                                alpha ? SOIL_LOAD_RGBA : SOIL_LOAD_RGB);
+// A KTX next to the image, made by tools/TextureCompressor or any ASTC encoder, goes to the GPU compressed with its mip
+// chain and skips the PNG decode: name.astc.ktx where the GPU has ASTC, otherwise name.ktx with ETC2.
+bool ResourceManager::LoadCompressedTexture(std::string const & textureFilePath, Texture & texture) {
+    std::string basePath = textureFilePath.substr(0, textureFilePath.rfind('.'));
+    bool astc = GLState::GetInstance().CheckExtension("GL_KHR_texture_compression_astc_ldr");
 
-    mTextures[name]->Generate(width, height, textureRaw);
+    std::string const candidates[] = {astc ? basePath + ".astc.ktx" : std::string {}, basePath + ".ktx"};
 
-    Log::info("LOADED TEXTURE %s SUCCESS", textureFilePath.c_str());
+    std::vector<uint8_t> ktxRaw {};
+    for (std::string const & path : candidates) {
+        if (path.empty() || !ReadIfExists(path, ktxRaw))
+            continue;
+
+        KtxImage image {};
+        if (!ParseKtx(std::move(ktxRaw), image)) {
+            Log::error("RESOURCE MANAGER : %s is not a compressed 2D KTX", path.c_str());
+            continue;
+        }
+        if (texture.Generate(image)) {
+            Log::info("LOADED TEXTURE %s SUCCESS, %zu levels of format 0x%04X",
+                      path.c_str(),
+                      image.levels.size(),
+                      image.internalFormat);
+            return true;
+        }
+    }
+    return false;
 }
 
-std::vector<std::string> const & ResourceManager::GetTextureNames() {
-    return mTextureNames;
+
+//Font-specific functions
+std::shared_ptr<FontAtlas> ResourceManager::GetFont(std::string const &fontPath) {
+    auto it = mFonts.find(fontPath);
+    if (it != mFonts.end())
+        return it->second;
+
+    auto ptrFont = std::make_shared<FontAtlas>();
+    ptrFont->Load(fontPath);
+    mFonts.emplace(fontPath, ptrFont);
+    return ptrFont;
 }
 
 
 void ResourceManager::FreeTextures() {
-    mTextureNames.clear();
-    mTextures.clear();
+    mTextures.Clear();
+    mTexturesByName.clear();
 }
 
 void ResourceManager::FreeShaders() {
-    mShaders.clear();
+    mShaders.Clear();
+    mShadersByName.clear();
+}
+
+void ResourceManager::FreeFonts() {
+    mFonts.clear();
 }
 
 void ResourceManager::Free() {
     FreeTextures();
     FreeShaders();
+    FreeFonts();
 }
 
 
@@ -139,6 +314,17 @@ void ResourceManager::Read(std::string path,
     Log::debug("READ SUCCESS %s", path.c_str());
 }
 
+bool ResourceManager::ReadIfExists(std::string const & path, std::vector<uint8_t> & buffer) {
+    AAssetManager* assetManager = Android::GetInstance().GetAndroidApp()->activity->assetManager;
+    AAsset *asset = AAssetManager_open(assetManager, path.c_str(), AASSET_MODE_UNKNOWN);
+    if (asset == nullptr)
+        return false;
+
+    AAsset_close(asset);
+    Read(path, buffer);
+    return true;
+}
+
 void ResourceManager::LoadUiStrings(std::string const &uiFilePath) {
     tinyxml2::XMLDocument sceneXml;
     std::vector<uint8_t> xmlBuffer;
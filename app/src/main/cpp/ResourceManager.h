@@ -7,43 +7,94 @@
 
 #include "Shader.h"
 #include "Texture.h"
+#include "FontAtlas.h"
 #include "Ui.h"
 #include "GameTypes.h"
 #include "Utilities.h"
+#include "Handle.h"
+#include "NameTable.h"
 
-using ShaderMap = std::unordered_map<std::string, Shader>;
-using TextureMap = std::unordered_map<std::string, std::shared_ptr<Texture>>;
+using FontMap = std::unordered_map<std::string, std::shared_ptr<FontAtlas>>;
 using UiStringMap = EnumKeyUnorderedMap<GameState, std::vector<UiString>>;
 
+// GPU bytes of resident textures past which loading one releases the least recently drawn, see SetTextureBudget.
+size_t const TEXTURE_BUDGET_BYTES = 32u << 20;
+
+// What ResourceManager holds, in bytes.
+struct MemoryReport {
+    size_t textureBudgetBytes;
+    size_t textureCount;
+    size_t residentTextureCount;
+    size_t residentTextureBytes;
+    size_t releasedTextureBytes;    // loaded again when drawn
+    size_t fontCount;
+    size_t fontAtlasBytes;          // GPU, one distance field atlas per font
+    size_t fontFileBytes;           // CPU, the font files FreeType reads glyphs from
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// ResourceManager
+// Shaders and textures live in HandlePools. Their names are interned when they load and map to handles through arrays
+// indexed by NameId, so names are looked up while loading (Find*) and code that draws keeps handles: resolving one is
+// an index and a generation check, and a handle outliving its resource resolves to nullptr.
+//---------------------------------------------------------------------------------------------------------------------
 class ResourceManager {
 public:
-    static void LoadShader(std::string const &vsFilePath,
-                           std::string const &fsFilePath,
-                           std::string const &programName);
-    static void LoadTexture(std::string const &textureFilePath,
-                            GLboolean alpha,
-                            std::string const &name);
+    static ShaderHandle LoadShader(std::string const &vsFilePath,
+                                   std::string const &fsFilePath,
+                                   std::string const &programName);
+    static TextureHandle LoadTexture(std::string const &textureFilePath,
+                                     GLboolean alpha,
+                                     std::string const &name);
     static void LoadUiStrings(std::string const & uiFilePath);
     static void FreeTextures();
     static void FreeShaders();
+    static void FreeFonts();
     static void Free();
 
-    static Shader & GetShader(std::string const &name);
-    static std::shared_ptr<Texture> GetTexture(std::string const &name);
-    static std::vector<std::string> const & GetTextureNames();
+    // For loading code, not per frame. Names that aren't loaded are an error and give null handles.
+    static ShaderHandle FindShader(std::string const &name);
+    static TextureHandle FindTexture(std::string const &name);
+    // nullptr for null and stale handles.
+    static Shader * GetShader(ShaderHandle handle) { return mShaders.Get(handle); }
+    static Texture * GetTexture(TextureHandle handle) { return mTextures.Get(handle); }
     static std::vector<UiString> & GetUiStrings(GameState gameState);
+    // Builds the font's distance field atlas on first use; needs a current GL context then.
+    static std::shared_ptr<FontAtlas> GetFont(std::string const & fontPath);
+
+    // Texture residency, main thread. Every texture drawn is stamped with the frame and the GameState that drew it
+    // (UseTexture, called by RenderPacket::PushSprite); a released texture is loaded again right there. Loading past
+    // the budget releases the least recently drawn textures. Releasing needs a GLContextScope.
+    static void SetTextureBudget(size_t bytes);
+    static void BeginFrame(GameState gameState);
+    static void UseTexture(Texture & texture);
+    // Releases the textures the state hasn't drawn; returns the bytes freed, none without a current context.
+    static size_t ReleaseTextures(GameState gameState);
+    static MemoryReport GetMemoryReport();
 
     static void Read(std::string path, std::vector<uint8_t> & pBuffer, size_t sizeBytes = 0);
+    // Like Read, false rather than an exception when there is no such asset.
+    static bool ReadIfExists(std::string const & path, std::vector<uint8_t> & buffer);
 private:
+    static void LoadTextureData(Texture & texture);
+    static bool LoadCompressedTexture(std::string const & textureFilePath, Texture & texture);
+    static void ReleaseOverBudget(Texture const & loaded);
+
     ResourceManager() = delete;
     ResourceManager(ResourceManager const &) = delete;
     ResourceManager &operator=(ResourceManager const &) = delete;
 
 private:
-    static ShaderMap mShaders;
-    static TextureMap mTextures;
+    static NameTable mNames;
+    static HandlePool<Shader> mShaders;
+    static HandlePool<Texture> mTextures;
+    static std::vector<ShaderHandle> mShadersByName;      // by NameId
+    static std::vector<TextureHandle> mTexturesByName;    // by NameId
+    static FontMap mFonts;
     static UiStringMap mUiStrings;
-    static std::vector<std::string> mTextureNames;
+    static size_t mTextureBudget;
+    static uint64_t mFrame;
+    static GameState mFrameState;
 };
 
 
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+//---------------------------------------------------------------------------------------------------------------------
+// RingBuffer
+// Fixed capacity single-producer / single-consumer queue. The producer reserves a slot with BeginPush(), fills it in
+// place and publishes it with CommitPush(); the consumer reads Front() and releases it with PopFront(). No locks and
+// no allocations after construction, so it is safe to use from the render thread.
+//---------------------------------------------------------------------------------------------------------------------
+template <typename T, size_t Capacity>
+class RingBuffer {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "RingBuffer capacity must be a power of two");
+
+public:
+    RingBuffer() : mHead {0}, mTail {0}
+    {}
+    RingBuffer(RingBuffer const &) = delete;
+    RingBuffer & operator=(RingBuffer const &) = delete;
+
+    // Producer side. Returns nullptr if the buffer is full.
+    T * BeginPush() {
+        size_t head = mHead.load(std::memory_order_relaxed);
+        if (head - mTail.load(std::memory_order_acquire) == Capacity)
+            return nullptr;
+        return &mItems[head & (Capacity - 1)];
+    }
+
+    void CommitPush() {
+        mHead.store(mHead.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool Push(T const & item) {
+        T * slot = BeginPush();
+        if (!slot)
+            return false;
+        *slot = item;
+        CommitPush();
+        return true;
+    }
+
+    // Consumer side. Returns nullptr if the buffer is empty.
+    T const * Front() const {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail == mHead.load(std::memory_order_acquire))
+            return nullptr;
+        return &mItems[tail & (Capacity - 1)];
+    }
+
+    void PopFront() {
+        mTail.store(mTail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    size_t Size() const {
+        return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_acquire);
+    }
+
+    bool Empty() const { return Size() == 0; }
+    static constexpr size_t GetCapacity() { return Capacity; }
+
+private:
+    // Head and tail live on separate cache lines so producer and consumer do not false-share.
+    std::array<T, Capacity> mItems;
+    std::atomic<size_t> mHead;
+    char mPadding[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> mTail;
+};
@@ -8,10 +8,33 @@
 #include "EventManager.h"
 #include "Events.h"
 #include "GameTypes.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
+#include "JobSystem.h"
+
+// Actors per job when updating the scene, an actor update is only a few hundred nanoseconds.
+size_t const ACTOR_UPDATE_BATCH = 8;
+
+namespace {
+
+// A score event goes out again once the event manager and its listeners have let go of it, so scoring allocates no
+// event. Simulation thread only, like every event.
+template <typename Event>
+std::shared_ptr<Event> const & RecycleScoreEvent(std::shared_ptr<Event> & ptrEvent, uint64_t score) {
+    if (ptrEvent && ptrEvent.use_count() == 1)
+        ptrEvent->SetScore(score);
+    else
+        ptrEvent = std::make_shared<Event>(score);
+    return ptrEvent;
+}
+
+}
 
 SceneGame::SceneGame() : mPtrBird {nullptr},
                          mPtrPBird {nullptr},
                          mVecBarriers {},
+                         mVecUpdateActors {},
+                         mVecShownBarriers {},
                          mPtrActorFactory {new Actors::ActorFactory},
                          mPtrSpriteRenderer {new SpriteRenderer},
                          mTargetTapDistance {},
@@ -19,6 +42,8 @@ SceneGame::SceneGame() : mPtrBird {nullptr},
                          mCheckInputTap {false},
                          mCurrentScore {},
                          mFinalScore {},
+                         mPtrUpdateScoreEvent {},
+                         mPtrFinalScoreEvent {},
                          mPrevMinDistBirdCol {std::numeric_limits<float>::max()},
                          mBirdState {OwlState::TAP},
                          mRandGenerator {static_cast<uint32_t>(std::chrono::system_clock::now().time_since_epoch().count())}
@@ -51,6 +76,8 @@ SceneGame::SceneGame() : mPtrBird {nullptr},
     int32_t barrierCount = CalculateBarriersCount();
     assert(barrierCount > 0);
     mVecBarriers.resize(static_cast<size_t>(barrierCount));
+    mVecUpdateActors.reserve(mVecBarriers.size() * 2 + 1);
+    mVecShownBarriers.reserve(mVecBarriers.size());
 
     for(auto & barrier : mVecBarriers) {
         barrier.mPtrATopColumn = mPtrActorFactory->CreateActor("xmlSettings/topColumn.xml");
@@ -67,6 +94,14 @@ SceneGame::SceneGame() : mPtrBird {nullptr},
 }
 
 
+void SceneGame::QueueScore() {
+    Events::EventManager::Get().QueueEvent(RecycleScoreEvent(mPtrUpdateScoreEvent, mCurrentScore));
+}
+
+void SceneGame::QueueFinalScore() {
+    Events::EventManager::Get().QueueEvent(RecycleScoreEvent(mPtrFinalScoreEvent, mFinalScore));
+}
+
 void SceneGame::RestartGame() {
     for(auto & barrier : mVecBarriers) {
         barrier.mBarrierState = BarrierState::CALCULATE;
@@ -83,6 +118,7 @@ void SceneGame::RestartGame() {
 
 
 void SceneGame::Update(double deltaSec) {
+    PROFILE_SCOPE("SceneGame::Update");
 
     switch(mBirdState) {
         case OwlState::FALL: {
@@ -108,7 +144,7 @@ void SceneGame::Update(double deltaSec) {
 
             case BarrierState::CALCULATE : {
                 CalculateColumnPos(barrier.mPtrPTopColumn, barrier.mPtrPBottomColumn);
-                Log::debug("Barr pos %f %f", barrier.mPtrPTopColumn->GetPosition().x, barrier.mPtrPTopColumn->GetPosition().y);
+                Log_trace("Barr pos %f %f", barrier.mPtrPTopColumn->GetPosition().x, barrier.mPtrPTopColumn->GetPosition().y);
                 barrier.mBarrierState = BarrierState::WAIT;
                 break;
             }
@@ -120,49 +156,59 @@ void SceneGame::Update(double deltaSec) {
                             new Events::EventChangeGameState(GameState::FINISH)));
                     mFinalScore = mCurrentScore;
                     mCurrentScore = 0;
-                    Events::EventManager::Get().QueueEvent(std::shared_ptr<Events::EventUpdateScore>(
-                            new Events::EventUpdateScore(to_string(mCurrentScore))));
-                    Events::EventManager::Get().QueueEvent(std::shared_ptr<Events::EventFinalScore>(
-                            new Events::EventFinalScore(to_string(mFinalScore))));
+                    QueueScore();
+                    QueueFinalScore();
                 }
 
 
-                barrier.mPtrATopColumn->Update(deltaSec);
-                barrier.mPtrABottomColumn->Update(deltaSec);
-                if (!IsSeen(barrier.mPtrPTopColumn)) barrier.mBarrierState = BarrierState::CALCULATE;
+                mVecUpdateActors.push_back(barrier.mPtrATopColumn.get());
+                mVecUpdateActors.push_back(barrier.mPtrABottomColumn.get());
+                mVecShownBarriers.push_back(&barrier);
                 break;
             }
         }
     }
 
-    mPtrBird->Update(deltaSec);
+    // Actor updates only touch their own components, so they run as jobs. Everything that queues events stays here.
+    mVecUpdateActors.push_back(mPtrBird.get());
+    auto updateActors = [this, deltaSec](size_t begin, size_t end) {
+        for (size_t index = begin; index < end; ++index)
+            mVecUpdateActors[index]->Update(deltaSec);
+    };
+    JobSystem::GetInstance().ParallelFor(mVecUpdateActors.size(), ACTOR_UPDATE_BATCH, updateActors);
+    mVecUpdateActors.clear();
+
+    for(auto ptrBarrier : mVecShownBarriers) {
+        if (!IsSeen(ptrBarrier->mPtrPTopColumn)) ptrBarrier->mBarrierState = BarrierState::CALCULATE;
+    }
+    mVecShownBarriers.clear();
 
     if(CheckBirdOverlapScene()) {
         Events::EventManager::Get().QueueEvent(std::shared_ptr<Events::EventChangeGameState>(
                 new Events::EventChangeGameState(GameState::FINISH)));
         mCurrentScore = 0;
         mFinalScore = mCurrentScore;
-        Events::EventManager::Get().QueueEvent(std::shared_ptr<Events::EventUpdateScore>(
-                new Events::EventUpdateScore(to_string(mCurrentScore))));
-        Events::EventManager::Get().QueueEvent(std::shared_ptr<Events::EventFinalScore>(
-                new Events::EventFinalScore(to_string(mFinalScore))));
+        QueueScore();
+        QueueFinalScore();
     }
 
 
     if(CheckScore()){
-        Events::EventManager::Get().QueueEvent(std::shared_ptr<Events::EventUpdateScore>(
-                new Events::EventUpdateScore(to_string(mCurrentScore))));
+        QueueScore();
     }
 }
 
-void SceneGame::Draw() {
-    mPtrSpriteRenderer->Draw(mPtrBird);
+void SceneGame::Draw(RenderPacket & packet) {
+    PROFILE_SCOPE("SceneGame::Draw");
+    packet.BeginGpuPass(GpuPass::SPRITES, RenderLayer::ACTORS);
+
+    mPtrSpriteRenderer->Draw(packet, RenderLayer::ACTORS, mPtrBird);
 
     for(auto & barrier: mVecBarriers) {
         switch (barrier.mBarrierState) {
             case BarrierState::SHOW : {
-                mPtrSpriteRenderer->Draw(barrier.mPtrATopColumn);
-                mPtrSpriteRenderer->Draw(barrier.mPtrABottomColumn);
+                mPtrSpriteRenderer->Draw(packet, RenderLayer::OBSTACLES, barrier.mPtrATopColumn);
+                mPtrSpriteRenderer->Draw(packet, RenderLayer::OBSTACLES, barrier.mPtrABottomColumn);
                 break;
             }
 
@@ -171,6 +217,7 @@ void SceneGame::Draw() {
         }
     }
 
+    packet.EndGpuPass(GpuPass::SPRITES, RenderLayer::OBSTACLES);
 }
 
 void SceneGame::CalculateTapVelocity(glm::vec2 & velocity) {
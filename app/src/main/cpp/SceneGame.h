@@ -6,7 +6,7 @@
 #include "ActorFactory.h"
 #include "SpriteRenderer.h"
 #include "TextRenderer.h"
-//#include "Events.h"
+#include "Events.h"
 
 class SceneGame {
 
@@ -14,7 +14,7 @@ public:
     SceneGame();
     ~SceneGame() = default;
     void Update(double deltaSec);
-    void Draw();
+    void Draw(RenderPacket & packet);
 
     void InputTap(bool isTapped) { mCheckInputTap = isTapped; }
     void RestartGame();
@@ -30,6 +30,8 @@ private:
     bool IsSeen(std::shared_ptr<Actors::PhysicsComponent> ptrTop);
     bool CheckBirdOverlapScene();
     bool CheckScore();
+    void QueueScore();
+    void QueueFinalScore();
 private:
     enum class OwlState {
         FALL,
@@ -61,6 +63,8 @@ private:
     std::shared_ptr<Actors::Actor> mPtrBird;
     std::shared_ptr<Actors::PhysicsComponent> mPtrPBird;
     std::vector<Barrier> mVecBarriers;
+    std::vector<Actors::Actor*> mVecUpdateActors;
+    std::vector<Barrier*> mVecShownBarriers;
 
     std::unique_ptr<Actors::ActorFactory> mPtrActorFactory;
 
@@ -74,6 +78,8 @@ private:
     float mTargetColumnMinBorderDistance;
     uint64_t mCurrentScore;
     uint64_t mFinalScore;
+    std::shared_ptr<Events::EventUpdateScore> mPtrUpdateScoreEvent;
+    std::shared_ptr<Events::EventFinalScore> mPtrFinalScoreEvent;
     float mPrevMinDistBirdCol;
     OwlState mBirdState;
     std::minstd_rand0 mRandGenerator;
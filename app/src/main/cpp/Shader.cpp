@@ -12,7 +12,7 @@ void Shader::DeleteProgram() {
 }
 
 void Shader::Use() const {
-    glUseProgram(mId);
+    GLState::GetInstance().UseProgram(mId);
 }
 
 GLuint Shader::GetId() const {
@@ -7,11 +7,16 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <GLES3/gl3.h>
 
+#include "Handle.h"
+
 
 class Shader
 {
 public:
-    explicit Shader() = default;
+    explicit Shader() : mId{} {}
+    // The program belongs to one Shader, a copy would delete it too.
+    Shader(Shader const &) = delete;
+    Shader & operator=(Shader const &) = delete;
 
     ~Shader();
 
@@ -38,4 +43,6 @@ public:
 
 private:
     GLuint mId;
-};
\ No newline at end of file
+};
+
+using ShaderHandle = Handle<Shader>;
@@ -0,0 +1,244 @@
+#include <cmath>
+#include <cstring>
+
+#include "SpriteQuad.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SPRITE_QUAD_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SPRITE_QUAD_SSE2 1
+#endif
+
+namespace {
+
+// Unit quad corners in SPRITE_QUAD_VERTICES order.
+float const CORNER_U[SPRITE_QUAD_VERTICES] = {0.f, 1.f, 0.f, 1.f};
+float const CORNER_V[SPRITE_QUAD_VERTICES] = {0.f, 0.f, 1.f, 1.f};
+
+void WriteAttributes(SpriteInstance const & sprite, SpriteVertexAttributes * ptrAttributes) {
+    for (size_t corner = 0; corner < SPRITE_QUAD_VERTICES; ++corner) {
+        SpriteVertexAttributes & attributes = ptrAttributes[corner];
+        attributes.texCoords.x = CORNER_U[corner] ? sprite.uvRect.z : sprite.uvRect.x;
+        attributes.texCoords.y = CORNER_V[corner] ? sprite.uvRect.w : sprite.uvRect.y;
+        std::memcpy(attributes.color, sprite.color, sizeof(sprite.color));
+    }
+}
+
+void WritePositions(SpriteInstance const & sprite, glm::vec2 * ptrPositions) {
+    if (sprite.rotateRadians == 0.f) {
+        for (size_t corner = 0; corner < SPRITE_QUAD_VERTICES; ++corner) {
+            ptrPositions[corner].x = sprite.position.x + CORNER_U[corner] * sprite.size.x;
+            ptrPositions[corner].y = sprite.position.y + CORNER_V[corner] * sprite.size.y;
+        }
+        return;
+    }
+
+    float s = std::sin(sprite.rotateRadians);
+    float c = std::cos(sprite.rotateRadians);
+    glm::vec2 center = sprite.position + 0.5f * sprite.size;
+    for (size_t corner = 0; corner < SPRITE_QUAD_VERTICES; ++corner) {
+        float dx = (CORNER_U[corner] - 0.5f) * sprite.size.x;
+        float dy = (CORNER_V[corner] - 0.5f) * sprite.size.y;
+        ptrPositions[corner].x = center.x + dx * c - dy * s;
+        ptrPositions[corner].y = center.y + dx * s + dy * c;
+    }
+}
+
+#if SPRITE_QUAD_NEON || SPRITE_QUAD_SSE2
+
+// The few vector operations the four sprite kernel needs, one lane per sprite.
+#if SPRITE_QUAD_NEON
+
+using Vec4 = float32x4_t;
+using Int4 = int32x4_t;
+using Mask4 = uint32x4_t;
+
+inline Vec4 Load(float const * ptr) { return vld1q_f32(ptr); }
+inline Vec4 Splat(float value) { return vdupq_n_f32(value); }
+inline Vec4 Add(Vec4 a, Vec4 b) { return vaddq_f32(a, b); }
+inline Vec4 Sub(Vec4 a, Vec4 b) { return vsubq_f32(a, b); }
+inline Vec4 Mul(Vec4 a, Vec4 b) { return vmulq_f32(a, b); }
+inline Vec4 Select(Mask4 mask, Vec4 a, Vec4 b) { return vbslq_f32(mask, a, b); }
+
+inline Vec4 FlipSign(Vec4 value, Mask4 mask) {
+    uint32x4_t sign = vandq_u32(mask, vdupq_n_u32(0x80000000u));
+    return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(value), sign));
+}
+
+inline bool AllZero(Vec4 value) {
+    uint32x4_t nonZero = vmvnq_u32(vceqq_f32(value, vdupq_n_f32(0.f)));
+    uint32x2_t any = vorr_u32(vget_low_u32(nonZero), vget_high_u32(nonZero));
+    return (vget_lane_u32(any, 0) | vget_lane_u32(any, 1)) == 0;
+}
+
+// Nearest integer, halves away from zero.
+inline Int4 RoundToInt(Vec4 value) {
+    Vec4 half = vbslq_f32(vcltq_f32(value, vdupq_n_f32(0.f)), vdupq_n_f32(-0.5f), vdupq_n_f32(0.5f));
+    return vcvtq_s32_f32(vaddq_f32(value, half));
+}
+inline Vec4 ToFloat(Int4 value) { return vcvtq_f32_s32(value); }
+inline Int4 AddInt(Int4 value, int32_t add) { return vaddq_s32(value, vdupq_n_s32(add)); }
+inline Mask4 TestBits(Int4 value, int32_t bits) { return vtstq_s32(value, vdupq_n_s32(bits)); }
+
+inline void Transpose(Vec4 & a, Vec4 & b, Vec4 & c, Vec4 & d) {
+    float32x4x2_t ab = vtrnq_f32(a, b);
+    float32x4x2_t cd = vtrnq_f32(c, d);
+    a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+    b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+    c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+    d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+}
+
+// x0 y0 x1 y1 x2 y2 x3 y3.
+inline void StoreInterleaved(float * ptrOut, Vec4 x, Vec4 y) {
+    float32x4x2_t xy = {{x, y}};
+    vst2q_f32(ptrOut, xy);
+}
+
+#else
+
+using Vec4 = __m128;
+using Int4 = __m128i;
+using Mask4 = __m128;
+
+inline Vec4 Load(float const * ptr) { return _mm_loadu_ps(ptr); }
+inline Vec4 Splat(float value) { return _mm_set1_ps(value); }
+inline Vec4 Add(Vec4 a, Vec4 b) { return _mm_add_ps(a, b); }
+inline Vec4 Sub(Vec4 a, Vec4 b) { return _mm_sub_ps(a, b); }
+inline Vec4 Mul(Vec4 a, Vec4 b) { return _mm_mul_ps(a, b); }
+inline Vec4 Select(Mask4 mask, Vec4 a, Vec4 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+inline Vec4 FlipSign(Vec4 value, Mask4 mask) { return _mm_xor_ps(value, _mm_and_ps(mask, _mm_set1_ps(-0.f))); }
+inline bool AllZero(Vec4 value) { return _mm_movemask_ps(_mm_cmpneq_ps(value, _mm_setzero_ps())) == 0; }
+
+// Nearest integer, halves to even (the default MXCSR rounding).
+inline Int4 RoundToInt(Vec4 value) { return _mm_cvtps_epi32(value); }
+inline Vec4 ToFloat(Int4 value) { return _mm_cvtepi32_ps(value); }
+inline Int4 AddInt(Int4 value, int32_t add) { return _mm_add_epi32(value, _mm_set1_epi32(add)); }
+
+inline Mask4 TestBits(Int4 value, int32_t bits) {
+    __m128i masked = _mm_and_si128(value, _mm_set1_epi32(bits));
+    return _mm_castsi128_ps(_mm_cmpeq_epi32(masked, _mm_set1_epi32(bits)));
+}
+
+inline void Transpose(Vec4 & a, Vec4 & b, Vec4 & c, Vec4 & d) { _MM_TRANSPOSE4_PS(a, b, c, d); }
+
+// x0 y0 x1 y1 x2 y2 x3 y3.
+inline void StoreInterleaved(float * ptrOut, Vec4 x, Vec4 y) {
+    _mm_storeu_ps(ptrOut, _mm_unpacklo_ps(x, y));
+    _mm_storeu_ps(ptrOut + 4, _mm_unpackhi_ps(x, y));
+}
+
+#endif
+
+// sin and cos of four angles: reduced by the nearest multiple of pi/2 (pi/2 split in three parts, so the reduction
+// stays exact for any angle a sprite turns by) to |r| <= pi/4, where Cephes' minimax polynomials are within a couple of
+// ulps. Zero gives exactly 0 and 1, so unrotated sprites next to rotated ones keep their corners.
+void SinCos(Vec4 angle, Vec4 & sines, Vec4 & cosines) {
+    Int4 quadrant = RoundToInt(Mul(angle, Splat(0.636619772f)));
+    Vec4 q = ToFloat(quadrant);
+    Vec4 r = Sub(angle, Mul(q, Splat(1.5703125f)));
+    r = Sub(r, Mul(q, Splat(4.837512969970703125e-4f)));
+    r = Sub(r, Mul(q, Splat(7.54978995489188216e-8f)));
+    Vec4 r2 = Mul(r, r);
+
+    Vec4 sinR = Add(Splat(8.3321608736e-3f), Mul(r2, Splat(-1.9515295891e-4f)));
+    sinR = Add(Splat(-1.6666654611e-1f), Mul(r2, sinR));
+    sinR = Add(r, Mul(Mul(r, r2), sinR));
+
+    Vec4 cosR = Add(Splat(-1.388731625493765e-3f), Mul(r2, Splat(2.443315711809948e-5f)));
+    cosR = Add(Splat(4.166664568298827e-2f), Mul(r2, cosR));
+    cosR = Add(Sub(Splat(1.f), Mul(Splat(0.5f), r2)), Mul(Mul(r2, r2), cosR));
+
+    // Odd quadrants swap sin and cos; quadrants 2 and 3 negate sin, 1 and 2 negate cos.
+    Mask4 odd = TestBits(quadrant, 1);
+    sines = FlipSign(Select(odd, cosR, sinR), TestBits(quadrant, 2));
+    cosines = FlipSign(Select(odd, sinR, cosR), TestBits(AddInt(quadrant, 1), 2));
+}
+
+// Corners of four sprites at once, one sprite per lane: the sprites are transposed into position and size vectors on
+// the way in and the corners back into per sprite order on the way out.
+void WritePositions4(SpriteInstance const * ptrSprites, glm::vec2 * ptrPositions) {
+    // Each load is one sprite's position and size; transposed, each vector holds one of them for all four sprites.
+    Vec4 x = Load(&ptrSprites[0].position.x);
+    Vec4 y = Load(&ptrSprites[1].position.x);
+    Vec4 width = Load(&ptrSprites[2].position.x);
+    Vec4 height = Load(&ptrSprites[3].position.x);
+    Transpose(x, y, width, height);
+
+    float const angles[4] = {ptrSprites[0].rotateRadians,
+                             ptrSprites[1].rotateRadians,
+                             ptrSprites[2].rotateRadians,
+                             ptrSprites[3].rotateRadians};
+    Vec4 angle = Load(angles);
+
+    Vec4 cornerX[SPRITE_QUAD_VERTICES];
+    Vec4 cornerY[SPRITE_QUAD_VERTICES];
+    if (AllZero(angle)) {
+        Vec4 right = Add(x, width);
+        Vec4 bottom = Add(y, height);
+        cornerX[0] = x;     cornerY[0] = y;
+        cornerX[1] = right; cornerY[1] = y;
+        cornerX[2] = x;     cornerY[2] = bottom;
+        cornerX[3] = right; cornerY[3] = bottom;
+    }
+    else {
+        Vec4 sines;
+        Vec4 cosines;
+        SinCos(angle, sines, cosines);
+
+        // Corner offsets from the center are (+-w/2, +-h/2), rotated.
+        Vec4 halfWidth = Mul(width, Splat(0.5f));
+        Vec4 halfHeight = Mul(height, Splat(0.5f));
+        Vec4 centerX = Add(x, halfWidth);
+        Vec4 centerY = Add(y, halfHeight);
+        Vec4 wCos = Mul(halfWidth, cosines);
+        Vec4 wSin = Mul(halfWidth, sines);
+        Vec4 hCos = Mul(halfHeight, cosines);
+        Vec4 hSin = Mul(halfHeight, sines);
+
+        cornerX[0] = Add(Sub(centerX, wCos), hSin); cornerY[0] = Sub(Sub(centerY, wSin), hCos);
+        cornerX[1] = Add(Add(centerX, wCos), hSin); cornerY[1] = Sub(Add(centerY, wSin), hCos);
+        cornerX[2] = Sub(Sub(centerX, wCos), hSin); cornerY[2] = Add(Sub(centerY, wSin), hCos);
+        cornerX[3] = Sub(Add(centerX, wCos), hSin); cornerY[3] = Add(Add(centerY, wSin), hCos);
+    }
+
+    Transpose(cornerX[0], cornerX[1], cornerX[2], cornerX[3]);
+    Transpose(cornerY[0], cornerY[1], cornerY[2], cornerY[3]);
+    for (size_t sprite = 0; sprite < 4; ++sprite)
+        StoreInterleaved(&ptrPositions[sprite * SPRITE_QUAD_VERTICES].x, cornerX[sprite], cornerY[sprite]);
+}
+
+#endif
+
+}
+
+void ExpandSpriteQuads(SpriteInstance const * ptrSprites,
+                       size_t count,
+                       glm::vec2 * ptrPositions,
+                       SpriteVertexAttributes * ptrAttributes)
+{
+    size_t i = 0;
+#if SPRITE_QUAD_NEON || SPRITE_QUAD_SSE2
+    for (; i + 4 <= count; i += 4) {
+        WritePositions4(ptrSprites + i, ptrPositions + i * SPRITE_QUAD_VERTICES);
+        for (size_t sprite = i; sprite < i + 4; ++sprite)
+            WriteAttributes(ptrSprites[sprite], ptrAttributes + sprite * SPRITE_QUAD_VERTICES);
+    }
+#endif
+    for (; i < count; ++i) {
+        WritePositions(ptrSprites[i], ptrPositions + i * SPRITE_QUAD_VERTICES);
+        WriteAttributes(ptrSprites[i], ptrAttributes + i * SPRITE_QUAD_VERTICES);
+    }
+}
+
+char const * SpriteQuadKernelName() {
+#if SPRITE_QUAD_NEON
+    return "NEON";
+#elif SPRITE_QUAD_SSE2
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// Sprite as the renderers consume it: per instance data of the GLES3 path (expanded by sprite_instanced.vs) and the
+// input of ExpandSpriteQuads on GLES2. Position is the top left corner, rotation is around the quad center.
+struct SpriteInstance {
+    glm::vec2   position;
+    glm::vec2   size;
+    glm::vec4   uvRect;
+    float       rotateRadians;
+    uint8_t     color[4];
+};
+static_assert(sizeof(SpriteInstance) == 40, "SpriteInstance layout must match the instance attributes");
+
+// Everything but the position of an expanded quad corner; positions are written to a separate array so the kernel can
+// store them with full width vector writes.
+struct SpriteVertexAttributes {
+    glm::vec2   texCoords;
+    uint8_t     color[4];
+};
+static_assert(sizeof(SpriteVertexAttributes) == 12, "SpriteVertexAttributes layout must match sprite.vs");
+
+// Corners per quad, in the order top left, top right, bottom left, bottom right.
+size_t const SPRITE_QUAD_VERTICES = 4;
+size_t const SPRITE_QUAD_INDICES = 6;
+
+// Writes the four corners of count sprites: SPRITE_QUAD_VERTICES positions and attributes per sprite. The transform
+// is the 2D affine one of SpriteRenderer's old model matrix (scale, rotate around the center, translate) worked out
+// per corner instead of through a mat4. With NEON or SSE2 four sprites go through at once, one per vector lane, sin and
+// cos included; groups of four without rotation skip the trigonometry altogether. Plain C++ takes the remainder and
+// targets without either.
+void ExpandSpriteQuads(SpriteInstance const * ptrSprites,
+                       size_t count,
+                       glm::vec2 * ptrPositions,
+                       SpriteVertexAttributes * ptrAttributes);
+
+// Name of the code path ExpandSpriteQuads was built with.
+char const * SpriteQuadKernelName();
@@ -1,24 +1,44 @@
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <vector>
 
 #include "SpriteRenderer.h"
 #include "GLState.h"
+#include "StreamBuffer.h"
 #include "SpriteRenderer.h"
 #include "ResourceManager.h"
 #include "ActorComponents.h"
 #include "Actor.h"
 
 SpriteRenderer::SpriteRenderer() : mShader{},
+                                   mProgramId{},
                                    mVAO{},
-                                   mVBO{} {
+                                   mVBO{},
+                                   mIBO{},
+                                   mPositionLocation{-1},
+                                   mTexCoordsLocation{-1},
+                                   mTintLocation{-1},
+                                   mInstanced{false},
+                                   mInstancedShader{},
+                                   mInstancedVAO{},
+                                   mInstances{} {
     InitSpriteRenderData();
 }
 
 SpriteRenderer::~SpriteRenderer() {
     glDeleteVertexArrays(1, &mVAO);
     glDeleteBuffers(1, &mVBO);
+    glDeleteBuffers(1, &mIBO);
+
+    if (mInstanced)
+        glDeleteVertexArrays(1, &mInstancedVAO);
 }
 
 void SpriteRenderer::InitSpriteRenderData() {
-    mShader = ResourceManager::GetShader("sprite_shader");
+    mShader = ResourceManager::FindShader("sprite_shader");
+    Shader & shader = *ResourceManager::GetShader(mShader);
+    mProgramId = shader.GetId();
 
     glm::mat4 projection = glm::ortho(0.0f,
                                       static_cast<GLfloat>(GLState::GetInstance().GetScreenWidth()),
@@ -27,9 +47,14 @@ void SpriteRenderer::InitSpriteRenderData() {
                                       -1.0f,
                                       1.0f);
 
-    mShader.Use();
-    mShader.SetInteger("sprite", 0);
-    mShader.SetMatrix4("projection", projection);
+    shader.Use();
+    shader.SetInteger("sprite", 0);
+    shader.SetMatrix4("projection", projection);
+
+    mPositionLocation = glGetAttribLocation(mProgramId, "position");
+    mTexCoordsLocation = glGetAttribLocation(mProgramId, "texCoords");
+    mTintLocation = glGetAttribLocation(mProgramId, "tint");
+    assert(mPositionLocation >= 0 && mTexCoordsLocation >= 0 && mTintLocation >= 0);
 
     GLfloat vertices[] =
             {
@@ -39,65 +64,187 @@ void SpriteRenderer::InitSpriteRenderData() {
                     1.0f, 1.0f,     1.0f, 1.0f
             };
 
-    glGenVertexArrays(1, &mVAO);
     glGenBuffers(1, &mVBO);
-
     glBindBuffer(GL_ARRAY_BUFFER, mVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
+    // Two triangles per quad over the corners written by ExpandSpriteQuads.
+    std::vector<GLushort> indices(SPRITE_INSTANCE_BATCH * SPRITE_QUAD_INDICES);
+    for (size_t quad = 0; quad < SPRITE_INSTANCE_BATCH; ++quad) {
+        GLushort first = static_cast<GLushort>(quad * SPRITE_QUAD_VERTICES);
+        GLushort * ptrQuad = &indices[quad * SPRITE_QUAD_INDICES];
+        ptrQuad[0] = first;
+        ptrQuad[1] = first + 1;
+        ptrQuad[2] = first + 2;
+        ptrQuad[3] = first + 2;
+        ptrQuad[4] = first + 1;
+        ptrQuad[5] = first + 3;
+    }
+
+    glGenVertexArrays(1, &mVAO);
     glBindVertexArray(mVAO);
 
+    glGenBuffers(1, &mIBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+
+    glEnableVertexAttribArray(static_cast<GLuint>(mPositionLocation));
+    glEnableVertexAttribArray(static_cast<GLuint>(mTexCoordsLocation));
+    glEnableVertexAttribArray(static_cast<GLuint>(mTintLocation));
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    mInstances.reserve(SPRITE_INSTANCE_BATCH);
+
+    if (GLState::GetInstance().GetGLESVersion() >= 3)
+        InitInstancedRenderData(projection);
+    GLState::GetInstance().CheckGLError("SpriteRenderer::InitSpriteRenderData");
+}
+
+void SpriteRenderer::InitInstancedRenderData(glm::mat4 const & projection) {
+    mInstancedShader = ResourceManager::FindShader("sprite_instanced_shader");
+    Shader & shader = *ResourceManager::GetShader(mInstancedShader);
+    shader.Use();
+    shader.SetInteger("sprite", 0);
+    shader.SetMatrix4("projection", projection);
+
+    glGenVertexArrays(1, &mInstancedVAO);
+    glBindVertexArray(mInstancedVAO);
+
+    // Corners come from the unit quad in mVBO, the rest advances once per instance and is pointed
+    // at the stream buffer by each draw.
+    glBindBuffer(GL_ARRAY_BUFFER, mVBO);
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), reinterpret_cast<GLvoid*>(0));
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), reinterpret_cast<GLvoid*>(0));
+
+    for (GLuint attribute = 1; attribute <= 4; ++attribute) {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
+
+    mInstanced = true;
+    mProgramId = shader.GetId();
+    GLState::GetInstance().CheckGLError("SpriteRenderer::InitInstancedRenderData");
 }
 
-void SpriteRenderer::DrawSprite(std::shared_ptr<Texture> const texture,
-                                glm::vec2 const & position,
-                                glm::vec2 const & size,
-                                GLfloat rotate_degrees,
-                                glm::vec3 const & color)
-{
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    mShader.Use();
-    glm::mat4 model;
-
-    model = glm::translate(model, glm::vec3(position, 0.0f));
-    // First translate (transformations are: scale happens first, then rotation and then finall translation happens; reversed order)
-    model = glm::translate(model, glm::vec3(0.5f * size.x, 0.5f * size.y, 0.0f));
-    // Move origin of rotation to center of quad
-    model = glm::rotate(model, glm::radians(rotate_degrees), glm::vec3(0.0f, 0.0f, 1.0f));
-    // Then degrees
-    model = glm::translate(model, glm::vec3(-0.5f * size.x, -0.5f * size.y, 0.0f));
-    // Move origin back
-    model = glm::scale(model, glm::vec3(size, 1.0f));
-    // Last scale
-
-    mShader.SetMatrix4("model", model);
-    mShader.SetVector3f("spriteColor", color);
-
-    texture->Bind();
-    glActiveTexture(GL_TEXTURE0);
+void SpriteRenderer::DrawSprites(Texture const & texture, RenderCommand const * ptrCommands, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        RenderCommand const & command = ptrCommands[i];
+        SpriteInstance instance;
+        instance.position = command.position;
+        instance.size = command.size;
+        instance.uvRect = command.uvRect;
+        instance.rotateRadians = glm::radians(command.rotateDegrees);
+        glm::vec3 color = glm::clamp(command.color, 0.f, 1.f) * 255.f + 0.5f;
+        instance.color[0] = static_cast<uint8_t>(color.r);
+        instance.color[1] = static_cast<uint8_t>(color.g);
+        instance.color[2] = static_cast<uint8_t>(color.b);
+        instance.color[3] = 255;
+        mInstances.push_back(instance);
 
-    glBindVertexArray(mVAO);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
+        if (mInstances.size() == SPRITE_INSTANCE_BATCH)
+            Flush(texture);
+    }
+
+    if (!mInstances.empty())
+        Flush(texture);
+}
+
+void SpriteRenderer::Flush(Texture const & texture) {
+    if (mInstanced)
+        DrawInstances(texture);
+    else
+        DrawQuads(texture);
+}
+
+void SpriteRenderer::DrawInstances(Texture const & texture) {
+    GLState & glState = GLState::GetInstance();
+    glState.SetBlend(true);
+    glState.SetCullFace(false);
+    glState.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    ResourceManager::GetShader(mInstancedShader)->Use();
+    glState.ActiveTexture(GL_TEXTURE0);
+    texture.Bind();
 
-    glDisable(GL_BLEND);
+    size_t bytes = mInstances.size() * sizeof(SpriteInstance);
+    GLintptr offset {};
+    StreamBuffer & streamBuffer = StreamBuffer::GetInstance();
+    void * ptrMapped = streamBuffer.Map(bytes, offset);
+    if (!ptrMapped) {
+        mInstances.clear();
+        return;
+    }
+    std::memcpy(ptrMapped, mInstances.data(), bytes);
+    streamBuffer.Unmap();
+
+    glState.BindVertexArray(mInstancedVAO);
+    glState.BindArrayBuffer(streamBuffer.GetBuffer());
+    GLsizei const stride = sizeof(SpriteInstance);
+    auto member = [offset](size_t memberOffset) { return reinterpret_cast<GLvoid*>(offset + memberOffset); };
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, member(offsetof(SpriteInstance, position)));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, member(offsetof(SpriteInstance, uvRect)));
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, stride, member(offsetof(SpriteInstance, rotateRadians)));
+    glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, member(offsetof(SpriteInstance, color)));
+
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(mInstances.size()));
+    glState.CountDrawCall();
+
+    mInstances.clear();
+}
 
-    EGLint errorCode = eglGetError();
-    if(errorCode != EGL_SUCCESS) {
-        Log::info("DRAW %x", errorCode);
-        assert(errorCode == EGL_SUCCESS);
+void SpriteRenderer::DrawQuads(Texture const & texture) {
+    GLState & glState = GLState::GetInstance();
+    glState.SetBlend(true);
+    glState.SetCullFace(false);
+    glState.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    ResourceManager::GetShader(mShader)->Use();
+    glState.ActiveTexture(GL_TEXTURE0);
+    texture.Bind();
+
+    // Positions of all corners first, then their texture coordinates and tint, expanded straight into the mapping.
+    size_t vertexCount = mInstances.size() * SPRITE_QUAD_VERTICES;
+    size_t positionBytes = vertexCount * sizeof(glm::vec2);
+    size_t bytes = positionBytes + vertexCount * sizeof(SpriteVertexAttributes);
+    GLintptr offset {};
+    StreamBuffer & streamBuffer = StreamBuffer::GetInstance();
+    auto ptrMapped = static_cast<uint8_t*>(streamBuffer.Map(bytes, offset));
+    if (!ptrMapped) {
+        mInstances.clear();
+        return;
     }
+    ExpandSpriteQuads(mInstances.data(),
+                      mInstances.size(),
+                      reinterpret_cast<glm::vec2*>(ptrMapped),
+                      reinterpret_cast<SpriteVertexAttributes*>(ptrMapped + positionBytes));
+    streamBuffer.Unmap();
+
+    glState.BindVertexArray(mVAO);
+    glState.BindArrayBuffer(streamBuffer.GetBuffer());
+    GLsizei const stride = sizeof(SpriteVertexAttributes);
+    auto at = [offset](size_t bytesIn) { return reinterpret_cast<GLvoid*>(offset + bytesIn); };
+    glVertexAttribPointer(mPositionLocation, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), at(0));
+    glVertexAttribPointer(mTexCoordsLocation, 2, GL_FLOAT, GL_FALSE, stride,
+                          at(positionBytes + offsetof(SpriteVertexAttributes, texCoords)));
+    glVertexAttribPointer(mTintLocation, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                          at(positionBytes + offsetof(SpriteVertexAttributes, color)));
 
+    glDrawElements(GL_TRIANGLES,
+                   static_cast<GLsizei>(mInstances.size() * SPRITE_QUAD_INDICES),
+                   GL_UNSIGNED_SHORT,
+                   reinterpret_cast<GLvoid*>(0));
+    glState.CountDrawCall();
+
+    mInstances.clear();
 }
 
-void SpriteRenderer::Draw(std::shared_ptr<Actors::Actor> ptrActor) {
+void SpriteRenderer::Draw(RenderPacket & packet, RenderLayer layer, std::shared_ptr<Actors::Actor> const & ptrActor) {
     auto ptrWeakPhysicsComponent = ptrActor->GetComponent<Actors::PhysicsComponent>("PhysicsComponent");
     auto ptrStrongPhysicsComponent = Actors::MakeStrongPtr(ptrWeakPhysicsComponent);
 
@@ -107,8 +254,15 @@ void SpriteRenderer::Draw(std::shared_ptr<Actors::Actor> ptrActor) {
     std::weak_ptr<Actors::RenderComponent> ptrTimed = ptrActor->GetComponent<Actors::RenderComponent>("RenderComponent");
     std::shared_ptr<Actors::RenderComponent> ptrStrongTimed = Actors::MakeStrongPtr(ptrTimed);
 
-    DrawSprite(
-        ptrStrongRenderComponent ? ptrStrongRenderComponent->GetCurrentFrameTexture() : ptrStrongTimed->GetTexture(),
+    TextureHandle texture = ptrStrongRenderComponent ? ptrStrongRenderComponent->GetCurrentFrameTexture() : ptrStrongTimed->GetTexture();
+    Texture * ptrTexture = ResourceManager::GetTexture(texture);
+    if (!ptrTexture)
+        return;
+
+    packet.PushSprite(
+        layer,
+        *this,
+        *ptrTexture,
         ptrStrongPhysicsComponent->GetPosition(),
         ptrStrongPhysicsComponent->GetSize(),
         ptrStrongPhysicsComponent->GetRotation(),
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -8,6 +10,11 @@
 #include "Shader.h"
 #include "Texture.h"
 #include "Actor.h"
+#include "RenderPacket.h"
+#include "SpriteQuad.h"
+
+// Sprites per draw call: 40 KB of stream buffer per instanced batch, 80 KB of expanded quads on GLES2.
+size_t const SPRITE_INSTANCE_BATCH = 1024;
 
 class SpriteRenderer
 {
@@ -17,19 +24,36 @@ public:
     SpriteRenderer & operator=(SpriteRenderer const &) = delete;
     ~SpriteRenderer();
 
-    void Draw(std::shared_ptr<Actors::Actor> ptrActor);
-    void DrawSprite(std::shared_ptr<Texture> texture,
-                    glm::vec2 const & position,
-                    glm::vec2 const & size,
-                    GLfloat rotate_degrees,
-                    glm::vec3 const & color);
+    // Records the actor's current frame into packet; the render thread draws it with DrawSprites.
+    void Draw(RenderPacket & packet, RenderLayer layer, std::shared_ptr<Actors::Actor> const & ptrActor);
+
+    // Draws count SPRITE commands that all use texture, one draw call per SPRITE_INSTANCE_BATCH. GLES3 expands the
+    // quads in sprite_instanced.vs, GLES2 expands them on the CPU with ExpandSpriteQuads.
+    void DrawSprites(Texture const & texture, RenderCommand const * ptrCommands, size_t count);
+
+    bool IsInstanced() const { return mInstanced; }
+    GLuint GetProgramId() const { return mProgramId; }
 
 private:
-    Shader mShader;
+    ShaderHandle mShader;
+    GLuint mProgramId;              // of the shader DrawSprites uses, for sort keys
     GLuint mVAO;
-    GLuint mVBO;
+    GLuint mVBO;                    // unit quad, corners of the instanced path
+    GLuint mIBO;                    // quad indices of the CPU expanded path
+    GLint mPositionLocation;
+    GLint mTexCoordsLocation;
+    GLint mTintLocation;
+
+    bool mInstanced;
+    ShaderHandle mInstancedShader;
+    GLuint mInstancedVAO;
+    std::vector<SpriteInstance> mInstances;
 
 private:
     void InitSpriteRenderData();
+    void InitInstancedRenderData(glm::mat4 const & projection);
+    void Flush(Texture const & texture);
+    void DrawInstances(Texture const & texture);
+    void DrawQuads(Texture const & texture);
 };
 
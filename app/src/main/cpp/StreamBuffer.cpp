@@ -0,0 +1,165 @@
+#include <cassert>
+
+#include "StreamBuffer.h"
+#include "GLState.h"
+#include "Profiler.h"
+#include "Log.h"
+
+size_t const STREAM_BUFFER_BYTES = STREAM_BUFFER_FRAMES * STREAM_BUFFER_FRAME_BYTES;
+GLuint64 const STREAM_BUFFER_FENCE_TIMEOUT_NS = 100000000;
+
+StreamBuffer::StreamBuffer() : mBuffer {},
+                               mUseMapping {false},
+                               mOrphanNextFrame {false},
+                               mFences {},
+                               mFrame {},
+                               mHead {},
+                               mRegionEnd {STREAM_BUFFER_FRAME_BYTES},
+                               mStaging {},
+                               mMappedBytes {},
+                               mMappedOffset {},
+                               mFrameBytes {},
+                               mFenceWaits {}
+{}
+
+bool StreamBuffer::Init() {
+    if (mBuffer)
+        return true;
+
+    mUseMapping = GLState::GetInstance().GetGLESVersion() >= 3;
+
+    glGenBuffers(1, &mBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, mBuffer);
+    glBufferData(GL_ARRAY_BUFFER, STREAM_BUFFER_BYTES, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    mFences.fill(nullptr);
+    mFrame = 0;
+    mHead = 0;
+    mRegionEnd = STREAM_BUFFER_FRAME_BYTES;
+    mOrphanNextFrame = false;
+
+    Log::info("StreamBuffer: %zu KB, %s", STREAM_BUFFER_BYTES / 1024, mUseMapping ? "mapped ranges" : "orphaning");
+    GLState::GetInstance().CheckGLError("StreamBuffer::Init");
+    return true;
+}
+
+void StreamBuffer::Release() {
+    if (!mBuffer)
+        return;
+
+    for (auto & fence : mFences) {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+    glDeleteBuffers(1, &mBuffer);
+    mBuffer = 0;
+}
+
+void StreamBuffer::Orphan() {
+    GLState::GetInstance().BindArrayBuffer(mBuffer);
+    glBufferData(GL_ARRAY_BUFFER, STREAM_BUFFER_BYTES, nullptr, GL_STREAM_DRAW);
+
+    // Fresh storage, nothing left for the GPU to read.
+    for (auto & fence : mFences) {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
+void StreamBuffer::BeginFrame() {
+    if (!mBuffer)
+        return;
+
+    mFrameBytes = 0;
+    mFrame = (mFrame + 1) % STREAM_BUFFER_FRAMES;
+
+    if (mOrphanNextFrame) {
+        // Last frame overflowed into the other regions; start over on new storage.
+        Orphan();
+        mOrphanNextFrame = false;
+    }
+    else if (!mUseMapping && mFrame == 0) {
+        Orphan();
+    }
+
+    GLsync & fence = mFences[mFrame];
+    if (fence) {
+        PROFILE_SCOPE("StreamBuffer::WaitFence");
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED) {
+            ++mFenceWaits;
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, STREAM_BUFFER_FENCE_TIMEOUT_NS);
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    mHead = mFrame * STREAM_BUFFER_FRAME_BYTES;
+    mRegionEnd = mHead + STREAM_BUFFER_FRAME_BYTES;
+}
+
+void StreamBuffer::EndFrame() {
+    if (!mBuffer || !mUseMapping)
+        return;
+
+    assert(!mFences[mFrame]);
+    mFences[mFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void * StreamBuffer::Map(size_t bytes, GLintptr & offset) {
+    assert(mBuffer && mMappedBytes == 0 && bytes > 0);
+    if (bytes > STREAM_BUFFER_BYTES) {
+        Log::error("StreamBuffer: can't map %zu KB, the buffer has %zu KB", bytes / 1024, STREAM_BUFFER_BYTES / 1024);
+        return nullptr;
+    }
+
+    mHead = (mHead + STREAM_BUFFER_ALIGNMENT - 1) & ~(STREAM_BUFFER_ALIGNMENT - 1);
+    if (mHead + bytes > mRegionEnd) {
+        // The frame wrote more than its region: move it to fresh storage and let it use the whole buffer.
+        Log_warn("StreamBuffer: frame region of %zu KB overflowed", STREAM_BUFFER_FRAME_BYTES / 1024);
+        Orphan();
+        mHead = 0;
+        mRegionEnd = STREAM_BUFFER_BYTES;
+        mOrphanNextFrame = true;
+    }
+
+    mMappedOffset = static_cast<GLintptr>(mHead);
+    offset = mMappedOffset;
+
+    GLState::GetInstance().BindArrayBuffer(mBuffer);
+    if (mUseMapping) {
+        void * ptrMapped = glMapBufferRange(GL_ARRAY_BUFFER,
+                                            mMappedOffset,
+                                            static_cast<GLsizeiptr>(bytes),
+                                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (!ptrMapped) {
+            Log::error("StreamBuffer: mapping %zu bytes failed, GL error %x", bytes, glGetError());
+            return nullptr;
+        }
+        mMappedBytes = bytes;
+        return ptrMapped;
+    }
+
+    if (mStaging.size() < bytes)
+        mStaging.resize(bytes);
+    mMappedBytes = bytes;
+    return mStaging.data();
+}
+
+void StreamBuffer::Unmap() {
+    assert(mMappedBytes > 0);
+
+    GLState::GetInstance().BindArrayBuffer(mBuffer);
+    if (mUseMapping)
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    else
+        glBufferSubData(GL_ARRAY_BUFFER, mMappedOffset, static_cast<GLsizeiptr>(mMappedBytes), mStaging.data());
+
+    mHead += mMappedBytes;
+    mFrameBytes += static_cast<uint32_t>(mMappedBytes);
+    GLState::GetInstance().CountStreamedBytes(static_cast<uint32_t>(mMappedBytes));
+    mMappedBytes = 0;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <GLES3/gl3.h>
+
+size_t const STREAM_BUFFER_FRAMES = 3;                  // regions in the ring, one per frame the GPU may lag behind
+size_t const STREAM_BUFFER_FRAME_BYTES = 256 * 1024;
+size_t const STREAM_BUFFER_ALIGNMENT = 16;
+
+//---------------------------------------------------------------------------------------------------------------------
+// StreamBuffer
+// One dynamic vertex buffer shared by the 2D renderers for data rewritten every frame. The buffer is a ring of
+// STREAM_BUFFER_FRAMES regions and each frame only writes into its own region, so a write never touches memory the GPU
+// may still read. On GLES3 ranges are mapped unsynchronized and a fence per region guards its reuse. On GLES2 the data
+// goes up with glBufferSubData and the whole buffer is orphaned each time the ring wraps. Render thread only.
+//---------------------------------------------------------------------------------------------------------------------
+class StreamBuffer {
+public:
+    static StreamBuffer & GetInstance() {
+        static StreamBuffer instance;
+        return instance;
+    }
+
+private:
+    StreamBuffer();
+    StreamBuffer(StreamBuffer const &) = delete;
+    StreamBuffer & operator=(StreamBuffer const &) = delete;
+
+public:
+    ~StreamBuffer() = default;
+
+    bool Init();
+    void Release();
+
+    void BeginFrame();
+    void EndFrame();
+
+    // Returns where to write bytes of vertex data, offset receives its position in GetBuffer(). Every Map() must be
+    // followed by Unmap() before anything is drawn from it. Leaves the buffer bound to GL_ARRAY_BUFFER. Returns
+    // nullptr, with nothing to unmap, for more bytes than the whole buffer and when mapping fails (GL_OUT_OF_MEMORY, a
+    // lost context); the caller then skips its draw.
+    void * Map(size_t bytes, GLintptr & offset);
+    void Unmap();
+
+    GLuint GetBuffer() const { return mBuffer; }
+    bool IsInitialized() const { return mBuffer != 0; }
+
+    uint32_t GetFrameBytes() const { return mFrameBytes; }
+    uint32_t GetFenceWaits() const { return mFenceWaits; }
+
+private:
+    void Orphan();
+
+private:
+    GLuint mBuffer;
+    bool mUseMapping;
+    bool mOrphanNextFrame;
+
+    std::array<GLsync, STREAM_BUFFER_FRAMES> mFences;
+    size_t mFrame;
+    size_t mHead;
+    size_t mRegionEnd;
+
+    std::vector<uint8_t> mStaging;
+    size_t mMappedBytes;
+    GLintptr mMappedOffset;
+
+    uint32_t mFrameBytes;
+    uint32_t mFenceWaits;
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Utf8.h"
+
+// Pen and bounding box after every code point of a laid out string, kept so that a new text only lays out what follows
+// the prefix it shares with the previous one.
+struct TextLayout {
+    std::vector<uint32_t>   codePoints;
+    glm::vec2               topLeft;
+    int32_t                 charToCharDistPixels;
+    std::vector<glm::vec2>  positions;
+    std::vector<float>      penX;       // pen after each character
+    std::vector<glm::vec4>  bboxes;     // xMin, yMin, xMax, yMax of the characters up to and including each one
+};
+
+// Lays out UTF-8 text into layout, starting at topLeft. When topLeft and the spacing are those of the text layout
+// holds, the characters of the common prefix are kept and only the rest is laid out again. Glyphs is a FontAtlas or
+// anything else with its GetGlyph and GetKerning; scale takes their metrics to pixels. Returns the ink's bounding box,
+// xMin, yMin, xMax, yMax, or all zero for a text without ink.
+template <typename Glyphs>
+glm::vec4 LayoutText(std::string const & text,
+                     glm::vec2 const & topLeft,
+                     int32_t charToCharDistPixels,
+                     float scale,
+                     Glyphs & glyphs,
+                     TextLayout & layout)
+{
+    bool sameOrigin = layout.topLeft == topLeft && layout.charToCharDistPixels == charToCharDistPixels;
+    layout.topLeft = topLeft;
+    layout.charToCharDistPixels = charToCharDistPixels;
+
+    // Decoded over the old code points, which are compared on the way.
+    size_t count {};
+    size_t reused {};
+    char const * ptrText = text.data();
+    char const * ptrEnd = ptrText + text.size();
+    while (ptrText != ptrEnd) {
+        uint32_t code = DecodeUtf8(ptrText, ptrEnd);
+        if (count < layout.codePoints.size()) {
+            if (sameOrigin && reused == count && layout.codePoints[count] == code)
+                ++reused;
+            layout.codePoints[count] = code;
+        }
+        else {
+            layout.codePoints.push_back(code);
+        }
+        ++count;
+    }
+    layout.codePoints.resize(count);
+
+    layout.positions.resize(reused);
+    layout.penX.resize(reused);
+    layout.bboxes.resize(reused);
+
+    float posX = reused ? layout.penX.back() : topLeft.x;   /* start at topLeft param */
+    float posY = topLeft.y;
+
+    glm::vec4 bbox;         /* xMin, yMin, xMax, yMax */
+    glm::vec4 glyph_bbox;
+
+    /* initialize string bbox to "empty" values */
+    if (reused) {
+        bbox = layout.bboxes.back();
+    }
+    else {
+        bbox.x = bbox.y = std::numeric_limits<float>::max();
+        bbox.z = bbox.w = std::numeric_limits<float>::lowest();
+    }
+
+    // Kerning pairs the previous glyph with the current one, the prefix's last glyph included.
+    uint32_t prevIndex {};
+    if (reused) {
+        auto const * ptrPrev = glyphs.GetGlyph(layout.codePoints[reused - 1]);
+        prevIndex = ptrPrev ? ptrPrev->index : 0;
+    }
+
+    for (size_t i = reused; i < count; ++i) {
+        auto const * ptrGlyph = glyphs.GetGlyph(layout.codePoints[i]);
+        if (!ptrGlyph) {
+            assert(false);
+            ptrGlyph = glyphs.GetGlyph(' ');
+        }
+        glm::vec2 size = ptrGlyph->size * scale;
+        glm::vec2 bearing = ptrGlyph->bearing * scale;
+
+        if (prevIndex && ptrGlyph->index)
+            posX += glyphs.GetKerning(prevIndex, ptrGlyph->index) * scale;
+        prevIndex = ptrGlyph->index;
+
+        /* store current pen position */
+        if(size.y - bearing.y <= 0.f)
+            posY = topLeft.y - size.y;
+        else
+            posY = topLeft.y - bearing.y;
+        layout.positions.push_back({posX, posY});
+        /* increment pen position */
+
+        posX += charToCharDistPixels;
+        posX += size.x;
+        /* for each glyph image, compute its bounding box, */
+        /* translate it, and grow the string bbox          */
+        glyph_bbox = {bearing.x, bearing.y - size.y, bearing.x + size.x, bearing.y};
+
+        glyph_bbox.x += layout.positions.back().x;
+        glyph_bbox.z += layout.positions.back().x;
+        glyph_bbox.y += layout.positions.back().y;
+        glyph_bbox.w += layout.positions.back().y;
+
+        bbox.x = std::min(bbox.x, glyph_bbox.x);
+        bbox.y = std::min(bbox.y, glyph_bbox.y);
+        bbox.z = std::max(bbox.z, glyph_bbox.z);
+        bbox.w = std::max(bbox.w, glyph_bbox.w);
+
+        layout.penX.push_back(posX);
+        layout.bboxes.push_back(bbox);
+    }
+
+    /* check that we really grew the string bbox */
+    if ( bbox.x > bbox.z ) {
+        bbox = {};
+    }
+    return bbox;
+}
@@ -1,285 +1,302 @@
 #include <glm/gtc/matrix_transform.hpp>
-#include <freetype/ftrender.h>
+#include <cstddef>
+#include <cstring>
+#include <limits>
 
+#include "FontAtlas.h"
 #include "GLState.h"
 #include "ResourceManager.h"
 #include "TextRenderer.h"
+#include "RenderPacket.h"
+#include "StreamBuffer.h"
+#include "Utf8.h"
+#include "Profiler.h"
 #include "Log.h"
 
 
-void TextRenderer::Init(std::string const & font, GLuint fontSize)
+void TextRenderer::Init(std::string const & font, size_t fontSize)
 {
-    mShader = ResourceManager::GetShader("text_shader");
-    mShader.Use();
+    mShader = ResourceManager::FindShader("text_shader");
+    Shader & shader = *ResourceManager::GetShader(mShader);
+    shader.Use();
+    mProgramId = shader.GetId();
 
     glm::mat4 projection = glm::ortho(0.0f,
                                       static_cast<GLfloat>(GLState::GetInstance().GetScreenWidth()),
                                       static_cast<GLfloat>(GLState::GetInstance().GetScreenHeight()),
                                       0.0f);
 
-    mShader.SetInteger("text", 0);
-    mShader.SetMatrix4("projection", projection);
+    shader.SetInteger("text", 0);
+    shader.SetMatrix4("projection", projection);
 
-    glGenVertexArrays(1, &mVAO);
-    glGenBuffers(1, &mVBO);
+    mVertexLocation = glGetAttribLocation(mProgramId, "vertex");
+    mColorLocation = glGetAttribLocation(mProgramId, "color");
 
+    // Vertices of single strings live in the StreamBuffer, Draw points the attributes at each string's range.
+    glGenVertexArrays(1, &mVAO);
     glBindVertexArray(mVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, mVBO);
-
-    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), 0);
+    glEnableVertexAttribArray(static_cast<GLuint>(mVertexLocation));
+    glEnableVertexAttribArray(static_cast<GLuint>(mColorLocation));
+    glBindVertexArray(0);
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // The batch has its own buffer, so its attributes are set once here.
+    mPtrBatch.reset();
+    mBatchEvictions = 0;
+    mBatchVertices = 0;
+    glGenBuffers(1, &mBatchVBO);
+    glGenVertexArrays(1, &mBatchVAO);
+    glBindVertexArray(mBatchVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, mBatchVBO);
+    glEnableVertexAttribArray(static_cast<GLuint>(mVertexLocation));
+    glEnableVertexAttribArray(static_cast<GLuint>(mColorLocation));
+    SetAttributes(0);
     glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    mCharactersMap.clear();
+    // Every size and state of the font shares one distance field atlas.
+    mPtrFont = ResourceManager::GetFont(font);
+    mScale = static_cast<float>(fontSize) / SDF_GLYPH_PIXEL_SIZE;
+    CalcDigits();
+}
 
-    if (FT_Init_FreeType(&mPtrFTLib)) {
-        Log::error("ERROR::FREETYPE: Could not init FreeType Library");
-        assert(false);
+void TextRenderer::CalcDigits() {
+    for (size_t digit = 0; digit < 10; ++digit) {
+        FTCharacter const * ptrGlyph = mPtrFont->GetGlyph(static_cast<uint32_t>('0' + digit));
+        if (!ptrGlyph) {
+            assert(false);
+            ptrGlyph = mPtrFont->GetGlyph(' ');
+        }
+        glm::vec2 size = ptrGlyph->size * mScale;
+        glm::vec2 bearing = ptrGlyph->bearing * mScale;
+
+        DigitMetrics & metrics = mDigits[digit];
+        metrics.index = ptrGlyph->index;
+        metrics.offsetY = size.y - bearing.y <= 0.f ? -size.y : -bearing.y;
+        metrics.advance = size.x;
+        metrics.ink = {bearing.x, bearing.y - size.y, bearing.x + size.x, bearing.y};
+        metrics.ink.y += metrics.offsetY;
+        metrics.ink.w += metrics.offsetY;
     }
 
-    std::vector<uint8_t> fontBuffer;
-    ResourceManager::Read(font, fontBuffer, 0);
-
-    if (FT_New_Memory_Face(mPtrFTLib, fontBuffer.data(), fontBuffer.size(), 0, &mPtrFTFace)){
-        Log::error("ERROR::FREETYPE: Failed to load font");
-        assert(false);
+    for (size_t left = 0; left < 10; ++left) {
+        for (size_t right = 0; right < 10; ++right) {
+            uint32_t leftIndex = mDigits[left].index;
+            uint32_t rightIndex = mDigits[right].index;
+            mDigitKerning[left][right] = leftIndex && rightIndex
+                                         ? mPtrFont->GetKerning(leftIndex, rightIndex) * mScale
+                                         : 0.f;
+        }
     }
+}
 
-    FT_Set_Pixel_Sizes(mPtrFTFace, 0, fontSize);
-
-    FT_Bool       use_kerning {};
-    FT_UInt       prevGlyphIndex {};
-    FT_Error      error {};
+void TextRenderer::SetDrawState(GLuint vao) {
+    GLState & glState = GLState::GetInstance();
+    glState.SetCullFace(true);
+    glState.SetBlend(true);
+    glState.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    FTCharacter ftChar {};
+    Shader & shader = *ResourceManager::GetShader(mShader);
+    shader.Use();
+    glState.ActiveTexture(GL_TEXTURE0);
+    glState.BindTexture2D(mPtrFont->GetTexture());
+    glState.BindVertexArray(vao);
 
-    use_kerning = FT_HAS_KERNING( mPtrFTFace );
-    // Disable byte-alignment restriction
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    // Half a screen pixel of antialiasing either side of the edge, in distance field units.
+    shader.SetFloat("smoothing", 0.5f / (2.f * SDF_SPREAD * mScale));
+}
 
-    for (uint8_t c = 0; c < 128; c++) {
-        /* convert character code to glyph index */
-        ftChar.index = FT_Get_Char_Index( mPtrFTFace, c );
+void TextRenderer::SetAttributes(GLintptr offset) {
+    auto at = [offset](size_t member) { return reinterpret_cast<GLvoid*>(offset + static_cast<GLintptr>(member)); };
+    glVertexAttribPointer(static_cast<GLuint>(mVertexLocation), 4, GL_FLOAT, GL_FALSE, sizeof(TextVertex), at(0));
+    glVertexAttribPointer(static_cast<GLuint>(mColorLocation),
+                          4,
+                          GL_UNSIGNED_BYTE,
+                          GL_TRUE,
+                          sizeof(TextVertex),
+                          at(offsetof(TextVertex, color)));
+}
 
-        /* retrieve kerning distance and move pen position */
-        if ( use_kerning && prevGlyphIndex && ftChar.index ) {
-            FT_Get_Kerning( mPtrFTFace,
-                            prevGlyphIndex,
-                            ftChar.index,
-                            FT_KERNING_DEFAULT,
-                            &ftChar.delta );
-        }
+size_t TextRenderer::WriteQuads(FTString const & ftString, TextVertex * ptrVertices) {
+    FontAtlas & font = *mPtrFont;
+    float const padding = SDF_SPREAD * mScale;
+    glm::vec3 const color = glm::clamp(ftString.color, 0.f, 1.f) * 255.f + 0.5f;
+    uint8_t const r = static_cast<uint8_t>(color.r);
+    uint8_t const g = static_cast<uint8_t>(color.g);
+    uint8_t const b = static_cast<uint8_t>(color.b);
 
-        /* load glyph image into the slot without rendering */
-        error = FT_Load_Glyph( mPtrFTFace, ftChar.index, FT_LOAD_DEFAULT );
-        if(error){
-            Log::error("ERROR::FREETYPE: Failed to load glyph");
-            assert(false);
-        }
-        int32_t belowBaselineY = mPtrFTFace->glyph->metrics.height - mPtrFTFace->glyph->metrics.horiBearingY;
-        ftChar.belowBaseline = belowBaselineY;
-        ftChar.bearingY = mPtrFTFace->glyph->metrics.horiBearingY;
-        /* extract glyph image and store it in our table */
-        error = FT_Get_Glyph( mPtrFTFace->glyph, &ftChar.glyph );
-        if(error){
-            Log::error("ERROR::FREETYPE: Failed to get glyph");
-            assert(false);
+    size_t vertices {};
+    size_t idx {};
+    char const * ptrText = ftString.text.data();
+    char const * ptrEnd = ptrText + ftString.text.size();
+    while (ptrText != ptrEnd) {
+        AtlasGlyph const * ptrGlyph = font.AcquireGlyph(DecodeUtf8(ptrText, ptrEnd));
+        if(!ptrGlyph) {
+            ++idx;
+            continue;
         }
+        glm::vec4 const & uv = ptrGlyph->uvRect;
 
-        /* record current glyph index */
-        prevGlyphIndex = ftChar.index;
-
-        FT_Glyph   image;
-        image = ftChar.glyph;
-
-        error = FT_Glyph_To_Bitmap( &image,
-                                    FT_RENDER_MODE_NORMAL,
-                                    nullptr,
-                                    false );
-        if(error){
-            Log::error("ERROR::FREETYPE: Failed to convert glyph to bitmap");
-            assert(false);
-        }
+        GLfloat posX = ftString.topLeft.x + ftString.positions[idx].x - padding;
+        GLfloat posY = ftString.topLeft.y + ftString.positions[idx].y - padding;
 
-        FT_BitmapGlyph bitmapGlyph = reinterpret_cast<FT_BitmapGlyph>(image);
-
-        glGenTextures(1, &ftChar.mId);
-        glBindTexture(GL_TEXTURE_2D, ftChar.mId);
-        glTexImage2D(
-                GL_TEXTURE_2D,
-                0,
-                GL_RED,
-                bitmapGlyph->bitmap.width,
-                bitmapGlyph->bitmap.rows,
-                0,
-                GL_RED,
-                GL_UNSIGNED_BYTE,
-                bitmapGlyph->bitmap.buffer
-        );
-
-
-        EGLint errorCode = eglGetError();
-        if(errorCode != EGL_SUCCESS) {
-            Log::info("ERROR::FREETYPE: Failed to load texture %x", errorCode);
-            assert(errorCode == EGL_SUCCESS);
-        }
+        GLfloat w = ptrGlyph->size.x * mScale + 2.f * padding;
+        GLfloat h = ptrGlyph->size.y * mScale + 2.f * padding;
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        TextVertex const quad[6] = {
+                {{ posX,     posY + h }, { uv.x, uv.w }, { r, g, b, 255 }},
+                {{ posX + w, posY     }, { uv.z, uv.y }, { r, g, b, 255 }},
+                {{ posX,     posY     }, { uv.x, uv.y }, { r, g, b, 255 }},
 
-        ftChar.size.x = bitmapGlyph->bitmap.width;
-        ftChar.size.y = bitmapGlyph->bitmap.rows;
+                {{ posX,     posY + h }, { uv.x, uv.w }, { r, g, b, 255 }},
+                {{ posX + w, posY + h }, { uv.z, uv.w }, { r, g, b, 255 }},
+                {{ posX + w, posY     }, { uv.z, uv.y }, { r, g, b, 255 }}
+        };
+        std::memcpy(ptrVertices + vertices, quad, sizeof(quad));
+        vertices += 6;
 
-        mCharactersMap.insert(std::make_pair(c, ftChar));
+        ++idx;
     }
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-
+    return vertices;
 }
 
 void TextRenderer::Draw(FTString const &ftString) {
-    glEnable(GL_CULL_FACE);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if (ftString.text.empty())
+        return;
 
-    mShader.Use();
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(mVAO);
+    SetDrawState(mVAO);
 
-    mShader.SetVector3f("textColor", ftString.color);
+    // All glyphs of the string come from the atlas, so the string goes up in one range and out in one draw call. Every
+    // code point takes at least a byte, which bounds the quads.
+    GLintptr offset {};
+    StreamBuffer & streamBuffer = StreamBuffer::GetInstance();
+    size_t bytes = ftString.text.size() * 6 * sizeof(TextVertex);
+    auto ptrVertices = static_cast<TextVertex *>(streamBuffer.Map(bytes, offset));
+    if (!ptrVertices)
+        return;
 
-    size_t idx {};
-    for( auto c : ftString.text) {
-        auto ftChar = mCharactersMap[c];
+    mPtrFont->BeginString();
+    size_t vertices = WriteQuads(ftString, ptrVertices);
+    streamBuffer.Unmap();
 
-        GLfloat posX = ftString.topLeft.x + ftString.positions[idx].x;
-        GLfloat posY = ftString.topLeft.y + ftString.positions[idx].y;
+    if (vertices == 0)
+        return;
 
-        GLfloat w = ftChar.size.x;
-        GLfloat h = ftChar.size.y;
+    GLState & glState = GLState::GetInstance();
+    glState.BindArrayBuffer(streamBuffer.GetBuffer());
+    SetAttributes(offset);
 
-        GLfloat vertices[6][4] = {
-                { posX,     posY + h,   0.f, 1.f },
-                { posX + w, posY,       1.f, 0.f },
-                { posX,     posY,       0.f, 0.f },
-
-                { posX,     posY + h,   0.f, 1.f },
-                { posX + w, posY + h,   1.f, 1.f },
-                { posX + w, posY,       1.f, 0.f }
-        };
-        glBindTexture(GL_TEXTURE_2D, ftChar.mId);
-
-        glBindBuffer(GL_ARRAY_BUFFER, mVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); // Be sure to use glBufferSubData and not glBufferData
-
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices));
+    glState.CountDrawCall();
+}
 
-        ++idx;
+void TextRenderer::DrawBatch(TextBatchPtr const & ptrBatch) {
+    if (!ptrBatch)
+        return;
+
+    SetDrawState(mBatchVAO);
+
+    FontAtlas & font = *mPtrFont;
+    if (ptrBatch != mPtrBatch || font.GetEvictions() != mBatchEvictions) {
+        PROFILE_SCOPE("TextRenderer::BuildBatch");
+        size_t bytes {};
+        for (FTString const & ftString : *ptrBatch)
+            bytes += ftString.text.size();
+        mBatchStaging.resize(bytes * 6);
+
+        // One string as far as the atlas goes: none of the batch's glyphs may take another's cell.
+        font.BeginString();
+        size_t vertices {};
+        for (FTString const & ftString : *ptrBatch)
+            vertices += WriteQuads(ftString, mBatchStaging.data() + vertices);
+
+        GLState::GetInstance().BindArrayBuffer(mBatchVBO);
+        glBufferData(GL_ARRAY_BUFFER,
+                     static_cast<GLsizeiptr>(vertices * sizeof(TextVertex)),
+                     mBatchStaging.data(),
+                     GL_DYNAMIC_DRAW);
+
+        mPtrBatch = ptrBatch;
+        mBatchEvictions = font.GetEvictions();
+        mBatchVertices = static_cast<GLsizei>(vertices);
     }
 
+    if (mBatchVertices == 0)
+        return;
 
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glDisable(GL_CULL_FACE);
-
+    glDrawArrays(GL_TRIANGLES, 0, mBatchVertices);
+    GLState::GetInstance().CountDrawCall();
 }
 
 TextRenderer::~TextRenderer() {
-    FT_Done_Face(mPtrFTFace);
-    FT_Done_FreeType(mPtrFTLib);
-
-    glDeleteBuffers(1, &mVBO);
     glDeleteVertexArrays(1, &mVAO);
-
-    for (auto c = mCharactersMap.begin(); c != mCharactersMap.end(); c++) {
-        glDeleteTextures(1, &((*c).second.mId));
-        FT_Done_Glyph(c->second.glyph);
-    }
+    glDeleteVertexArrays(1, &mBatchVAO);
+    glDeleteBuffers(1, &mBatchVBO);
 }
 
 void TextRenderer::CalcUiString(UiString const &uiString, FTString & ftString) {
     assert(uiString.text.size() > 0);
 
+    TextLayout & layout = mLayouts[uiString.name];
+    glm::vec4 bbox = LayoutText(uiString.text,
+                                uiString.topLeft,
+                                uiString.charToCharDistPixels,
+                                mScale,
+                                *mPtrFont,
+                                layout);
+
     ftString.text = uiString.text;
     ftString.color = uiString.color;
-    ftString.positions.reserve(uiString.text.size());
-
-    int32_t posX {};
-    int32_t posY {};
-
-    posX = static_cast<int32_t>(uiString.topLeft.x);   /* start at topLeft param */
-    posY = static_cast<int32_t>(uiString.topLeft.y);
-
-    FT_BBox  bbox;
-    FT_BBox  glyph_bbox;
-
-    /* initialize string bbox to "empty" values */
-    bbox.xMin = bbox.yMin =  std::numeric_limits<signed long>::max();
-    bbox.xMax = bbox.yMax =  std::numeric_limits<signed long>::min();
-
-    for (auto c : uiString.text) {
-        auto itFTChar = mCharactersMap.find(c);
-        if(itFTChar == mCharactersMap.end()) {
-            Log::error("ERROR::FREETYPE: Failed to find FTChar in map");
-            assert(false);
-        }
-        FTCharacter FTChar = itFTChar->second;
+    ftString.positions = layout.positions;
+    Align(uiString, bbox, ftString);
+}
 
-        posX += (FTChar.delta.x >> 6);
+void TextRenderer::CalcNumber(UiString const &uiString, FTString & ftString) {
+    std::string const & text = uiString.text;
+    assert(text.size() > 0);
+    for (char c : text) {
+        if (c < '0' || c > '9')
+            return CalcUiString(uiString, ftString);
+    }
 
-        /* store current pen position */
-        if(FTChar.belowBaseline <= 0)
-            posY = uiString.topLeft.y - FTChar.size.y;
-        else
-            posY = uiString.topLeft.y - (FTChar.bearingY >> 6);
-//        if(FTChar.metrics.height - FTChar.metrics.horiBearingY > 0)
-        ftString.positions.push_back({posX, posY});
-        /* increment pen position */
+    ftString.text.assign(text);
+    ftString.color = uiString.color;
+    ftString.positions.resize(text.size());
+
+    float posX = uiString.topLeft.x;
+    glm::vec4 bbox {std::numeric_limits<float>::max(),
+                    std::numeric_limits<float>::max(),
+                    std::numeric_limits<float>::lowest(),
+                    std::numeric_limits<float>::lowest()};
+
+    size_t prev {};
+    for (size_t i = 0; i < text.size(); ++i) {
+        auto digit = static_cast<size_t>(text[i] - '0');
+        if (i)
+            posX += mDigitKerning[prev][digit];
+        prev = digit;
+
+        DigitMetrics const & metrics = mDigits[digit];
+        glm::vec2 position {posX, uiString.topLeft.y + metrics.offsetY};
+        ftString.positions[i] = position;
+
+        bbox.x = std::min(bbox.x, metrics.ink.x + posX);
+        bbox.y = std::min(bbox.y, metrics.ink.y + uiString.topLeft.y);
+        bbox.z = std::max(bbox.z, metrics.ink.z + posX);
+        bbox.w = std::max(bbox.w, metrics.ink.w + uiString.topLeft.y);
 
         posX += uiString.charToCharDistPixels;
-        posX += FTChar.size.x;
-        /* for each glyph image, compute its bounding box, */
-        /* translate it, and grow the string bbox          */
-        FT_Glyph_Get_CBox( FTChar.glyph,
-                           ft_glyph_bbox_pixels,
-                           &glyph_bbox );
-
-        glyph_bbox.xMin += ftString.positions.back().x;
-        glyph_bbox.xMax += ftString.positions.back().x;
-        glyph_bbox.yMin += ftString.positions.back().y;
-        glyph_bbox.yMax += ftString.positions.back().y;
-
-        if ( glyph_bbox.xMin < bbox.xMin )
-            bbox.xMin = glyph_bbox.xMin;
-
-        if ( glyph_bbox.yMin < bbox.yMin )
-            bbox.yMin = glyph_bbox.yMin;
-
-        if ( glyph_bbox.xMax > bbox.xMax )
-            bbox.xMax = glyph_bbox.xMax;
-
-        if ( glyph_bbox.yMax > bbox.yMax )
-            bbox.yMax = glyph_bbox.yMax;
+        posX += metrics.advance;
     }
 
-    /* check that we really grew the string bbox */
-    if ( bbox.xMin > bbox.xMax ) {
-        bbox.xMin = 0;
-        bbox.yMin = 0;
-        bbox.xMax = 0;
-        bbox.yMax = 0;
-    }
+    if (bbox.x > bbox.z)
+        bbox = {};
+    Align(uiString, bbox, ftString);
+}
 
-    /* compute string dimensions in integer pixels */
-    ftString.size.x = bbox.xMax - bbox.xMin;
-    ftString.size.y = bbox.yMax - bbox.yMin;
+void TextRenderer::Align(UiString const &uiString, glm::vec4 const & bbox, FTString & ftString) {
+    /* compute string dimensions in pixels */
+    ftString.size.x = bbox.z - bbox.x;
+    ftString.size.y = bbox.w - bbox.y;
 
     int32_t targetWidth = static_cast<int32_t>(uiString.bottomRight.x - uiString.topLeft.x);
     int32_t targetHeight = static_cast<int32_t>(uiString.bottomRight.y - uiString.topLeft.y);
@@ -301,10 +318,8 @@ void TextRenderer::CalcUiString(UiString const &uiString, FTString & ftString) {
             break;
         }
     }
-
 }
 
-
-void FTString::Draw(std::shared_ptr<TextRenderer> const &textRenderer) const {
-    textRenderer->Draw(*this);
+void FTString::Draw(RenderPacket & packet, RenderLayer layer, std::shared_ptr<TextRenderer> const &textRenderer) const {
+    packet.PushText(layer, *textRenderer, *this);
 }
@@ -3,6 +3,8 @@
 #include <unordered_map>
 #include <vector>
 #include <list>
+#include <memory>
+#include <string>
 
 #include <glm/glm.hpp>
 #include <ft2build.h>
@@ -11,20 +13,51 @@
 
 #include "Shader.h"
 #include "GameTypes.h"
+#include "TextLayout.h"
 
 
 class TextRenderer;
+class RenderPacket;
+class FontAtlas;
+enum class RenderLayer : uint8_t;
 
 struct FTString {
     std::string             text;
     glm::vec2               size;
     glm::vec2               topLeft;
     glm::vec3               color;
-    std::vector<glm::vec2>  positions;
+    std::vector<glm::vec2>  positions;  // one per code point of the UTF-8 text
     GameState               state;
-    void Draw(std::shared_ptr<TextRenderer> const & textRenderer) const;
+    // Records the string into packet, TextRenderer::Draw issues it on the render thread.
+    void Draw(RenderPacket & packet, RenderLayer layer, std::shared_ptr<TextRenderer> const & textRenderer) const;
 };
 
+// Laid out strings drawn together. Never changed once shared: a change makes a new batch, so packets can hand the same
+// one to the render thread frame after frame.
+using TextBatch = std::vector<FTString>;
+using TextBatchPtr = std::shared_ptr<TextBatch const>;
+
+// Vertex of a glyph quad.
+struct TextVertex {
+    GLfloat     position[2];
+    GLfloat     texCoords[2];
+    uint8_t     color[4];
+};
+
+// A digit at a renderer's size, the part of LayoutText that doesn't depend on the text.
+struct DigitMetrics {
+    uint32_t    index;      // FTCharacter::index, for kerning
+    float       offsetY;    // from the string's top to the glyph's
+    float       advance;    // pen advance before the spacing
+    glm::vec4   ink;        // xMin, yMin, xMax, yMax from the glyph's position
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// TextRenderer
+// Lays out and draws UTF-8 strings of one font at one size. Glyphs come from the font's shared FontAtlas and are drawn
+// as distance fields scaled to the size, so renderers are cheap and any number of them bind the same texture and
+// program.
+//---------------------------------------------------------------------------------------------------------------------
 class TextRenderer {
 public:
     TextRenderer() = default;
@@ -33,18 +66,51 @@ public:
     TextRenderer &operator=(TextRenderer const &) = default;
 
     void Init(std::string const & fontPath, size_t fontSize);
+    // Layouts are cached per UiString name, see LayoutText: only the characters after the common prefix of the name's
+    // old and new text are laid out again. Main thread only.
     void CalcUiString(UiString const &uiString, FTString & ftString);
+    // Same layout for a text of ASCII digits, from metrics and kerning worked out in Init: no decoding, no glyph or
+    // layout cache lookups, and no allocation once ftString has the capacity for the text. Any other text goes to
+    // CalcUiString. Main thread only.
+    void CalcNumber(UiString const &uiString, FTString & ftString);
 
     void Draw(FTString const &ftString);
+    // Draws the batch from a vertex buffer kept on the GPU. Its vertices are only built again when a different batch
+    // comes in or the atlas has evicted glyphs since, so an unchanged batch is a single draw and nothing else.
+    void DrawBatch(TextBatchPtr const & ptrBatch);
+
+    GLuint GetProgramId() const { return mProgramId; }
 
 private:
-    std::unordered_map<uint8_t, FTCharacter> mCharactersMap;
+    // Places the laid out string by the UiString's alignment, bbox is its ink.
+    void Align(UiString const &uiString, glm::vec4 const & bbox, FTString & ftString);
+    void CalcDigits();
+
+    void SetDrawState(GLuint vao);
+    void SetAttributes(GLintptr offset);
+    // Quads of the string's glyphs, up to 6 vertices per byte of its text; returns the vertices written.
+    size_t WriteQuads(FTString const & ftString, TextVertex * ptrVertices);
 
-    Shader mShader;
+private:
+    std::shared_ptr<FontAtlas> mPtrFont;
+    float mScale;           // font size over SDF_GLYPH_PIXEL_SIZE
+    std::unordered_map<std::string, TextLayout> mLayouts;
+    DigitMetrics mDigits[10];
+    float mDigitKerning[10][10];    // pixels, left digit by right digit
+
+    ShaderHandle mShader;
+    GLuint mProgramId;      // mShader's, for sort keys
+    GLint mVertexLocation;
+    GLint mColorLocation;
     GLuint mVAO;
-    GLuint mVBO;
-    FT_Face mPtrFTFace;
-    FT_Library mPtrFTLib;
+
+    // The retained batch, render thread only.
+    TextBatchPtr mPtrBatch;
+    uint32_t mBatchEvictions;
+    std::vector<TextVertex> mBatchStaging;
+    GLuint mBatchVBO;
+    GLuint mBatchVAO;
+    GLsizei mBatchVertices;
 };
 
 
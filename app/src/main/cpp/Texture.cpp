@@ -2,16 +2,38 @@
 #include <stdexcept>
 #include <SOIL2.h>
 #include <vector>
+#include <algorithm>
 
 #include "Texture.h"
+#include "Etc2.h"
+#include "GLState.h"
+#include "Log.h"
+
+namespace {
+
+// Bytes of a full mip chain over its base level.
+size_t WithMipmaps(size_t bytes) {
+    return bytes + bytes / 3;
+}
+
+}
 
 Texture::Texture()
-        : mInternalFormat(GL_RGB),
+        : mId(0),
+          mInternalFormat(GL_RGB),
           mImageFormat(GL_RGB),
           mWrapS(GL_REPEAT),
           mWrapT(GL_REPEAT),
           mFilterMin(GL_LINEAR),
-          mFilterMax(GL_LINEAR)
+          mFilterMax(GL_LINEAR),
+          mWidth(0.f),
+          mHeight(0.f),
+          mAspectRatio(0.f),
+          mSizeBytes(0),
+          mSourcePath(),
+          mSourceAlpha(GL_FALSE),
+          mLastUse(0),
+          mUseStates(0)
 {}
 
 Texture::~Texture() {
@@ -34,12 +56,160 @@ void Texture::Generate(GLint width,
                                             textureRaw.size(),
                                             SOIL_LOAD_AUTO,
                                             SOIL_CREATE_NEW_ID,
-                                            SOIL_FLAG_MIPMAPS | SOIL_FLAG_COMPRESS_TO_DXT);
+                                            SOIL_FLAG_MIPMAPS);
+
+    size_t bytesPerPixel = mImageFormat == GL_RGBA ? 4 : 3;
+    mSizeBytes = WithMipmaps(static_cast<size_t>(width) * static_cast<size_t>(height) * bytesPerPixel);
 
 }
 
-void Texture::Bind() const noexcept {
+void Texture::Generate(GLint width,
+                       GLint height,
+                       GLenum format,
+                       uint8_t const * pixels)
+{
+    if(width <= 0 || height <= 0) {
+        throw std::logic_error("Parameters must be positive");
+    }
+
+    mWidth = width;
+    mHeight = height;
+    mAspectRatio = static_cast<GLfloat>(width)/height;
+    mInternalFormat = format;
+    mImageFormat = format;
+    mSizeBytes = static_cast<size_t>(width) * static_cast<size_t>(height) * (format == GL_RGBA ? 4 : 3);
+
+    glGenTextures(1, &mId);
     glBindTexture(GL_TEXTURE_2D, mId);
+    glTexImage2D(GL_TEXTURE_2D, 0, mInternalFormat, width, height, 0, mImageFormat, GL_UNSIGNED_BYTE, pixels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+bool Texture::Generate(KtxImage const & image) {
+    GLState & glState = GLState::GetInstance();
+    bool gles3 = glState.GetGLESVersion() >= 3;
+    bool native = (IsEtc2(image.internalFormat) && gles3) ||
+                  (IsAstc(image.internalFormat) && glState.CheckExtension("GL_KHR_texture_compression_astc_ldr"));
+    if (!native && !IsEtc2(image.internalFormat)) {
+        Log::error("Texture: compressed format 0x%04X not supported", image.internalFormat);
+        return false;
+    }
+
+    mWidth = image.width;
+    mHeight = image.height;
+    mAspectRatio = static_cast<GLfloat>(image.width) / image.height;
+    mInternalFormat = native ? image.internalFormat : GL_RGBA;
+    mImageFormat = native ? image.baseFormat : GL_RGBA;
+
+    // GLES2 only mipmaps power of two sizes with the full chain down to 1x1, it has no GL_TEXTURE_MAX_LEVEL to stop
+    // a short one. Other textures keep level 0 there.
+    bool powerOfTwo = (image.width & (image.width - 1)) == 0 && (image.height & (image.height - 1)) == 0;
+    size_t fullChain = 1;
+    for (int32_t size = std::max(image.width, image.height); size > 1; size >>= 1)
+        ++fullChain;
+    size_t levels = gles3 || (powerOfTwo && image.levels.size() >= fullChain) ? image.levels.size() : 1;
+
+    glGenTextures(1, &mId);
+    glBindTexture(GL_TEXTURE_2D, mId);
+    std::vector<uint8_t> pixels;
+    mSizeBytes = 0;
+    for (size_t level = 0; level < levels; ++level) {
+        KtxLevel const & ktxLevel = image.levels[level];
+        mSizeBytes += native ? ktxLevel.size : static_cast<size_t>(ktxLevel.width) * ktxLevel.height * 4;
+        uint8_t const * ptrData = image.data.data() + ktxLevel.offset;
+        if (native) {
+            glCompressedTexImage2D(GL_TEXTURE_2D,
+                                   static_cast<GLint>(level),
+                                   image.internalFormat,
+                                   ktxLevel.width,
+                                   ktxLevel.height,
+                                   0,
+                                   static_cast<GLsizei>(ktxLevel.size),
+                                   ptrData);
+        }
+        else {
+            if (!DecodeEtc2(image.internalFormat, ptrData, ktxLevel.size, ktxLevel.width, ktxLevel.height, pixels)) {
+                Log::error("Texture: ETC2 level %zu could not be decoded", level);
+                glBindTexture(GL_TEXTURE_2D, 0);
+                glDeleteTextures(1, &mId);
+                mId = 0;
+                mSizeBytes = 0;
+                return false;
+            }
+            glTexImage2D(GL_TEXTURE_2D,
+                         static_cast<GLint>(level),
+                         GL_RGBA,
+                         ktxLevel.width,
+                         ktxLevel.height,
+                         0,
+                         GL_RGBA,
+                         GL_UNSIGNED_BYTE,
+                         pixels.data());
+        }
+    }
+
+    // The chain is the file's, which may stop short of 1x1.
+    bool mipmaps = levels > 1;
+    if (gles3)
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels) - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glState.CheckGLError("Texture::Generate");
+    return true;
+}
+
+void Texture::Bind() const noexcept {
+    GLState::GetInstance().BindTexture2D(mId);
+}
+
+void Texture::SetSource(std::string const & path, GLboolean alpha) {
+    mSourcePath = path;
+    mSourceAlpha = alpha;
+}
+
+std::string const & Texture::GetSourcePath() const noexcept {
+    return mSourcePath;
+}
+
+GLboolean Texture::GetSourceAlpha() const noexcept {
+    return mSourceAlpha;
+}
+
+bool Texture::IsResident() const noexcept {
+    return mId != 0;
+}
+
+size_t Texture::GetSizeBytes() const noexcept {
+    return mSizeBytes;
+}
+
+bool Texture::Release() noexcept {
+    if (!GLState::GetInstance().IsCurrent())
+        return false;
+    glDeleteTextures(1, &mId);
+    mId = 0;
+    return true;
+}
+
+void Texture::MarkUsed(uint64_t frame, uint32_t stateBit) noexcept {
+    mLastUse = frame;
+    mUseStates |= stateBit;
+}
+
+uint64_t Texture::GetLastUse() const noexcept {
+    return mLastUse;
+}
+
+uint32_t Texture::GetUseStates() const noexcept {
+    return mUseStates;
 }
 
 void Texture::SetInternalFormat(GLuint internalFormat) noexcept {
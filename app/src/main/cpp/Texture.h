@@ -1,9 +1,15 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <string>
 #include <vector>
 
 #include <GLES3/gl3.h>
 
+#include "Handle.h"
+#include "Ktx.h"
+
 class Texture
 {
 public:
@@ -25,8 +31,33 @@ public:
     void Generate(GLint width,
                   GLint height,
                   std::vector<uint8_t> const & textureRaw);
+    // Uploads uncompressed pixels as is, for textures built at runtime.
+    void Generate(GLint width,
+                  GLint height,
+                  GLenum format,
+                  uint8_t const * pixels);
+    // Uploads the compressed levels as they are when the GPU samples the format. ETC2 without GLES3 is decoded to RGBA8
+    // on the CPU instead; false for anything else the GPU can't take.
+    bool Generate(KtxImage const & image);
     void Bind() const noexcept ;
 
+    // Residency, main thread. A released texture keeps its size and where it loads from, so ResourceManager can load
+    // it again the next time it is drawn.
+    void SetSource(std::string const & path, GLboolean alpha);
+    std::string const & GetSourcePath() const noexcept;
+    GLboolean GetSourceAlpha() const noexcept;
+    bool IsResident() const noexcept;
+    // GPU bytes while resident, mip levels included.
+    size_t GetSizeBytes() const noexcept;
+    // False, and still resident, when no context is current to delete it with.
+    bool Release() noexcept;
+
+    // Usage stamps, see ResourceManager::UseTexture: the last frame the texture was drawn and a bit per GameState
+    // that drew it.
+    void MarkUsed(uint64_t frame, uint32_t stateBit) noexcept;
+    uint64_t GetLastUse() const noexcept;
+    uint32_t GetUseStates() const noexcept;
+
 private:
     GLuint mId;
     GLuint mInternalFormat;
@@ -38,4 +69,12 @@ private:
     float mWidth;
     float mHeight;
     float mAspectRatio;
+    size_t mSizeBytes;
+
+    std::string mSourcePath;
+    GLboolean mSourceAlpha;
+    uint64_t mLastUse;
+    uint32_t mUseStates;
 };
+
+using TextureHandle = Handle<Texture>;
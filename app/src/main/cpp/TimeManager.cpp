@@ -1,57 +1,86 @@
 
+#include <cstdio>
+
 #include "TimeManager.h"
 #include "Log.h"
 #include "EventManager.h"
+#include "Profiler.h"
+#include "IdleScheduler.h"
 
 double const TARGET_FRAME_RATE = 60.0;
 double const TARGET_FRAME_TIME = 1.0 / TARGET_FRAME_RATE;
 
-double const GIGA = 1.0e9;
 double const NANO = 1.0e-9;
 
-TimeManager::TimeManager() :  mElapsed {},
-                              mLastGetTime {},
-                              mTimer{},
-                              mFrameTime{TARGET_FRAME_TIME},
-                              mNowTime{},
-                              mSleepTime{},
-                              mFPS{} {
-    mLastGetTime = GetTimeNow();
-    mTimer = GetTimeNow();
-}
+// Kept free before the predicted vsync on top of the measured frame work.
+uint64_t const PACING_SAFETY_MARGIN_NS = 2000000;
 
-void TimeManager::UpdateMainLoop() {
-    mTimer += TARGET_FRAME_TIME;
+double const JANK_THRESHOLD = 1.5;      // in refresh periods
 
-    mNowTime = GetTimeNow();
-    mFrameTime = mNowTime - mLastGetTime;
-    mLastGetTime = mNowTime;
-
-    mFPS = 1.f / mFrameTime;
-    mSleepTime = mTimer - mNowTime;
+char const * FramePhaseToStr(FramePhase phase) {
+    switch (phase) {
+        case FramePhase::FRAME:  return "frame";
+        case FramePhase::UPDATE: return "update";
+        case FramePhase::DRAW:   return "draw";
+        default:                 return "unknown";
+    }
+}
 
-    mElapsed += mFrameTime;
+TimeManager::TimeManager() :  mJankFrames {},
+                              mTotalFrames {},
+                              mFrameStartNs {},
+                              mWorkStartNs {},
+                              mWorkTimeNs {},
+                              mElapsed {},
+                              mFrameTime {TARGET_FRAME_TIME},
+                              mRawFrameTime {TARGET_FRAME_TIME},
+                              mIdleBudget {},
+                              mFPS {} {
+}
 
-    if (mSleepTime > 0.f) {
-        double sleepTime = GetTimeNow();
-        Events::EventManager::Get().Update(static_cast<float>(mSleepTime), true);
-        sleepTime = mSleepTime - GetTimeNow() - sleepTime;
+void TimeManager::UpdateMainLoop() {
+    PROFILE_SCOPE("TimeManager::UpdateMainLoop");
+    uint64_t nowNs = GetTimeNowNs();
+    mFramePacer.OnFrameStart(nowNs);
+
+    uint64_t intervalNs = mFrameStartNs ? nowNs - mFrameStartNs : mFramePacer.GetRefreshPeriodNs();
+    if (mFrameStartNs) {
+        RecordPhase(FramePhase::FRAME, intervalNs);
+        if (intervalNs > JANK_THRESHOLD * mFramePacer.GetRefreshPeriodNs())
+            ++mJankFrames;
+        ++mTotalFrames;
+    }
+    mFrameStartNs = nowNs;
 
-        mSleepTS.tv_sec = static_cast<int32_t>(sleepTime);
+    mRawFrameTime = intervalNs * NANO;
+    // Scheduling noise of a frame that still made its vsync must not show up as uneven motion.
+    mFrameTime = mFramePacer.QuantizeInterval(intervalNs) * NANO;
+    mFPS = 1.0 / mRawFrameTime;
+    mElapsed += mFrameTime;
 
-        if(mSleepTS.tv_sec != 0) {
-            mSleepTS.tv_nsec = static_cast<int32_t>(
-                    sleepTime - static_cast<int32_t>(sleepTime * GIGA) );
-        }
-        else {
-            mSleepTS.tv_nsec = static_cast<int32_t>(sleepTime * GIGA);
-        }
+    int64_t budgetNs = static_cast<int64_t>(mFramePacer.PredictNextVsyncNs(nowNs) - nowNs) -
+                       static_cast<int64_t>(mWorkTimeNs + PACING_SAFETY_MARGIN_NS);
+    mIdleBudget = budgetNs > 0 ? budgetNs * NANO : 0.0;
 
-        nanosleep(&mSleepTS, nullptr);
+    if (mIdleBudget > 0.0) {
+        // Events first, background tasks get whatever the queue leaves.
+        Events::EventManager::Get().Update(static_cast<float>(mIdleBudget), true);
+        IdleScheduler::GetInstance().Run(nowNs + static_cast<uint64_t>(budgetNs));
     }
     else {
-        Events::EventManager::Get().Update(0.02f, false);
+        Events::EventManager::Get().Update(0.f, false);
     }
+
+    mWorkStartNs = GetTimeNowNs();
+}
+
+void TimeManager::MarkFrameSubmitted() noexcept {
+    if (mWorkStartNs == 0)
+        return;
+
+    // Grows at once on a slow frame and shrinks slowly, so one fast frame doesn't open the budget up again.
+    uint64_t workNs = GetTimeNowNs() - mWorkStartNs;
+    mWorkTimeNs = workNs > mWorkTimeNs ? workNs : (mWorkTimeNs * 15 + workNs) / 16;
 }
 
 double TimeManager::GetTimeNow() const noexcept {
@@ -61,16 +90,27 @@ double TimeManager::GetTimeNow() const noexcept {
     return timeVal.tv_sec + timeVal.tv_nsec * NANO;
 }
 
+uint64_t TimeManager::GetTimeNowNs() noexcept {
+    timespec timeVal;
+    clock_gettime(CLOCK_MONOTONIC, &timeVal);
+
+    return static_cast<uint64_t>(timeVal.tv_sec) * 1000000000ull + static_cast<uint64_t>(timeVal.tv_nsec);
+}
+
 void TimeManager::Reset() noexcept {
     mFrameTime = 0.f;
-    mLastGetTime = GetTimeNow();
-    mTimer = GetTimeNow();
+    mRawFrameTime = 0.f;
+    mFrameStartNs = GetTimeNowNs();
 }
 
 double TimeManager::FrameTime() noexcept {
     return mFrameTime;
 }
 
+double TimeManager::RawFrameTime() const noexcept {
+    return mRawFrameTime;
+}
+
 double TimeManager::FramesPerSecond() noexcept {
     return mFPS;
 }
@@ -83,6 +123,61 @@ void TimeManager::ResetElapsed() noexcept {
     mElapsed = 0.f;
 }
 
-double TimeManager::GetSleepTime() const noexcept {
-    return mSleepTime;
+double TimeManager::GetIdleBudget() const noexcept {
+    return mIdleBudget;
+}
+
+void TimeManager::RecordPhase(FramePhase phase, uint64_t durationNs) {
+    mHistograms[static_cast<size_t>(phase)].Add(durationNs * 1.0e-6);
+}
+
+FrameTimeSummary TimeManager::GetFrameStats(FramePhase phase) const {
+    return mHistograms[static_cast<size_t>(phase)].Summarize();
+}
+
+void TimeManager::ResetFrameStats() {
+    for (auto & histogram : mHistograms)
+        histogram.Reset();
+    mJankFrames = 0;
+    mTotalFrames = 0;
+    mFramePacer.ResetStats();
+}
+
+void TimeManager::DumpFrameStats(std::string const & filePath) const {
+    FILE * ptrFile = nullptr;
+    if (!filePath.empty()) {
+        ptrFile = fopen(filePath.c_str(), "w");
+        if (!ptrFile) {
+            Log::error("TimeManager: can't write frame stats to %s", filePath.c_str());
+            return;
+        }
+    }
+
+    char line[160];
+    auto emit = [ptrFile, &line]() {
+        if (ptrFile)
+            fprintf(ptrFile, "%s\n", line);
+        else
+            Log::info("%s", line);
+    };
+
+    for (size_t phase = 0; phase < PHASE_COUNT; ++phase) {
+        FrameTimeSummary summary = mHistograms[phase].Summarize();
+        snprintf(line, sizeof(line), "%-6s p50 %6.2f  p95 %6.2f  p99 %6.2f  max %6.2f  mean %6.2f ms  (%u samples)",
+                 FramePhaseToStr(static_cast<FramePhase>(phase)),
+                 summary.p50Ms, summary.p95Ms, summary.p99Ms, summary.maxMs, summary.meanMs, summary.samples);
+        emit();
+    }
+
+    FramePacingStats pacing = mFramePacer.GetStats();
+    snprintf(line, sizeof(line), "jank   %u of %u frames over %.1fx %.2f ms",
+             mJankFrames, mTotalFrames, JANK_THRESHOLD, pacing.refreshPeriodMs);
+    emit();
+    snprintf(line, sizeof(line), "pacing jitter %.2f ms  max %.2f ms  missed vsyncs %u  (%s)",
+             pacing.jitterMs, pacing.maxJitterMs, pacing.missedVsyncs,
+             pacing.choreographer ? "choreographer" : "swap intervals");
+    emit();
+
+    if (ptrFile)
+        fclose(ptrFile);
 }
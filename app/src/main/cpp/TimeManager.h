@@ -1,7 +1,21 @@
 #pragma once
 
 #include <ctime>
+#include <cstdint>
+#include <array>
+#include <string>
 #include "Log.h"
+#include "FramePacer.h"
+#include "FrameHistogram.h"
+
+enum class FramePhase : uint8_t {
+    FRAME,
+    UPDATE,
+    DRAW,
+    COUNT
+};
+
+char const * FramePhaseToStr(FramePhase phase);
 
 class TimeManager
 {
@@ -18,24 +32,50 @@ public:
     TimeManager(TimeManager const &) = delete;
     TimeManager & operator=(TimeManager const &) = delete;
 
+    // Starts a frame: measures it against the display refresh and hands the time left before the frame's own work
+    // is due to the event queue, then to the IdleScheduler. There is no sleep, eglSwapBuffers blocks on vsync.
     void UpdateMainLoop();
+    // Call right before the frame is swapped, feeds the work time estimate used for the idle budget.
+    void MarkFrameSubmitted() noexcept;
 
     double GetTimeNow() const noexcept;
+    static uint64_t GetTimeNowNs() noexcept;
     void Reset() noexcept;
+    // Frame time snapped to whole refresh periods, for the simulation.
     double FrameTime() noexcept;
+    // Frame time as measured.
+    double RawFrameTime() const noexcept;
     double FramesPerSecond() noexcept;
     double GetElapsed() const noexcept;
     void ResetElapsed() noexcept;
-    double GetSleepTime() const noexcept;
+    double GetIdleBudget() const noexcept;
+
+    FramePacingStats GetPacingStats() const { return mFramePacer.GetStats(); }
+    void ResetPacingStats() { mFramePacer.ResetStats(); }
+
+    // FRAME is recorded by UpdateMainLoop, the sub-phases by whoever runs them.
+    void RecordPhase(FramePhase phase, uint64_t durationNs);
+    FrameTimeSummary GetFrameStats(FramePhase phase) const;
+    // Frames longer than 1.5 refresh periods since the last reset.
+    uint32_t GetJankCount() const noexcept { return mJankFrames; }
+    void ResetFrameStats();
+    // Writes the summary to filePath, or to the log when it is empty.
+    void DumpFrameStats(std::string const & filePath = std::string()) const;
 
 private:
+    static size_t const PHASE_COUNT = static_cast<size_t>(FramePhase::COUNT);
+
+    FramePacer mFramePacer;
+    std::array<FrameTimeHistogram, PHASE_COUNT> mHistograms;
+    uint32_t mJankFrames;
+    uint32_t mTotalFrames;
+    uint64_t mFrameStartNs;
+    uint64_t mWorkStartNs;
+    uint64_t mWorkTimeNs;
     double mElapsed;
-    double mLastGetTime;
-    double mTimer;
     double mFrameTime;
-    double mNowTime;
-    double mSleepTime;
+    double mRawFrameTime;
+    double mIdleBudget;
     double mFPS;
-    timespec mSleepTS;
 };
 
@@ -39,7 +39,7 @@ TouchState TapDetector::Detect(AInputEvent const * motion_event) {
                     float x = AMotionEvent_getX(motion_event, 0) - mDownX;
                     float y = AMotionEvent_getY(motion_event, 0) - mDownY;
                     if (x * x + y * y < TOUCH_SLOP * TOUCH_SLOP * mDPFactor) {
-                        Log::info("TapDetector: Tap detected");
+                        Log_info("TapDetector: Tap detected");
 //                        Events::EventManager::Get().QueueEvent(std::shared_ptr<Events::EventInputXY>(new Events::EventInputXY{{mDownX, mDownY}}));
                         return GESTURE_STATE_ACTION;
                     }
@@ -7,6 +7,7 @@
 
 int32_t const TAP_TIMEOUT = 180 * 1000000;
 int32_t const TOUCH_SLOP = 8;
+int32_t const PERF_HUD_TOGGLE_POINTERS = 3;
 
 enum {
     GESTURE_STATE_NONE = 0,
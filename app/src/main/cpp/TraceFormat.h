@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+//---------------------------------------------------------------------------------------------------------------------
+// Binary trace wire format, shared by Log (writer) and tools/TraceDecoder (reader). Keep it free of engine headers.
+//
+// File   : TRACE_MAGIC, uint16 TRACE_VERSION, then a stream of chunks
+// Chunk  : uint8 tag
+//          TRACE_CHUNK_FORMAT : uint16 formatId, uint16 length, char[length]          (format string, no terminator)
+//          TRACE_CHUNK_RECORD : uint64 timestampNs, uint16 formatId, uint8 thread,
+//                               uint8 size, uint8[size]                               (encoded arguments)
+// Arg    : uint8 TraceArgType, then the value (little endian, as laid out by the device)
+//          STRING is uint8 length followed by the bytes.
+//---------------------------------------------------------------------------------------------------------------------
+
+char const TRACE_MAGIC[4] = {'F', 'L', 'T', 'R'};
+uint16_t const TRACE_VERSION = 1;
+
+uint8_t const TRACE_CHUNK_FORMAT = 'F';
+uint8_t const TRACE_CHUNK_RECORD = 'R';
+
+size_t const TRACE_PAYLOAD_SIZE = 52;
+
+enum class TraceArgType : uint8_t {
+    INT32,
+    UINT32,
+    INT64,
+    UINT64,
+    DOUBLE,
+    STRING,
+    POINTER
+};
+
+struct TraceRecord {
+    uint64_t    timestampNs;
+    uint16_t    formatId;
+    uint8_t     thread;
+    uint8_t     size;
+    uint8_t     payload[TRACE_PAYLOAD_SIZE];
+};
+
+static_assert(sizeof(TraceRecord) == 64, "TraceRecord is expected to fill one cache line");
@@ -1,3 +1,6 @@
+#include <atomic>
+#include <cstring>
+
 #include <tinyxml2.h>
 
 #include "Ui.h"
@@ -5,9 +8,13 @@
 #include "GLState.h"
 #include "ResourceManager.h"
 #include "FlappyEngine.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
 
 
-Ui::Ui() {
+Ui::Ui() : mScoreActive {},
+           mScoreFinish {}
+{
     Events::EventListenerDelegate delegate;
     delegate = std::bind(&Ui::UpdateScoreDelegate, this, std::placeholders::_1);;
     Events::EventManager::Get().AddListener(delegate, Events::EventUpdateScore::sEventType);
@@ -52,27 +59,33 @@ void Ui::LoadResources(std::string const & uiFilePath) {
         std::string gameStateStr = ptrNodeString->Attribute("Type");
         GameState gameState = StrToGameState(gameStateStr);
 
-        auto textRenderer = std::shared_ptr<TextRenderer>(new TextRenderer);
-        auto resTextRenderersIt = mTextRenderers.emplace(std::make_pair(gameState, textRenderer));
-        if(!resTextRenderersIt.second) {
+        StateText stateText {};
+        stateText.ptrRenderer = std::shared_ptr<TextRenderer>(new TextRenderer);
+        stateText.dirty = true;
+        auto resStatesIt = mStates.emplace(std::make_pair(gameState, stateText));
+        if(!resStatesIt.second) {
             Log::error("Ui ERROR : Renderer for this state already exist");
             assert(false);
         }
         else {
-            resTextRenderersIt.first->second->Init(fontFile, fontSize);
+            resStatesIt.first->second.ptrRenderer->Init(fontFile, fontSize);
         }
     }
 
-    for(auto & textRenderer : mTextRenderers) {
-        std::vector<UiString> const & uiStrRef = ResourceManager::GetUiStrings(textRenderer.first);
-        for(auto const & uiStr: uiStrRef) {
+    for(auto & state : mStates) {
+        std::vector<UiString> & uiStrRef = ResourceManager::GetUiStrings(state.first);
+        for(auto & uiStr: uiStrRef) {
             FTString ftStr {};
-            ftStr.state = textRenderer.first;
-            textRenderer.second->CalcUiString(uiStr, ftStr);
-            mStringsMap.insert(std::make_pair(uiStr.name, ftStr));
+            ftStr.state = state.first;
+            state.second.ptrRenderer->CalcUiString(uiStr, ftStr);
+            auto itFTString = mStringsMap.insert(std::make_pair(uiStr.name, ftStr)).first;
+            mUiStrings.insert(std::make_pair(uiStr.name, &uiStr));
+            state.second.strings.push_back(&itFTString->second);
         }
     }
 
+    mScoreActive = FindNumberText("ScoreActive");
+    mScoreFinish = FindNumberText("ScoreFinish");
 
 }
 
@@ -80,67 +93,103 @@ void Ui::Update() {
 
 }
 
-void Ui::Draw() {
-    for(auto const & ftStr: mStringsMap) {
-        if(FlappyEngine::GetGameState() == ftStr.second.state) {
-            ftStr.second.Draw(mTextRenderers[FlappyEngine::GetGameState()]);
+void Ui::Draw(RenderPacket & packet) {
+    PROFILE_SCOPE("Ui::Draw");
+    auto itState = mStates.find(FlappyEngine::GetGameState());
+    if(itState == mStates.end())
+        return;
+
+    // Packets still in flight keep the batch they were given, so a dirty state gets a batch nobody else holds rather
+    // than an edit. Once the render thread lets go of an old one it is copied over again, which reuses its strings'
+    // buffers: after the first few updates rebuilding allocates nothing.
+    StateText & stateText = itState->second;
+    if(stateText.dirty) {
+        std::shared_ptr<TextBatch> ptrBatch;
+        for(auto const & ptrPooled : stateText.batchPool) {
+            if(ptrPooled.use_count() == 1) {
+                std::atomic_thread_fence(std::memory_order_acquire);
+                ptrBatch = ptrPooled;
+                break;
+            }
+        }
+        if(!ptrBatch) {
+            ptrBatch = std::make_shared<TextBatch>(stateText.strings.size());
+            stateText.batchPool.push_back(ptrBatch);
         }
+
+        for(size_t i = 0; i < stateText.strings.size(); ++i)
+            (*ptrBatch)[i] = *stateText.strings[i];
+        stateText.ptrBatch = std::move(ptrBatch);
+        stateText.dirty = false;
     }
-}
 
+    packet.BeginGpuPass(GpuPass::TEXT, RenderLayer::UI);
+    packet.PushTextBatch(RenderLayer::UI, *stateText.ptrRenderer, stateText.ptrBatch);
+    packet.EndGpuPass(GpuPass::TEXT, RenderLayer::UI);
+}
 
-void Ui::UpdateScoreDelegate(Events::IEventDataPtr ptrEvent) {
-    std::shared_ptr<Events::EventUpdateScore> ptrCastedEvent = std::static_pointer_cast<Events::EventUpdateScore>(ptrEvent);
 
-    auto resIt = mStringsMap.find("ScoreActive");
-    GameState strState {};
-    if(resIt != mStringsMap.end()) {
-        strState = resIt->second.state;
-        mStringsMap.erase(resIt);
-    }
-    else {
+void Ui::UpdateString(std::string const & name, std::string const & text) {
+    auto itFTString = mStringsMap.find(name);
+    auto itUiString = mUiStrings.find(name);
+    if(itFTString == mStringsMap.end() || itUiString == mUiStrings.end()) {
         Log::debug("UiString not found !");
         assert(false);
+        return;
     }
 
-    std::vector<UiString> & uiStrRefA = ResourceManager::GetUiStrings(strState);
-    for(auto & uiStr: uiStrRefA) {
+    UiString & uiStr = *itUiString->second;
+    if(uiStr.text == text)
+        return;
 
-        if(uiStr.name == "ScoreActive") {
-            uiStr.text = ptrCastedEvent->GetScore();
-            FTString ftStr{};
-            ftStr.state = strState;
-            mTextRenderers[strState]->CalcUiString(uiStr, ftStr);
-            mStringsMap.insert(std::make_pair(uiStr.name, ftStr));
-            break;
-        }
-    }
+    // In place: the layout cache only redoes the characters after the shared prefix, usually the last digit or two.
+    uiStr.text = text;
+    FTString & ftStr = itFTString->second;
+    StateText & stateText = mStates[ftStr.state];
+    stateText.ptrRenderer->CalcUiString(uiStr, ftStr);
+    stateText.dirty = true;
 }
 
-void Ui::FinalScoreDelegate(Events::IEventDataPtr ptrEvent) {
-    std::shared_ptr<Events::EventFinalScore> ptrCastedEvent = std::static_pointer_cast<Events::EventFinalScore>(ptrEvent);
-
-    auto resIt = mStringsMap.find("ScoreFinish");
-    GameState strState {};
-    if(resIt != mStringsMap.end()) {
-        strState = resIt->second.state;
-        mStringsMap.erase(resIt);
-    }
-    else {
+Ui::NumberText Ui::FindNumberText(std::string const & name) {
+    auto itFTString = mStringsMap.find(name);
+    auto itUiString = mUiStrings.find(name);
+    if(itFTString == mStringsMap.end() || itUiString == mUiStrings.end()) {
         Log::debug("UiString not found !");
         assert(false);
+        return {};
     }
 
-    std::vector<UiString> & uiStrRefF = ResourceManager::GetUiStrings(strState);
-    for(auto & uiStr: uiStrRefF) {
-        if(uiStr.name == "ScoreFinish") {
-            uiStr.text = ptrCastedEvent->GetScore();
-            FTString ftStr{};
-            ftStr.state = strState;
-            mTextRenderers[strState]->CalcUiString(uiStr, ftStr);
-            mStringsMap.insert(std::make_pair(uiStr.name, ftStr));
-            break;
-        }
-    }
+    // Room for the longest number up front, so updates never grow the text or its positions.
+    NumberText numberText {itUiString->second, &itFTString->second};
+    numberText.ptrUiString->text.reserve(UINT64_DECIMAL_DIGITS);
+    numberText.ptrFTString->text.reserve(UINT64_DECIMAL_DIGITS);
+    numberText.ptrFTString->positions.reserve(UINT64_DECIMAL_DIGITS);
+    return numberText;
+}
+
+void Ui::UpdateNumber(NumberText const & numberText, uint64_t value) {
+    if(!numberText.ptrUiString)
+        return;
+
+    char buffer[UINT64_DECIMAL_DIGITS];
+    size_t length = FormatUnsigned(value, buffer);
+    UiString & uiStr = *numberText.ptrUiString;
+    if(uiStr.text.size() == length && std::memcmp(uiStr.text.data(), buffer, length) == 0)
+        return;
+
+    uiStr.text.assign(buffer, length);
+    FTString & ftStr = *numberText.ptrFTString;
+    StateText & stateText = mStates[ftStr.state];
+    stateText.ptrRenderer->CalcNumber(uiStr, ftStr);
+    stateText.dirty = true;
+}
+
+void Ui::UpdateScoreDelegate(Events::IEventDataPtr ptrEvent) {
+    std::shared_ptr<Events::EventUpdateScore> ptrCastedEvent = std::static_pointer_cast<Events::EventUpdateScore>(ptrEvent);
+    UpdateNumber(mScoreActive, ptrCastedEvent->GetScore());
 }
 
+void Ui::FinalScoreDelegate(Events::IEventDataPtr ptrEvent) {
+    std::shared_ptr<Events::EventFinalScore> ptrCastedEvent = std::static_pointer_cast<Events::EventFinalScore>(ptrEvent);
+    UpdateNumber(mScoreFinish, ptrCastedEvent->GetScore());
+}
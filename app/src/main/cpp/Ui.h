@@ -8,14 +8,36 @@
 #include <glm/glm.hpp>
 
 #include "TextRenderer.h"
+#include "RenderPacket.h"
 #include "Utilities.h"
 #include "GameTypes.h"
 #include "Events.h"
 
+//---------------------------------------------------------------------------------------------------------------------
+// Ui
+// Text of the game states, laid out once on load. Each state's strings share a TextRenderer and are kept as one
+// retained TextBatch: a string update marks its state dirty, the batch is only rebuilt when a dirty state is drawn,
+// and drawing an unchanged state records one command without touching its strings.
+//---------------------------------------------------------------------------------------------------------------------
 class Ui {
 
 public:
-    using TextRendererMap = EnumKeyUnorderedMap<GameState, std::shared_ptr<TextRenderer>>;
+    // Strings of one game state.
+    struct StateText {
+        std::shared_ptr<TextRenderer>   ptrRenderer;
+        std::vector<FTString const *>   strings;    // into mStringsMap
+        TextBatchPtr                    ptrBatch;
+        std::vector<std::shared_ptr<TextBatch>> batchPool;  // every batch made so far, see Draw
+        bool                            dirty;
+    };
+
+    // A string that shows a number, resolved once on load.
+    struct NumberText {
+        UiString *  ptrUiString;
+        FTString *  ptrFTString;
+    };
+
+    using StateTextMap = EnumKeyUnorderedMap<GameState, StateText>;
 
 public:
     Ui();
@@ -24,12 +46,21 @@ public:
 
     void LoadResources(std::string const & uiFilePath);
     void Update();
-    void Draw();
+    void Draw(RenderPacket & packet);
 
     void UpdateScoreDelegate(Events::IEventDataPtr ptrEvent);
     void FinalScoreDelegate(Events::IEventDataPtr ptrEvent);
 
+private:
+    void UpdateString(std::string const & name, std::string const & text);
+    NumberText FindNumberText(std::string const & name);
+    // Formats and lays out value in place, allocation free.
+    void UpdateNumber(NumberText const & numberText, uint64_t value);
+
 private:
     std::unordered_map<std::string, FTString> mStringsMap;
-    TextRendererMap mTextRenderers;
+    std::unordered_map<std::string, UiString *> mUiStrings;    // into ResourceManager's lists, fixed after loading
+    StateTextMap mStates;
+    NumberText mScoreActive;
+    NumberText mScoreFinish;
 };
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+uint32_t const UTF8_REPLACEMENT_CHAR = 0xFFFD;
+
+// Decodes the UTF-8 sequence at ptr and moves ptr past it; ptr must be before end. A malformed, overlong or truncated
+// sequence gives UTF8_REPLACEMENT_CHAR and skips only its first byte, so a string decodes to the same code points
+// wherever it is read.
+inline uint32_t DecodeUtf8(char const *& ptr, char const * end) {
+    auto lead = static_cast<uint8_t>(*ptr++);
+    if (lead < 0x80)
+        return lead;
+
+    uint32_t code;
+    uint32_t minCode;
+    int32_t length;
+    if ((lead & 0xE0) == 0xC0) {
+        code = lead & 0x1Fu;
+        minCode = 0x80;
+        length = 1;
+    }
+    else if ((lead & 0xF0) == 0xE0) {
+        code = lead & 0x0Fu;
+        minCode = 0x800;
+        length = 2;
+    }
+    else if ((lead & 0xF8) == 0xF0) {
+        code = lead & 0x07u;
+        minCode = 0x10000;
+        length = 3;
+    }
+    else {
+        return UTF8_REPLACEMENT_CHAR;
+    }
+
+    if (end - ptr < length)
+        return UTF8_REPLACEMENT_CHAR;
+
+    for (int32_t i = 0; i < length; ++i) {
+        auto next = static_cast<uint8_t>(ptr[i]);
+        if ((next & 0xC0) != 0x80)
+            return UTF8_REPLACEMENT_CHAR;
+        code = code << 6 | (next & 0x3Fu);
+    }
+
+    if (code < minCode || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF))
+        return UTF8_REPLACEMENT_CHAR;
+
+    ptr += length;
+    return code;
+}
@@ -1,9 +1,56 @@
+#include <cstring>
+
 #include "Utilities.h"
 
+namespace {
+
+char const DIGIT_PAIRS[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+size_t CountDigits(uint64_t value) {
+    size_t digits = 1;
+    for (;;) {
+        if (value < 10) return digits;
+        if (value < 100) return digits + 1;
+        if (value < 1000) return digits + 2;
+        if (value < 10000) return digits + 3;
+        value /= 10000;
+        digits += 4;
+    }
+}
 
+}
+
+size_t FormatUnsigned(uint64_t value, char * ptrBuffer) {
+    size_t digits = CountDigits(value);
+    char * ptrOut = ptrBuffer + digits;
+    while (value >= 100) {
+        size_t pair = static_cast<size_t>(value % 100) * 2;
+        value /= 100;
+        ptrOut -= 2;
+        std::memcpy(ptrOut, DIGIT_PAIRS + pair, 2);
+    }
+    if (value >= 10) {
+        ptrOut -= 2;
+        std::memcpy(ptrOut, DIGIT_PAIRS + value * 2, 2);
+    }
+    else {
+        *--ptrOut = static_cast<char>('0' + value);
+    }
+    return digits;
+}
 
 void ParseStringWithPunct(std::string const &src,
-                          std::list<std::string> &dst) {
+                          std::vector<std::string> &dst) {
     std::string texName;
     for(auto const & c: src) {
         if(!ispunct(c))
@@ -13,6 +60,8 @@ void ParseStringWithPunct(std::string const &src,
             texName.clear();
         }
     }
+    if(!texName.empty())
+        dst.push_back(texName);
 }
 
 GameState StrToGameState(std::string const &src) {
@@ -6,7 +6,7 @@
 #include <functional>
 #include <cassert>
 #include <memory>
-#include <list>
+#include <vector>
 
 #include "Log.h"
 #include "GameTypes.h"
@@ -19,8 +19,14 @@ std::string to_string(T value) {
     return os.str();
 }
 
+size_t const UINT64_DECIMAL_DIGITS = 20;
+
+// Writes value in decimal into ptrBuffer, which must hold UINT64_DECIMAL_DIGITS chars; no terminating zero. Returns the
+// number of digits. Two digits per division, for scores and counters that change every frame.
+size_t FormatUnsigned(uint64_t value, char * ptrBuffer);
+
 void ParseStringWithPunct(std::string const &src,
-                          std::list<std::string> &dst);
+                          std::vector<std::string> &dst);
 
 GameState StrToGameState(std::string const &src);
 LayoutType StrToLayout(std::string const &src);
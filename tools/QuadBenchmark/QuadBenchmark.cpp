@@ -0,0 +1,99 @@
+// Host tool: times ExpandSpriteQuads against the glm::mat4 model matrix path SpriteRenderer used per sprite, and
+// checks that both put the corners in the same place.
+//
+// usage : QuadBenchmark [sprites] [rotated percent]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "SpriteQuad.h"
+
+size_t const DEFAULT_SPRITES = 4096;
+int const DEFAULT_ROTATED_PERCENT = 10;
+int const RUNS = 200;
+
+// What SpriteRenderer::DrawSprite computed before the quads were expanded on the CPU, applied to the unit quad.
+void ExpandWithMatrices(std::vector<SpriteInstance> const & sprites, std::vector<glm::vec2> & positions) {
+    glm::vec2 const corners[SPRITE_QUAD_VERTICES] = {{0.f, 0.f}, {1.f, 0.f}, {0.f, 1.f}, {1.f, 1.f}};
+
+    for (size_t i = 0; i < sprites.size(); ++i) {
+        SpriteInstance const & sprite = sprites[i];
+        glm::mat4 model;
+        model = glm::translate(model, glm::vec3(sprite.position, 0.0f));
+        model = glm::translate(model, glm::vec3(0.5f * sprite.size.x, 0.5f * sprite.size.y, 0.0f));
+        model = glm::rotate(model, sprite.rotateRadians, glm::vec3(0.0f, 0.0f, 1.0f));
+        model = glm::translate(model, glm::vec3(-0.5f * sprite.size.x, -0.5f * sprite.size.y, 0.0f));
+        model = glm::scale(model, glm::vec3(sprite.size, 1.0f));
+
+        for (size_t corner = 0; corner < SPRITE_QUAD_VERTICES; ++corner)
+            positions[i * SPRITE_QUAD_VERTICES + corner] = glm::vec2(model * glm::vec4(corners[corner], 0.f, 1.f));
+    }
+}
+
+template <typename Function>
+double BestOfNs(Function function) {
+    double best = 1e30;
+    for (int run = 0; run < RUNS; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char ** argv) {
+    size_t spriteCount = argc > 1 ? static_cast<size_t>(std::strtoul(argv[1], nullptr, 10)) : DEFAULT_SPRITES;
+    int rotatedPercent = argc > 2 ? std::atoi(argv[2]) : DEFAULT_ROTATED_PERCENT;
+    if (spriteCount == 0) {
+        std::fprintf(stderr, "usage : QuadBenchmark [sprites] [rotated percent]\n");
+        return 1;
+    }
+
+    // Screen sized scene: mostly unrotated columns, a few rotating birds.
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> coordinate(0.f, 1080.f);
+    std::uniform_real_distribution<float> extent(16.f, 400.f);
+    std::uniform_real_distribution<float> angle(-1.5f, 1.5f);
+    std::uniform_int_distribution<int> percent(0, 99);
+
+    std::vector<SpriteInstance> sprites(spriteCount);
+    for (auto & sprite : sprites) {
+        sprite.position = {coordinate(random), coordinate(random)};
+        sprite.size = {extent(random), extent(random)};
+        sprite.uvRect = {0.f, 0.f, 1.f, 1.f};
+        sprite.rotateRadians = percent(random) < rotatedPercent ? angle(random) : 0.f;
+        sprite.color[0] = sprite.color[1] = sprite.color[2] = sprite.color[3] = 255;
+    }
+
+    std::vector<glm::vec2> reference(spriteCount * SPRITE_QUAD_VERTICES);
+    std::vector<glm::vec2> positions(spriteCount * SPRITE_QUAD_VERTICES);
+    std::vector<SpriteVertexAttributes> attributes(spriteCount * SPRITE_QUAD_VERTICES);
+
+    double matrixNs = BestOfNs([&] { ExpandWithMatrices(sprites, reference); });
+    double kernelNs = BestOfNs([&] {
+        ExpandSpriteQuads(sprites.data(), sprites.size(), positions.data(), attributes.data());
+    });
+
+    float maxError {};
+    for (size_t i = 0; i < positions.size(); ++i) {
+        glm::vec2 delta = glm::abs(positions[i] - reference[i]);
+        maxError = std::max(maxError, std::max(delta.x, delta.y));
+    }
+
+    std::printf("sprites %zu, rotated %d%%, kernel %s\n", spriteCount, rotatedPercent, SpriteQuadKernelName());
+    std::printf("glm::mat4         %10.1f ns  %6.2f ns/sprite\n", matrixNs, matrixNs / spriteCount);
+    std::printf("ExpandSpriteQuads %10.1f ns  %6.2f ns/sprite  (%.1fx)\n",
+                kernelNs, kernelNs / spriteCount, matrixNs / kernelNs);
+    std::printf("max corner error  %g px\n", maxError);
+
+    return maxError < 1e-2f ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+// Host tool: lays out the kind of strings the HUD and the score rebuild every frame with LayoutText and reports strings
+// per second, kerning from the KerningTable against asking FreeType for every pair. Also checks the table against
+// FT_Get_Kerning for every printable ASCII pair.
+//
+// usage : TextLayoutBenchmark <font.ttf> [frames]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Kerning.h"
+#include "TextLayout.h"
+
+int const PIXEL_SIZE = 32;          // SDF_GLYPH_PIXEL_SIZE, the size FontAtlas lays out and kerns at
+uint32_t const FLAT_CHARS = 0x500;  // FONT_ATLAS_FLAT_CHARS
+int const DEFAULT_FRAMES = 20000;
+int const RUNS = 5;
+float const SCALE = 0.75f;          // a 24 pixel font
+
+struct Glyph {
+    uint32_t    index;
+    glm::vec2   size;
+    glm::vec2   bearing;
+};
+
+// Metrics the way FontAtlas::GetGlyph serves them once resident: a flat table, FreeType only on first use.
+class Glyphs {
+public:
+    Glyphs(FT_Face ptrFace, KerningTable const * ptrKerning) : mPtrFace {ptrFace},
+                                                                 mPtrKerning {ptrKerning},
+                                                                 mGlyphs(FLAT_CHARS),
+                                                                 mLoaded(FLAT_CHARS)
+    {}
+
+    Glyph const * GetGlyph(uint32_t code) {
+        if (code >= FLAT_CHARS)
+            code = '?';
+        if (!mLoaded[code]) {
+            Glyph & glyph = mGlyphs[code];
+            glyph.index = FT_Get_Char_Index(mPtrFace, code);
+            if (FT_Load_Glyph(mPtrFace, glyph.index, FT_LOAD_RENDER))
+                return nullptr;
+            glyph.size = {mPtrFace->glyph->bitmap.width, mPtrFace->glyph->bitmap.rows};
+            glyph.bearing = {mPtrFace->glyph->bitmap_left, mPtrFace->glyph->bitmap_top};
+            mLoaded[code] = true;
+        }
+        return &mGlyphs[code];
+    }
+
+    float GetKerning(uint32_t left, uint32_t right) const {
+        if (mPtrKerning)
+            return static_cast<float>(mPtrKerning->Find(left, right)) / 64.f;
+
+        FT_Vector delta {};
+        FT_Get_Kerning(mPtrFace, left, right, FT_KERNING_UNFITTED, &delta);
+        return static_cast<float>(delta.x) / 64.f;
+    }
+
+private:
+    FT_Face mPtrFace;
+    KerningTable const * mPtrKerning;
+    std::vector<Glyph> mGlyphs;
+    std::vector<bool> mLoaded;
+};
+
+// One frame of HUD text: the score as it ticks, the perf HUD lines, and a line heavy with kerning pairs.
+void FormatFrame(int frame, std::vector<std::string> & texts) {
+    char buffer[128];
+    std::snprintf(buffer, sizeof(buffer), "%d", frame / 30);
+    texts[0] = buffer;
+    std::snprintf(buffer, sizeof(buffer), "Best: %d", 120 + frame / 600);
+    texts[1] = buffer;
+    std::snprintf(buffer, sizeof(buffer), "fps %.1f  p50 %.2f  p99 %.2f ms",
+                  58.f + (frame % 20) * 0.1f, 16.6f + (frame % 7) * 0.01f, 18.f + (frame % 13) * 0.1f);
+    texts[2] = buffer;
+    std::snprintf(buffer, sizeof(buffer), "draws %d  binds %d  stream %d KB", 12 + frame % 3, 4, 40 + frame % 9);
+    texts[3] = buffer;
+    texts[4] = frame % 60 < 30 ? "AVAST! WAVE To TRY AGAIN" : "Tap To PLAY AVATAR";
+}
+
+template <typename Function>
+double BestOfNs(Function function) {
+    double best = 1e30;
+    for (int run = 0; run < RUNS; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    return best;
+}
+
+// Lays out frames of HUD text. Incremental keeps one layout per line like TextRenderer does per UiString name;
+// otherwise every string is laid out from scratch.
+double Run(Glyphs & glyphs, int frames, bool incremental, float & checksum) {
+    std::vector<std::string> texts(5);
+    std::vector<TextLayout> layouts(texts.size());
+    return BestOfNs([&] {
+        for (int frame = 0; frame < frames; ++frame) {
+            FormatFrame(frame, texts);
+            for (size_t line = 0; line < texts.size(); ++line) {
+                if (!incremental)
+                    layouts[line].codePoints.clear();
+                glm::vec4 bbox = LayoutText(texts[line], {10.f, 40.f * line}, 2, SCALE, glyphs, layouts[line]);
+                checksum += bbox.z - bbox.x;
+            }
+        }
+    });
+}
+
+int main(int argc, char ** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage : TextLayoutBenchmark <font.ttf> [frames]\n");
+        return 1;
+    }
+    int frames = argc > 2 ? std::atoi(argv[2]) : DEFAULT_FRAMES;
+
+    FT_Library ptrLibrary {};
+    FT_Face ptrFace {};
+    if (FT_Init_FreeType(&ptrLibrary) || FT_New_Face(ptrLibrary, argv[1], 0, &ptrFace)) {
+        std::fprintf(stderr, "can't open %s\n", argv[1]);
+        return 1;
+    }
+    FT_Set_Pixel_Sizes(ptrFace, 0, PIXEL_SIZE);
+
+    auto buildStart = std::chrono::steady_clock::now();
+    KerningTable kerning;
+    kerning.Build(ptrFace);
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+
+    int mismatches {};
+    int kernedPairs {};
+    for (uint32_t left = 32; left < 127; ++left) {
+        for (uint32_t right = 32; right < 127; ++right) {
+            FT_UInt leftIndex = FT_Get_Char_Index(ptrFace, left);
+            FT_UInt rightIndex = FT_Get_Char_Index(ptrFace, right);
+            FT_Vector delta {};
+            FT_Get_Kerning(ptrFace, leftIndex, rightIndex, FT_KERNING_UNFITTED, &delta);
+            kernedPairs += delta.x != 0;
+            mismatches += kerning.Find(leftIndex, rightIndex) != delta.x;
+        }
+    }
+
+    Glyphs tableGlyphs(ptrFace, &kerning);
+    Glyphs freeTypeGlyphs(ptrFace, nullptr);
+    float checksum {};
+    Run(tableGlyphs, 1, true, checksum);
+    Run(freeTypeGlyphs, 1, true, checksum);
+
+    double strings = frames * 5.0;
+    double tableNs = Run(tableGlyphs, frames, false, checksum);
+    double freeTypeNs = Run(freeTypeGlyphs, frames, false, checksum);
+    double incrementalNs = Run(tableGlyphs, frames, true, checksum);
+
+    std::printf("kerning table %zu pairs, %zu KB, built in %.2f ms\n",
+                kerning.GetSize(), kerning.GetSize() * (sizeof(uint32_t) + sizeof(int16_t)) / 1024, buildMs);
+    std::printf("printable ASCII pairs kerned %d, table mismatches %d\n", kernedPairs, mismatches);
+    std::printf("full layout, FT_Get_Kerning  %12.0f strings/s  %7.1f ns/string\n",
+                strings * 1e9 / freeTypeNs, freeTypeNs / strings);
+    std::printf("full layout, KerningTable    %12.0f strings/s  %7.1f ns/string  (%.1fx)\n",
+                strings * 1e9 / tableNs, tableNs / strings, freeTypeNs / tableNs);
+    std::printf("prefix reuse, KerningTable   %12.0f strings/s  %7.1f ns/string  (%.1fx)\n",
+                strings * 1e9 / incrementalNs, incrementalNs / strings, freeTypeNs / incrementalNs);
+    std::printf("checksum %g\n", checksum);
+
+    FT_Done_Face(ptrFace);
+    FT_Done_FreeType(ptrLibrary);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,382 @@
+// Host tool: converts a PNG to an ETC2 KTX with its mip chain, the form ResourceManager::LoadTexture prefers. Opaque
+// images become ETC2 RGB8, the rest ETC2 RGBA8 with EAC alpha. Every level is decoded back with DecodeEtc2, the CPU
+// fallback the game uses where the GPU has no ETC2, and its PSNR printed; --decoded writes level 0 as decoded.
+//
+// usage : TextureCompressor <in.png> <out.ktx> [--no-mips] [--decoded <out.png>]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <png.h>
+
+#include "Etc2.h"
+#include "Ktx.h"
+
+namespace {
+
+int32_t const ETC_MODIFIERS[8][4] = {{2, 8, -2, -8},
+                                     {5, 17, -5, -17},
+                                     {9, 29, -9, -29},
+                                     {13, 42, -13, -42},
+                                     {18, 60, -18, -60},
+                                     {24, 80, -24, -80},
+                                     {33, 106, -33, -106},
+                                     {47, 183, -47, -183}};
+
+int32_t const EAC_MODIFIERS[16][8] = {{-3, -6, -9, -15, 2, 5, 8, 14},
+                                      {-3, -7, -10, -13, 2, 6, 9, 12},
+                                      {-2, -5, -8, -13, 1, 4, 7, 12},
+                                      {-2, -4, -6, -13, 1, 3, 5, 12},
+                                      {-3, -6, -8, -12, 2, 5, 7, 11},
+                                      {-3, -7, -9, -11, 2, 6, 8, 10},
+                                      {-4, -7, -8, -11, 3, 6, 7, 10},
+                                      {-3, -5, -8, -11, 2, 4, 7, 10},
+                                      {-2, -6, -8, -10, 1, 5, 7, 9},
+                                      {-2, -5, -8, -10, 1, 4, 7, 9},
+                                      {-2, -4, -8, -10, 1, 3, 7, 9},
+                                      {-2, -5, -7, -10, 1, 4, 6, 9},
+                                      {-3, -4, -7, -10, 2, 3, 6, 9},
+                                      {-1, -2, -3, -10, 0, 1, 2, 9},
+                                      {-4, -6, -8, -9, 3, 5, 7, 8},
+                                      {-3, -5, -7, -9, 2, 4, 6, 8}};
+
+struct Image {
+    int32_t width;
+    int32_t height;
+    std::vector<uint8_t> rgba;
+};
+
+int32_t Clamp(int32_t value) {
+    return std::min(std::max(value, 0), 255);
+}
+
+void WriteBlock(uint64_t bits, uint8_t * ptrBlock) {
+    for (int32_t i = 7; i >= 0; --i) {
+        ptrBlock[i] = static_cast<uint8_t>(bits);
+        bits >>= 8;
+    }
+}
+
+// Best modifier table and pixel indices for a subblock around base; returns the squared error.
+struct SubblockFit {
+    int64_t     error;
+    int32_t     table;
+    int32_t     indices[8];
+};
+
+SubblockFit FitSubblock(uint8_t const (&pixels)[16][4], int32_t const (&members)[8], int32_t const (&base)[3]) {
+    SubblockFit best {std::numeric_limits<int64_t>::max(), 0, {}};
+    for (int32_t table = 0; table < 8; ++table) {
+        SubblockFit fit {0, table, {}};
+        for (int32_t m = 0; m < 8 && fit.error < best.error; ++m) {
+            uint8_t const * ptrPixel = pixels[members[m]];
+            int64_t pixelBest = std::numeric_limits<int64_t>::max();
+            for (int32_t index = 0; index < 4; ++index) {
+                int32_t modifier = ETC_MODIFIERS[table][index];
+                int64_t error {};
+                for (int32_t c = 0; c < 3; ++c) {
+                    int32_t diff = Clamp(base[c] + modifier) - ptrPixel[c];
+                    error += diff * diff;
+                }
+                if (error < pixelBest) {
+                    pixelBest = error;
+                    fit.indices[m] = index;
+                }
+            }
+            fit.error += pixelBest;
+        }
+        if (fit.error < best.error)
+            best = fit;
+    }
+    return best;
+}
+
+// ETC1 compatible modes only, individual and differential, both flips; a valid ETC2 block.
+void EncodeRgbBlock(uint8_t const (&pixels)[16][4], uint8_t * ptrBlock) {
+    int64_t bestError = std::numeric_limits<int64_t>::max();
+    uint64_t bestBits {};
+
+    for (int32_t flip = 0; flip < 2; ++flip) {
+        // Pixels of each subblock, as x * 4 + y indices of the pixel index bits and y * 4 + x into pixels.
+        int32_t members[2][8];
+        int32_t bitIndex[2][8];
+        int32_t counts[2] = {};
+        for (int32_t x = 0; x < 4; ++x) {
+            for (int32_t y = 0; y < 4; ++y) {
+                int32_t subblock = flip ? y / 2 : x / 2;
+                members[subblock][counts[subblock]] = y * 4 + x;
+                bitIndex[subblock][counts[subblock]++] = x * 4 + y;
+            }
+        }
+
+        float average[2][3] = {};
+        for (int32_t s = 0; s < 2; ++s) {
+            for (int32_t m = 0; m < 8; ++m) {
+                for (int32_t c = 0; c < 3; ++c)
+                    average[s][c] += pixels[members[s][m]][c] / 8.f;
+            }
+        }
+
+        for (int32_t differential = 0; differential < 2; ++differential) {
+            int32_t quantized[2][3];
+            int32_t base[2][3];
+            bool fits = true;
+            for (int32_t s = 0; s < 2; ++s) {
+                for (int32_t c = 0; c < 3; ++c) {
+                    if (differential) {
+                        quantized[s][c] = static_cast<int32_t>(std::lround(average[s][c] * 31.f / 255.f));
+                        base[s][c] = quantized[s][c] << 3 | quantized[s][c] >> 2;
+                    }
+                    else {
+                        quantized[s][c] = static_cast<int32_t>(std::lround(average[s][c] * 15.f / 255.f));
+                        base[s][c] = quantized[s][c] << 4 | quantized[s][c];
+                    }
+                }
+            }
+            for (int32_t c = 0; differential && c < 3; ++c) {
+                int32_t delta = quantized[1][c] - quantized[0][c];
+                fits = fits && delta >= -4 && delta <= 3;
+            }
+            if (!fits)
+                continue;
+
+            SubblockFit fits2[2] = {FitSubblock(pixels, members[0], base[0]), FitSubblock(pixels, members[1], base[1])};
+            int64_t error = fits2[0].error + fits2[1].error;
+            if (error >= bestError)
+                continue;
+
+            uint64_t bits {};
+            for (int32_t c = 0; c < 3; ++c) {
+                if (differential) {
+                    int32_t delta = (quantized[1][c] - quantized[0][c]) & 7;
+                    bits |= static_cast<uint64_t>(quantized[0][c]) << (59 - c * 8);
+                    bits |= static_cast<uint64_t>(delta) << (56 - c * 8);
+                }
+                else {
+                    bits |= static_cast<uint64_t>(quantized[0][c]) << (60 - c * 8);
+                    bits |= static_cast<uint64_t>(quantized[1][c]) << (56 - c * 8);
+                }
+            }
+            bits |= static_cast<uint64_t>(fits2[0].table) << 37;
+            bits |= static_cast<uint64_t>(fits2[1].table) << 34;
+            bits |= static_cast<uint64_t>(differential) << 33;
+            bits |= static_cast<uint64_t>(flip) << 32;
+            for (int32_t s = 0; s < 2; ++s) {
+                for (int32_t m = 0; m < 8; ++m) {
+                    int32_t index = fits2[s].indices[m];
+                    bits |= static_cast<uint64_t>(index >> 1) << (16 + bitIndex[s][m]);
+                    bits |= static_cast<uint64_t>(index & 1) << bitIndex[s][m];
+                }
+            }
+            bestError = error;
+            bestBits = bits;
+        }
+    }
+    WriteBlock(bestBits, ptrBlock);
+}
+
+void EncodeAlphaBlock(uint8_t const (&pixels)[16][4], uint8_t * ptrBlock) {
+    int32_t minAlpha = 255;
+    int32_t maxAlpha = 0;
+    for (auto const & pixel : pixels) {
+        minAlpha = std::min<int32_t>(minAlpha, pixel[3]);
+        maxAlpha = std::max<int32_t>(maxAlpha, pixel[3]);
+    }
+
+    // For each table and multiplier, the base that centres the modifiers on the block's range and its neighbours.
+    int64_t bestError = std::numeric_limits<int64_t>::max();
+    uint64_t bestBits {};
+    for (int32_t table = 0; table < 16 && bestError > 0; ++table) {
+        int32_t const * ptrModifiers = EAC_MODIFIERS[table];
+        int32_t modifierMin = *std::min_element(ptrModifiers, ptrModifiers + 8);
+        int32_t modifierMax = *std::max_element(ptrModifiers, ptrModifiers + 8);
+        for (int32_t multiplier = 1; multiplier < 16; ++multiplier) {
+            int32_t centre = (minAlpha + maxAlpha - (modifierMin + modifierMax) * multiplier) / 2;
+            for (int32_t base = centre - 1; base <= centre + 1; ++base) {
+                if (base < 0 || base > 255)
+                    continue;
+                int64_t error {};
+                uint64_t indices {};
+                for (int32_t x = 0; x < 4 && error < bestError; ++x) {
+                    for (int32_t y = 0; y < 4; ++y) {
+                        int32_t alpha = pixels[y * 4 + x][3];
+                        int32_t pixelBest = std::numeric_limits<int32_t>::max();
+                        int32_t pixelIndex {};
+                        for (int32_t index = 0; index < 8; ++index) {
+                            int32_t diff = Clamp(base + ptrModifiers[index] * multiplier) - alpha;
+                            if (diff * diff < pixelBest) {
+                                pixelBest = diff * diff;
+                                pixelIndex = index;
+                            }
+                        }
+                        error += pixelBest;
+                        indices |= static_cast<uint64_t>(pixelIndex) << (45 - (x * 4 + y) * 3);
+                    }
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    bestBits = static_cast<uint64_t>(base) << 56 | static_cast<uint64_t>(multiplier) << 52 |
+                               static_cast<uint64_t>(table) << 48 | indices;
+                }
+            }
+        }
+    }
+    WriteBlock(bestBits, ptrBlock);
+}
+
+std::vector<uint8_t> EncodeLevel(Image const & image, bool alpha) {
+    std::vector<uint8_t> blocks(CompressedLevelSize(alpha ? KTX_ETC2_RGBA8_EAC : KTX_ETC2_RGB8,
+                                                    image.width,
+                                                    image.height));
+    uint8_t * ptrBlock = blocks.data();
+    for (int32_t blockY = 0; blockY < image.height; blockY += 4) {
+        for (int32_t blockX = 0; blockX < image.width; blockX += 4) {
+            // Blocks over the edge repeat the last row and column.
+            uint8_t pixels[16][4];
+            for (int32_t y = 0; y < 4; ++y) {
+                for (int32_t x = 0; x < 4; ++x) {
+                    int32_t sourceX = std::min(blockX + x, image.width - 1);
+                    int32_t sourceY = std::min(blockY + y, image.height - 1);
+                    std::memcpy(pixels[y * 4 + x], &image.rgba[(static_cast<size_t>(sourceY) * image.width + sourceX) * 4], 4);
+                }
+            }
+            if (alpha) {
+                EncodeAlphaBlock(pixels, ptrBlock);
+                ptrBlock += 8;
+            }
+            EncodeRgbBlock(pixels, ptrBlock);
+            ptrBlock += 8;
+        }
+    }
+    return blocks;
+}
+
+// Box filtered half size, the last row or column of an odd size folds into its neighbour.
+Image HalfSize(Image const & image) {
+    Image half {std::max(image.width / 2, 1), std::max(image.height / 2, 1), {}};
+    half.rgba.resize(static_cast<size_t>(half.width) * half.height * 4);
+    for (int32_t y = 0; y < half.height; ++y) {
+        for (int32_t x = 0; x < half.width; ++x) {
+            for (int32_t c = 0; c < 4; ++c) {
+                int32_t sum {};
+                for (int32_t dy = 0; dy < 2; ++dy) {
+                    for (int32_t dx = 0; dx < 2; ++dx) {
+                        int32_t sourceX = std::min(x * 2 + dx, image.width - 1);
+                        int32_t sourceY = std::min(y * 2 + dy, image.height - 1);
+                        sum += image.rgba[(static_cast<size_t>(sourceY) * image.width + sourceX) * 4 + c];
+                    }
+                }
+                half.rgba[(static_cast<size_t>(y) * half.width + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+            }
+        }
+    }
+    return half;
+}
+
+double Psnr(std::vector<uint8_t> const & a, std::vector<uint8_t> const & b, bool alpha) {
+    double error {};
+    size_t samples {};
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (!alpha && i % 4 == 3)
+            continue;
+        double diff = static_cast<double>(a[i]) - b[i];
+        error += diff * diff;
+        ++samples;
+    }
+    if (error == 0.0)
+        return std::numeric_limits<double>::infinity();
+    return 10.0 * std::log10(255.0 * 255.0 * samples / error);
+}
+
+bool ReadPng(char const * path, Image & image) {
+    png_image png {};
+    png.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_file(&png, path))
+        return false;
+    png.format = PNG_FORMAT_RGBA;
+    image.width = static_cast<int32_t>(png.width);
+    image.height = static_cast<int32_t>(png.height);
+    image.rgba.resize(PNG_IMAGE_SIZE(png));
+    return png_image_finish_read(&png, nullptr, image.rgba.data(), 0, nullptr) != 0;
+}
+
+bool WritePng(char const * path, Image const & image) {
+    png_image png {};
+    png.version = PNG_IMAGE_VERSION;
+    png.width = static_cast<png_uint_32>(image.width);
+    png.height = static_cast<png_uint_32>(image.height);
+    png.format = PNG_FORMAT_RGBA;
+    return png_image_write_to_file(&png, path, 0, image.rgba.data(), 0, nullptr) != 0;
+}
+
+}
+
+int main(int argc, char ** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage : TextureCompressor <in.png> <out.ktx> [--no-mips] [--decoded <out.png>]\n");
+        return 1;
+    }
+    bool mips = true;
+    char const * decodedPath = nullptr;
+    for (int arg = 3; arg < argc; ++arg) {
+        if (std::strcmp(argv[arg], "--no-mips") == 0)
+            mips = false;
+        else if (std::strcmp(argv[arg], "--decoded") == 0 && arg + 1 < argc)
+            decodedPath = argv[++arg];
+    }
+
+    Image image {};
+    if (!ReadPng(argv[1], image)) {
+        std::fprintf(stderr, "can't read %s\n", argv[1]);
+        return 1;
+    }
+
+    bool alpha = false;
+    for (size_t i = 3; i < image.rgba.size(); i += 4)
+        alpha = alpha || image.rgba[i] != 255;
+    uint32_t format = alpha ? KTX_ETC2_RGBA8_EAC : KTX_ETC2_RGB8;
+
+    std::vector<std::vector<uint8_t>> levels;
+    size_t rawBytes {};
+    Image level = image;
+    while (true) {
+        levels.push_back(EncodeLevel(level, alpha));
+        rawBytes += level.rgba.size();
+
+        std::vector<uint8_t> decoded;
+        DecodeEtc2(format, levels.back().data(), levels.back().size(), level.width, level.height, decoded);
+        std::printf("level %zu %4dx%-4d %7zu bytes  PSNR %.2f dB\n",
+                    levels.size() - 1, level.width, level.height, levels.back().size(),
+                    Psnr(level.rgba, decoded, alpha));
+        if (decodedPath && levels.size() == 1 && !WritePng(decodedPath, {level.width, level.height, decoded}))
+            std::fprintf(stderr, "can't write %s\n", decodedPath);
+
+        if (!mips || (level.width == 1 && level.height == 1))
+            break;
+        level = HalfSize(level);
+    }
+
+    std::vector<uint8_t> file = BuildKtx(format, alpha ? KTX_BASE_RGBA : KTX_BASE_RGB, image.width, image.height, levels);
+    KtxImage check {};
+    if (!ParseKtx(file, check)) {
+        std::fprintf(stderr, "built KTX doesn't parse\n");
+        return 1;
+    }
+
+    FILE * ptrFile = std::fopen(argv[2], "wb");
+    if (!ptrFile || std::fwrite(file.data(), 1, file.size(), ptrFile) != file.size()) {
+        std::fprintf(stderr, "can't write %s\n", argv[2]);
+        return 1;
+    }
+    std::fclose(ptrFile);
+
+    std::printf("%s %s, %zu levels, %zu bytes, RGBA8 with the same mips %zu bytes (%.1fx)\n",
+                argv[2], alpha ? "ETC2 RGBA8 EAC" : "ETC2 RGB8", levels.size(), file.size(), rawBytes,
+                static_cast<double>(rawBytes) / file.size());
+    return 0;
+}
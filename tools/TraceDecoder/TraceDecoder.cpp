@@ -0,0 +1,264 @@
+// Host tool: turns a binary trace written by Log::StartTrace back into text.
+//
+// usage : TraceDecoder <trace.bin> [output.txt]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <fstream>
+#include <iterator>
+
+#include "TraceFormat.h"
+
+class TraceReader {
+public:
+    explicit TraceReader(std::vector<uint8_t> const & data) : mData(data), mPos {0}
+    {}
+
+    bool Read(void * pDst, size_t size) {
+        if (mPos + size > mData.size())
+            return false;
+        memcpy(pDst, mData.data() + mPos, size);
+        mPos += size;
+        return true;
+    }
+
+    template <typename T>
+    bool Read(T & value) { return Read(&value, sizeof(T)); }
+
+    bool AtEnd() const { return mPos >= mData.size(); }
+    size_t GetPos() const { return mPos; }
+
+private:
+    std::vector<uint8_t> const & mData;
+    size_t mPos;
+};
+
+struct DecodedRecord {
+    uint64_t timestampNs;
+    uint16_t formatId;
+    uint8_t thread;
+    std::vector<uint8_t> payload;
+};
+
+static bool IsConversion(char c) {
+    return strchr("diouxXeEfFgGaAcsp", c) != nullptr;
+}
+
+static bool IsIntConversion(char c) {
+    return strchr("diouxXc", c) != nullptr;
+}
+
+// Formats one argument with the flags/width/precision of the original specifier, ignoring its length modifier:
+// the recorded type tag is authoritative.
+static void AppendArg(std::string & out, std::string const & flags, char conversion,
+                      std::vector<uint8_t> const & payload, size_t & pos) {
+    char buffer[512];
+    if (pos >= payload.size()) {
+        out += "<missing>";
+        return;
+    }
+
+    auto type = static_cast<TraceArgType>(payload[pos++]);
+    std::string spec = "%" + flags;
+
+    auto readValue = [&payload, &pos](void * pDst, size_t size) {
+        if (pos + size > payload.size()) {
+            memset(pDst, 0, size);
+            pos = payload.size();
+            return;
+        }
+        memcpy(pDst, payload.data() + pos, size);
+        pos += size;
+    };
+
+    switch (type) {
+        case TraceArgType::INT32:
+        case TraceArgType::INT64:
+        case TraceArgType::UINT32:
+        case TraceArgType::UINT64: {
+            long long value = 0;
+            if (type == TraceArgType::INT32) { int32_t v; readValue(&v, sizeof(v)); value = v; }
+            if (type == TraceArgType::INT64) { int64_t v; readValue(&v, sizeof(v)); value = v; }
+            if (type == TraceArgType::UINT32) { uint32_t v; readValue(&v, sizeof(v)); value = static_cast<long long>(v); }
+            if (type == TraceArgType::UINT64) { uint64_t v; readValue(&v, sizeof(v)); value = static_cast<long long>(v); }
+
+            if (IsIntConversion(conversion)) {
+                spec += conversion == 'c' ? "c" : std::string("ll") + conversion;
+                snprintf(buffer, sizeof(buffer), spec.c_str(), value);
+            }
+            else if (conversion == 's' || conversion == 'p') {
+                snprintf(buffer, sizeof(buffer), "%lld", value);
+            }
+            else {
+                spec += conversion;
+                snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<double>(value));
+            }
+            break;
+        }
+
+        case TraceArgType::DOUBLE: {
+            double value = 0.0;
+            readValue(&value, sizeof(value));
+            if (IsIntConversion(conversion)) {
+                spec += std::string("ll") + conversion;
+                snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<long long>(value));
+            }
+            else if (conversion == 's' || conversion == 'p') {
+                snprintf(buffer, sizeof(buffer), "%f", value);
+            }
+            else {
+                spec += conversion;
+                snprintf(buffer, sizeof(buffer), spec.c_str(), value);
+            }
+            break;
+        }
+
+        case TraceArgType::STRING: {
+            uint8_t length = 0;
+            readValue(&length, sizeof(length));
+            std::string value(length, '\0');
+            readValue(&value[0], length);
+            spec += 's';
+            snprintf(buffer, sizeof(buffer), spec.c_str(), value.c_str());
+            break;
+        }
+
+        case TraceArgType::POINTER: {
+            uint64_t value = 0;
+            readValue(&value, sizeof(value));
+            snprintf(buffer, sizeof(buffer), "0x%llx", static_cast<unsigned long long>(value));
+            break;
+        }
+
+        default:
+            snprintf(buffer, sizeof(buffer), "<bad arg type %u>", static_cast<uint32_t>(type));
+            pos = payload.size();
+            break;
+    }
+
+    out += buffer;
+}
+
+static std::string FormatRecord(std::string const & format, std::vector<uint8_t> const & payload) {
+    std::string out;
+    size_t pos = 0;
+
+    for (size_t i = 0; i < format.size(); ++i) {
+        if (format[i] != '%') {
+            out += format[i];
+            continue;
+        }
+        if (i + 1 < format.size() && format[i + 1] == '%') {
+            out += '%';
+            ++i;
+            continue;
+        }
+
+        std::string flags;
+        size_t j = i + 1;
+        for (; j < format.size() && !IsConversion(format[j]); ++j) {
+            if (strchr("hljztL", format[j]) == nullptr)
+                flags += format[j];
+        }
+        if (j == format.size()) {
+            out += format.substr(i);
+            break;
+        }
+
+        AppendArg(out, flags, format[j], payload, pos);
+        i = j;
+    }
+
+    return out;
+}
+
+int main(int argc, char ** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage : %s <trace.bin> [output.txt]\n", argv[0]);
+        return 1;
+    }
+
+    std::ifstream input(argv[1], std::ios::binary);
+    if (!input) {
+        fprintf(stderr, "can't open %s\n", argv[1]);
+        return 1;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    TraceReader reader(data);
+    char magic[sizeof(TRACE_MAGIC)];
+    uint16_t version = 0;
+    if (!reader.Read(magic, sizeof(magic)) || memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0 ||
+        !reader.Read(version) || version != TRACE_VERSION) {
+        fprintf(stderr, "%s is not a trace file of version %u\n", argv[1], TRACE_VERSION);
+        return 1;
+    }
+
+    std::unordered_map<uint16_t, std::string> formats;
+    std::vector<DecodedRecord> records;
+
+    while (!reader.AtEnd()) {
+        uint8_t tag = 0;
+        reader.Read(tag);
+
+        if (tag == TRACE_CHUNK_FORMAT) {
+            uint16_t formatId = 0;
+            uint16_t length = 0;
+            std::string format;
+            if (!reader.Read(formatId) || !reader.Read(length))
+                break;
+            format.resize(length);
+            if (length && !reader.Read(&format[0], length))
+                break;
+            formats[formatId] = format;
+        }
+        else if (tag == TRACE_CHUNK_RECORD) {
+            DecodedRecord record;
+            uint8_t size = 0;
+            if (!reader.Read(record.timestampNs) || !reader.Read(record.formatId) ||
+                !reader.Read(record.thread) || !reader.Read(size))
+                break;
+            record.payload.resize(size);
+            if (size && !reader.Read(record.payload.data(), size))
+                break;
+            records.push_back(std::move(record));
+        }
+        else {
+            fprintf(stderr, "corrupted chunk at offset %zu\n", reader.GetPos() - 1);
+            break;
+        }
+    }
+
+    FILE * ptrOutput = argc > 2 ? fopen(argv[2], "w") : stdout;
+    if (!ptrOutput) {
+        fprintf(stderr, "can't open %s\n", argv[2]);
+        return 1;
+    }
+
+    // Records are drained ring by ring, so threads come out in batches.
+    std::stable_sort(records.begin(), records.end(), [](DecodedRecord const & a, DecodedRecord const & b) {
+        return a.timestampNs < b.timestampNs;
+    });
+    uint64_t startNs = records.empty() ? 0 : records.front().timestampNs;
+
+    for (auto const & record : records) {
+        auto formatIt = formats.find(record.formatId);
+        std::string text = formatIt != formats.end() ? FormatRecord(formatIt->second, record.payload)
+                                                     : "<unknown format " + std::to_string(record.formatId) + ">";
+        fprintf(ptrOutput, "[%12.6f] T%-2u %s\n",
+                static_cast<double>(record.timestampNs - startNs) * 1.0e-9,
+                static_cast<uint32_t>(record.thread),
+                text.c_str());
+    }
+
+    if (ptrOutput != stdout)
+        fclose(ptrOutput);
+
+    fprintf(stderr, "%zu formats, %zu records\n", formats.size(), records.size());
+    return 0;
+}